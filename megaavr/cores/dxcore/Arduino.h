@@ -476,6 +476,15 @@ have ports shoulod have those Px constants defined as NOT_A_PORT. I think that w
 // Returned by analogClockSpeed if the value in the register is currently unknown, or if an invalid frequency is requested.
 
 
+// trigger argument to analogCaptureStart(): start counting right away, when an AC's CMPIF flag is set, or when a
+// pin reads HIGH or LOW. The triggers are only looked for once the buffer has been filled.
+#define ADC_CAPTURE_NOW                             (0xFF)
+#define ADC_CAPTURE_AC0                             (0xF0)
+#define ADC_CAPTURE_AC1                             (0xF1)
+#define ADC_CAPTURE_AC2                             (0xF2)
+#define ADC_CAPTURE_HIGH(pin)                       (pin)
+#define ADC_CAPTURE_LOW(pin)                        ((pin) | 0x80)
+
 // only returned by analogCheckError()
 #define ADC_IMPOSSIBLE_VALUE                        (-127)
 
@@ -590,11 +599,41 @@ void takeOverTCA1();                         // Can be used to tell core not to
 void takeOverTCD0();                         // Can be used to tell core not to use TCD0 for any API calls - user has taken it over.
 void resumeTCA0();                           // Restores core-mediated functionality that uses TCA0 and restores default TCA0 configuration.
 void resumeTCA1();                           // Restores core-mediated functionality that uses TCA1 and restores default TCA1 configuration.
+// For libraries that run a TCB of their own, or clock one from TCA0: whether a TCB is the millis timer, and the prescaler a TCA's CTRLA selects.
+inline __attribute__((always_inline)) bool _isMillisTCB(TCB_t *timer) {
+  #if defined(MILLIS_USE_TIMERB0)
+    return timer == &TCB0;
+  #elif defined(MILLIS_USE_TIMERB1)
+    return timer == &TCB1;
+  #elif defined(MILLIS_USE_TIMERB2)
+    return timer == &TCB2;
+  #elif defined(MILLIS_USE_TIMERB3)
+    return timer == &TCB3;
+  #elif defined(MILLIS_USE_TIMERB4)
+    return timer == &TCB4;
+  #else
+    (void) timer;
+    return false;
+  #endif
+}
+inline __attribute__((always_inline)) uint8_t _tcaPrescaleShift(uint8_t ctrla) { // log2 of DIV1, 2, 4, 8, 16, 64, 256, 1024
+  uint8_t clksel = (ctrla & TCA_SINGLE_CLKSEL_gm) >> 1;
+  return (clksel < 5) ? clksel : (clksel << 1) - 4;
+}
+
+// Runtime clock changes - see Ref_Clocks.md. F_CPU remains the frequency everything was calculated for at startup.
+extern uint32_t __CPUFrequency;
+extern uint16_t __CPUFrequencyScale;
+uint8_t setCPUFrequency(uint32_t hz);        // Change the system clock, rescaling millis, USARTs, Wire and delayMicroseconds(). Returns 0 on success, 1 if unachievable, 2 if millis can't keep time at that speed.
+inline __attribute__((always_inline)) uint32_t getCPUFrequency() { // Current system clock; F_CPU unless setCPUFrequency() changed it.
+  return __CPUFrequency;
+}
 // bool digitalPinHasPWM(uint8_t p);         // Macro. Returns true if the pin can currently output PWM using analogWrite(), regardless of which timer is used and considering current PORTMUX setting
 uint8_t digitalPinToTimerNow(uint8_t p);     // Returns the timer that is associated with the pin now (considering PORTMUX)
 
 // These are in here so that - should it be necessary - library functions or user code could override these.
 void init_clock()     __attribute__((weak)); // this is called first, to initialize the system clock.
+void init_clock_tune() __attribute__((weak)); // called by init_clock() when using the internal oscillator. Default does nothing; the DxCore library applies a stored OSCHFTUNE value.
 void init_ADC0()      __attribute__((weak)); // this is called to initialize ADC0
 //   init_DAC0()                             // no _init_DAC0() - all that the core does is call DACReference().
 void init_TCA0()      __attribute__((weak)); // called by init_timers() - without this, pins that give PWM from TCA0 will not function.
@@ -605,6 +644,7 @@ void init_millis()    __attribute__((weak)); // called by init() after everythin
 
 void onClockFailure() __attribute__((weak)); // called by the clock failure detection ISR. Default action is a blink code with 4 blinks.
 void onClockTimeout() __attribute__((weak)); // called if we try to switch to external clock, but it doesn't work. Default action is a blink code with 3 blinks.
+void onClockChange(uint32_t oldfreq, uint32_t newfreq) __attribute__((weak)); // called by setCPUFrequency() after it has changed the clock. Default action is nothing.
 
 #ifndef CORE_ATTACH_OLD
 // The old attachInterrupt did not require any calls to be made to enable a port.
@@ -618,6 +658,10 @@ void onClockTimeout() __attribute__((weak)); // called if we try to switch to ex
   void attachPortFEnable();
   void attachPortGEnable();
 #endif
+// Like attachInterrupt(), but promises that the handler changes no registers other than r24-r27, r30, r31 and SREG.
+// With CORE_ATTACH_FASTDISPATCH defined, such a handler is called without saving the other call-used registers.
+// Otherwise it is identical to attachInterrupt().
+void attachInterruptLean(uint8_t pin, void (*userFunc)(void), uint8_t mode);
 
 // ANALOG EXTENDED FUNCTIONS
 // Covered in documentation.
@@ -629,7 +673,39 @@ bool       analogReadResolution(uint8_t res);
 bool       analogSampleDuration(uint8_t dur);
 void               DACReference(uint8_t mode);
 
+// Back-to-back conversions into a buffer. Return the sample rate, or a negative ADC_ENH_ERROR.
+int32_t      analogCaptureBurst(uint8_t pin, uint16_t *buf, uint16_t n, uint32_t rate);
+int32_t      analogCaptureStart(uint8_t pin, uint16_t *buf, uint16_t n, uint32_t rate, uint8_t trigger, uint16_t post);
+bool          analogCaptureDone();
+uint16_t    analogCaptureOldest();
+void          analogCaptureStop();
+
+// The ADC queue: background users of the ADC, and analogRead(), take turns. See Ref_Analog.md.
+#define ADC_REQUEST_IDLE      0
+#define ADC_REQUEST_QUEUED    1
+#define ADC_REQUEST_RUNNING   2
+#define ADC_REQUEST_DONE      3
+#define ADC_REQUEST_REF(ref)  ((ref) | 0x80)  // for analogRequest_t.ref: use this reference (INTERNAL2V048, etc)
+typedef struct analogRequest_s analogRequest_t;
+struct analogRequest_s {
+  analogRequest_t   *next;                            // used by the queue
+  uint8_t            muxpos;                          // ADC0.MUXPOS - the channel
+  uint8_t            muxneg;                          // ADC0.MUXNEG, for differential conversions
+  uint8_t            ctrla;                           // ADC0.CTRLA - resolution, CONVMODE, LEFTADJ. ENABLE is added.
+  uint8_t            ctrlb;                           // ADC0.CTRLB - accumulation
+  uint8_t            sampctrl;                        // ADC0.SAMPCTRL - sample duration
+  uint8_t            ref;                             // 0 for the analogReference() one, or ADC_REQUEST_REF(reference)
+  volatile uint8_t   status;                          // ADC_REQUEST_ value; must start out ADC_REQUEST_IDLE (0)
+  volatile uint16_t  result;                          // ADC0.RES, once status is ADC_REQUEST_DONE
+  uint8_t          (*callback)(analogRequest_t *req); // from the interrupt when done. Return non-zero to go again.
+};
+bool           analogQueue(analogRequest_t *req, bool first);
+void         analogDequeue(analogRequest_t *req);
+
 uint8_t      getAnalogReference();
+uint8_t  _getAnalogReferenceReg();           // VREF.ADC0REF as analogRead() uses it, ALWAYSON included - for saving it
+void     _setAnalogReferenceReg(uint8_t reg); // and putting it back.
+int16_t  _analogTempToCelsius(uint16_t raw);  // ADC_TEMPERATURE at 12 bits against INTERNAL2V048 -> degrees C (SIGROW calibration)
 uint8_t         getDACReference();
 uint8_t getAnalogSampleDuration();
 int8_t  getAnalogReadResolution();
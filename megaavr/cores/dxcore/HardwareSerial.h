@@ -83,6 +83,61 @@
  * The sole exception? The ATmega2560/2561 has only 8k RAM, a 32:1 flash to ram ratio.
  * (to be fair, you are allowed to use external RAM - which was a very rare feature indeed,
  */
+/* SERIAL_RX_CRC - define as 8 or 16 (in boards.txt or platform.local.txt; defining it in a sketch does nothing)
+ * and the RX interrupt keeps a running crc8_smbus or crc16_modbus (see crc_fast.h) of everything received,
+ * so protocols like Modbus RTU don't have to go over the frame a second time. This needs the C RXC handler. */
+#if defined(SERIAL_RX_CRC)
+  #if SERIAL_RX_CRC != 8 && SERIAL_RX_CRC != 16
+    #error "SERIAL_RX_CRC must be 8 (CRC8, SMBus polynomial) or 16 (CRC16, Modbus)"
+  #endif
+  #if defined(USE_ASM_RXC)
+    #undef USE_ASM_RXC
+  #endif
+  #define USE_ASM_RXC 0
+#endif
+/* SERIAL_FRAME_TCB - define as 0-4 (build flag, like SERIAL_RX_CRC) to give that type B timer to frame receive mode,
+ * Serialn.frameReceive(). Each received character restarts the timer; when the line has been idle for the timeout,
+ * the handler is called once with the whole frame, which is still sitting in the RX ring buffer. Only one port can
+ * be in frame mode at a time, and the timer can't be used for anything else (millis, tone, Servo). Needs the C RXC handler. */
+#if defined(SERIAL_FRAME_TCB)
+  #if SERIAL_FRAME_TCB == 0
+    #define _SERIAL_FRAME_TIMER TCB0
+    #define _SERIAL_FRAME_VECT  TCB0_INT_vect
+    #if defined(MILLIS_USE_TIMERB0)
+      #error "SERIAL_FRAME_TCB is 0, but TCB0 is used for millis - pick another timer for one or the other."
+    #endif
+  #elif SERIAL_FRAME_TCB == 1 && defined(TCB1)
+    #define _SERIAL_FRAME_TIMER TCB1
+    #define _SERIAL_FRAME_VECT  TCB1_INT_vect
+    #if defined(MILLIS_USE_TIMERB1)
+      #error "SERIAL_FRAME_TCB is 1, but TCB1 is used for millis - pick another timer for one or the other."
+    #endif
+  #elif SERIAL_FRAME_TCB == 2 && defined(TCB2)
+    #define _SERIAL_FRAME_TIMER TCB2
+    #define _SERIAL_FRAME_VECT  TCB2_INT_vect
+    #if defined(MILLIS_USE_TIMERB2)
+      #error "SERIAL_FRAME_TCB is 2, but TCB2 is used for millis - pick another timer for one or the other."
+    #endif
+  #elif SERIAL_FRAME_TCB == 3 && defined(TCB3)
+    #define _SERIAL_FRAME_TIMER TCB3
+    #define _SERIAL_FRAME_VECT  TCB3_INT_vect
+    #if defined(MILLIS_USE_TIMERB3)
+      #error "SERIAL_FRAME_TCB is 3, but TCB3 is used for millis - pick another timer for one or the other."
+    #endif
+  #elif SERIAL_FRAME_TCB == 4 && defined(TCB4)
+    #define _SERIAL_FRAME_TIMER TCB4
+    #define _SERIAL_FRAME_VECT  TCB4_INT_vect
+    #if defined(MILLIS_USE_TIMERB4)
+      #error "SERIAL_FRAME_TCB is 4, but TCB4 is used for millis - pick another timer for one or the other."
+    #endif
+  #else
+    #error "SERIAL_FRAME_TCB must be the number of a TCB that this part has."
+  #endif
+  #if defined(USE_ASM_RXC)
+    #undef USE_ASM_RXC
+  #endif
+  #define USE_ASM_RXC 0
+#endif
 #if !defined(LTODISABLED)
 #if !defined(USE_ASM_TXC)
   #define USE_ASM_TXC 2    // A bit slower than 1 in exchange for halfduplex.
@@ -194,6 +249,11 @@
   }})
 
 
+/* Frame receive handler: a frame that wrapped around the end of the ring buffer comes in two pieces, otherwise rest is
+ * NULL and restLength is 0. Return true if the frame has been dealt with and should be dropped from the buffer, or
+ * false to leave it there for read(). Runs in interrupt context. */
+typedef bool (*serialFrameHandler)(volatile uint8_t *data, uint16_t length, volatile uint8_t *rest, uint16_t restLength);
+
 class HardwareSerial : public Stream {
 /* DANGER DANGER DANGER
  * CHANGING THE MEMBER VARIABLES BETWEEN HERE AND THE OTHER SCARY COMMENT WILL COMPLETELY BREAK SERIAL
@@ -217,6 +277,14 @@ class HardwareSerial : public Stream {
 /* DANGER DANGER DANGER */
 /* ANY CHANGES BETWEEN OTHER SCARY COMMENT AND THIS ONE WILL BREAK SERIAL IF THEY CHANGE RAM USED BY CLASS! */
 /* DANGER DANGER DANGER */
+  #if defined(SERIAL_RX_CRC)
+    volatile uint16_t _rx_crc;  // after the buffers, where the asm handlers don't care about it.
+  #endif
+  #if defined(SERIAL_FRAME_TCB)
+    volatile rx_buffer_index_t _frame_start;    // where the frame in progress began in _rx_buffer
+    static HardwareSerial * volatile _frame_port;
+    static serialFrameHandler _frame_handler;
+  #endif
 
   public:
     inline             HardwareSerial(volatile USART_t *hwserial_module, uint8_t *usart_pins, uint8_t mux_count, uint8_t mux_default);
@@ -278,6 +346,7 @@ class HardwareSerial : public Stream {
     inline   size_t write(long n)           {return write((uint8_t)n);}
     inline   size_t write(unsigned int n)   {return write((uint8_t)n);}
     inline   size_t write(int n)            {return write((uint8_t)n);}
+    virtual  size_t write(const uint8_t *buffer, size_t size);
     using Print::write; // pull in write(str) and write(buf, size) from Print
     explicit operator bool() {
       return true;
@@ -303,6 +372,22 @@ class HardwareSerial : public Stream {
     }
 
     uint8_t getPin(uint8_t pin); //wrapper around static _getPin
+    #if defined(SERIAL_RX_CRC)
+      // Running CRC of every character received since the last rxCrcReset(). With crc16_modbus (or crc8_smbus), it is 0
+      // after a complete frame including its CRC if nothing was corrupted.
+      #if SERIAL_RX_CRC == 16
+        void      rxCrcReset(uint16_t init = 0xFFFF) {uint8_t oldSREG = SREG; cli(); _rx_crc = init; SREG = oldSREG;}
+      #else
+        void      rxCrcReset(uint16_t init = 0x00)   {uint8_t oldSREG = SREG; cli(); _rx_crc = init; SREG = oldSREG;}
+      #endif
+      uint16_t    rxCrc() {uint8_t oldSREG = SREG; cli(); uint16_t ret = _rx_crc; SREG = oldSREG; return ret;}
+    #endif
+    // Call handler once per frame, a frame being everything received until the line has been idle for idleMicros.
+    // NULL handler turns it off. Returns 1 if SERIAL_FRAME_TCB wasn't defined.
+    uint8_t frameReceive(uint16_t idleMicros, serialFrameHandler handler);
+    #if defined(SERIAL_FRAME_TCB)
+      static void _frame_timeout();  // called by the timer interrupt
+    #endif
 
     // Interrupt handlers - Not intended to be called externally
     #if !(USE_ASM_RXC == 1 && \
@@ -316,6 +401,7 @@ class HardwareSerial : public Stream {
     #endif
 
   private:
+    friend class USARTSPI; // The SPI library's USARTSPI borrows the pin mapping to run the USART in MSPI mode.
     void _poll_tx_data_empty(void);
     /* These all concern pin set handling */
     static void        _set_pins(uint8_t* pinInfo, uint8_t mux_count, uint8_t mux_setting,  uint8_t enmask);
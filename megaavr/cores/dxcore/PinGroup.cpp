@@ -0,0 +1,157 @@
+/*  (C) Spence Konde 2022
+ * PinGroup.cpp - implementation of the PinGroup class, see PinGroup.h
+ *
+ * This is part of DxCore - github.com/SpenceKonde/DxCore
+ * This is free software, LGPL 2.1 see ../../LICENSE.md for details.
+ *************************************************************/
+#include "PinGroup.h"
+
+// Assumes VPORTs exist starting at 0 for each PORT structure, like wiring_digital.c does.
+#define _pinGroupVPORT(p) ((VPORT_t *)((p) * 4))
+
+void PinGroup::_init(const uint8_t *pins, uint8_t count) {
+  if (count > PINGROUP_MAX_PINS) {
+    count = PINGROUP_MAX_PINS;
+  }
+  _count = count;
+  _nports = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t pin  = pins[i];
+    uint8_t port = digitalPinToPort(pin);
+    _pinSlot[i]  = 0;
+    _pinMask[i]  = 0;
+    if (port == NOT_A_PORT || port >= NUM_TOTAL_PORTS) {
+      continue; // invalid pins keep their bit position but do nothing, just like digitalWrite(NOT_A_PIN, x).
+    }
+    uint8_t mask = digital_pin_to_bit_mask[pin];
+    uint8_t slot = 0;
+    while (slot < _nports && _port[slot] != port) {
+      slot++;
+    }
+    if (slot == _nports) {
+      _port[slot]       = port;
+      _portMask[slot]   = 0;
+      _valueShift[slot] = i;
+      _portShift[slot]  = digital_pin_to_bit_position[pin];
+      _nports++;
+    }
+    _portMask[slot] |= mask;
+    _pinSlot[i]      = slot;
+    _pinMask[i]      = mask;
+  }
+  // Now check which ports can use the shift shortcut: the value bits that map onto that port must be
+  // consecutive, and each must land on the next bit of the port.
+  for (uint8_t slot = 0; slot < _nports; slot++) {
+    uint8_t first = _valueShift[slot];
+    uint8_t k = 0;
+    for (uint8_t i = first; i < count; i++) {
+      if (_pinMask[i] && _pinSlot[i] == slot) {
+        if (i != first + k || _pinMask[i] != (uint8_t)(1 << (_portShift[slot] + k))) {
+          _portShift[slot] = -1;
+          break;
+        }
+        k++;
+      }
+    }
+  }
+}
+
+void PinGroup::write(uint16_t value) {
+  uint8_t bits[NUM_TOTAL_PORTS];
+  bool scattered = false;
+  for (uint8_t slot = 0; slot < _nports; slot++) {
+    if (_portShift[slot] >= 0) {
+      bits[slot] = ((uint8_t)(value >> _valueShift[slot]) << _portShift[slot]) & _portMask[slot];
+    } else {
+      bits[slot] = 0;
+      scattered = true;
+    }
+  }
+  if (scattered) {
+    uint16_t v = value;
+    for (uint8_t i = 0; i < _count; i++) {
+      if (v & 1) {
+        uint8_t slot = _pinSlot[i];
+        if (_portShift[slot] < 0) {
+          bits[slot] |= _pinMask[i];
+        }
+      }
+      v >>= 1;
+    }
+  }
+  // One store per port; interrupts are held off only across the read-modify-write of each VPORT.OUT so
+  // that an ISR writing other pins on the same port doesn't get clobbered.
+  for (uint8_t slot = 0; slot < _nports; slot++) {
+    VPORT_t *vport = _pinGroupVPORT(_port[slot]);
+    uint8_t mask = _portMask[slot];
+    uint8_t oldSREG = SREG;
+    cli();
+    vport->OUT = (vport->OUT & ~mask) | bits[slot];
+    SREG = oldSREG;
+  }
+}
+
+uint16_t PinGroup::read() {
+  uint8_t in[NUM_TOTAL_PORTS];
+  for (uint8_t slot = 0; slot < _nports; slot++) {
+    in[slot] = _pinGroupVPORT(_port[slot])->IN;
+  }
+  uint16_t value = 0;
+  for (uint8_t slot = 0; slot < _nports; slot++) {
+    if (_portShift[slot] >= 0) {
+      value |= ((uint16_t)((in[slot] & _portMask[slot]) >> _portShift[slot])) << _valueShift[slot];
+    }
+  }
+  uint16_t bit = 1;
+  for (uint8_t i = 0; i < _count; i++) {
+    uint8_t mask = _pinMask[i];
+    if (mask && _portShift[_pinSlot[i]] < 0 && (in[_pinSlot[i]] & mask)) {
+      value |= bit;
+    }
+    bit <<= 1;
+  }
+  return value;
+}
+
+void PinGroup::setAll() {
+  for (uint8_t slot = 0; slot < _nports; slot++) {
+    portToPortStruct(_port[slot])->OUTSET = _portMask[slot];
+  }
+}
+
+void PinGroup::clearAll() {
+  for (uint8_t slot = 0; slot < _nports; slot++) {
+    portToPortStruct(_port[slot])->OUTCLR = _portMask[slot];
+  }
+}
+
+void PinGroup::toggleAll() {
+  for (uint8_t slot = 0; slot < _nports; slot++) {
+    portToPortStruct(_port[slot])->OUTTGL = _portMask[slot];
+  }
+}
+
+void PinGroup::mode(uint8_t mode) {
+  for (uint8_t slot = 0; slot < _nports; slot++) {
+    PORT_t *port = portToPortStruct(_port[slot]);
+    uint8_t mask = _portMask[slot];
+    if (mode == OUTPUT) {
+      port->DIRSET = mask;
+      continue;
+    }
+    port->DIRCLR = mask;
+    volatile uint8_t *pinctrl = &(port->PIN0CTRL);
+    for (uint8_t b = 0; b < 8; b++) {
+      if (mask & (1 << b)) {
+        uint8_t oldSREG = SREG;
+        cli();
+        if (mode == INPUT_PULLUP) {
+          pinctrl[b] |= PORT_PULLUPEN_bm;
+        } else {
+          pinctrl[b] &= ~PORT_PULLUPEN_bm;
+        }
+        SREG = oldSREG;
+      }
+    }
+  }
+}
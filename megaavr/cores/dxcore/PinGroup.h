@@ -0,0 +1,53 @@
+/*  (C) Spence Konde 2022
+ * PinGroup.h - write or read up to 16 arbitrary pins as a single value.
+ *
+ * The constructor does all the table lookups once: for each port involved it records the
+ * mask of pins in that port (used directly as the OUTSET/OUTCLR/OUTTGL/DIRSET/DIRCLR value),
+ * and for each pin, which port it lives in and its bit mask there (the scatter map). After
+ * that, write() and read() touch each port involved exactly once, through the VPORT registers.
+ * See Ref_Digital.md for details.
+ *
+ * This is part of DxCore - github.com/SpenceKonde/DxCore
+ * This is free software, LGPL 2.1 see ../../LICENSE.md for details.
+ *************************************************************/
+#ifndef PINGROUP_H
+#define PINGROUP_H
+#include <Arduino.h>
+
+#define PINGROUP_MAX_PINS  (16)
+
+class PinGroup {
+  public:
+    template <typename... Pins>
+    PinGroup(uint8_t first, Pins... rest) {
+      const uint8_t list[] = {first, ((uint8_t) rest)...};
+      static_assert(sizeof...(rest) < PINGROUP_MAX_PINS, "A PinGroup can contain at most 16 pins");
+      _init(list, sizeof...(rest) + 1);
+    }
+    PinGroup(const uint8_t *pins, uint8_t count) {
+      _init(pins, count);
+    }
+    // Bit n of the value corresponds to the n'th pin passed to the constructor.
+    void     write(uint16_t value);
+    uint16_t read();
+    // These write the precomputed masks to the PORT registers, so they are a single store per port
+    // and are atomic without disabling interrupts.
+    void     setAll();
+    void     clearAll();
+    void     toggleAll();
+    void     mode(uint8_t mode); // OUTPUT, INPUT or INPUT_PULLUP
+    uint8_t  size()      {return _count;}
+    uint8_t  portCount() {return _nports;}
+
+  private:
+    void _init(const uint8_t *pins, uint8_t count);
+    uint8_t  _count = 0;
+    uint8_t  _nports = 0;
+    uint8_t  _port[NUM_TOTAL_PORTS];       // Port number of each port slot
+    uint8_t  _portMask[NUM_TOTAL_PORTS];   // All pins in this group on that port
+    uint8_t  _valueShift[NUM_TOTAL_PORTS]; // If the pins on a port are a contiguous run in both the value and the port,
+    int8_t   _portShift[NUM_TOTAL_PORTS];  // the scatter is just a shift: (value >> _valueShift) << _portShift. -1 if not.
+    uint8_t  _pinSlot[PINGROUP_MAX_PINS];  // Scatter map: port slot of each pin...
+    uint8_t  _pinMask[PINGROUP_MAX_PINS];  // ... and its bit mask within that port (0 for an invalid pin).
+};
+#endif
@@ -23,6 +23,9 @@
 
 #include "UART.h"
 #include "UART_private.h"
+#if defined(SERIAL_RX_CRC)
+  #include "crc_fast.h"
+#endif
 
 // this next line disables the entire UART.cpp if there's no hardware serial
 #if defined(USART0) || defined(USART1) || defined(USART2) || defined(USART3) || defined(USART4) || defined(USART5)
@@ -268,6 +271,11 @@
         if (!(rxDataH & USART_PERR_bm)) {
           // No Parity error, read byte and store it in the buffer if there is room
           // unsigned char c = HardwareSerial._hwserial_module->RXDATAL;
+          #if SERIAL_RX_CRC == 16
+            HardwareSerial._rx_crc = crc16_modbus_update(HardwareSerial._rx_crc, c);
+          #elif SERIAL_RX_CRC == 8
+            HardwareSerial._rx_crc = crc8_smbus_update((uint8_t) HardwareSerial._rx_crc, c);
+          #endif
           #if SERIAL_RX_BUFFER_SIZE > 256
             rx_buffer_index_t i = (uint16_t)(rxHead + 1) % SERIAL_RX_BUFFER_SIZE;
           #else
@@ -282,6 +290,15 @@
             HardwareSerial._rx_buffer[rxHead] = c;
             HardwareSerial._rx_buffer_head = i;
           }
+          #if defined(SERIAL_FRAME_TCB)
+            if (_frame_port == &HardwareSerial) {
+              if (!(_SERIAL_FRAME_TIMER.CTRLA & TCB_ENABLE_bm)) {
+                HardwareSerial._frame_start = rxHead;   // first character of a new frame
+              }
+              _SERIAL_FRAME_TIMER.CNT   = 0;          // restart the idle timeout
+              _SERIAL_FRAME_TIMER.CTRLA = TCB_CLKSEL_DIV2_gc | TCB_ENABLE_bm;
+            }
+          #endif
         }
       }
     #endif
@@ -489,7 +506,7 @@
 
     // Not static
     uint8_t HardwareSerial::getPin(uint8_t pin) {
-      return _getPin(_usart_pins, pin, _pin_set, _mux_count);
+      return _getPin(_usart_pins, _mux_count, _pin_set, pin);
     }
     // Static
     uint8_t HardwareSerial::_getPin(uint8_t * mux_table_ptr, uint8_t muxcount, uint8_t pinset, uint8_t pin) {
@@ -549,11 +566,12 @@
       uint8_t ctrla = (uint8_t) (options >> 8);// CTRLA will get the remains of the options high byte.
       uint16_t baud_setting = 0;                // at this point it should be able to reuse those 2 registers that it received options in!
       uint8_t   ctrlb = (~ctrla & 0xC0);        // Top two bits (TXEN RXEN), inverted so they match he sense in the registers.
-      if (baud   > F_CPU / 16) {            // if this baud is too fast for non-U2X
+      uint32_t fcpu = getCPUFrequency();      // F_CPU unless setCPUFrequency() has been used.
+      if (baud   > fcpu / 16) {             // if this baud is too fast for non-U2X
             ctrlb   |= USART_RXMODE0_bm;        // set the U2X bit in what will become CTRLB
             baud   >>= 1;                       // And lower the baud rate by haldf
       }
-      baud_setting = (((4 * F_CPU) / baud));  // And now the registers that baud was passed in are done.
+      baud_setting = (((4 * fcpu) / baud));   // And now the registers that baud was passed in are done.
       if (baud_setting < 64)                      // so set to the maximum baud rate setting.
         baud_setting= 64;       // set the U2X bit in what will become CTRLB
       //} else if (baud < (F_CPU / 16800)) {      // Baud rate is too low
@@ -564,6 +582,10 @@
       }
       // Baud setting done now we do the other options.
       // that aren't in CTRLC;
+      _state &= ~2;
+      if (ctrla & 0x10) {                       // SERIAL_IGNORE_ECHO - the half duplex handling, without touching the pins.
+        _state                 |= 2;            // write() turns off RXCIE and turns on TXCIE, and the TXC ISR flushes RX and turns it back.
+      }
       ctrla &= 0x2B;                            // Only LBME and RS485 (both of them); will get written to CTRLA, but we leave the event bit.
       if (ctrlb & USART_RXEN_bm) {              // if RX is to be enabled
         ctrla  |= USART_RXCIE_bm;               // we will want to enable the ISR.
@@ -578,6 +600,11 @@
       }
       uint8_t oldSREG = SREG;
       cli();
+      #if SERIAL_RX_CRC == 16
+        _rx_crc                 = 0xFFFF;
+      #elif SERIAL_RX_CRC == 8
+        _rx_crc                 = 0;
+      #endif
       volatile USART_t* MyUSART = _hwserial_module;
       (*MyUSART).CTRLB          = 0;            // gotta disable first - some things are enable-locked.
       (*MyUSART).CTRLC          = ctrlc;        // No reason not to set first.
@@ -821,6 +848,15 @@
         return 1;
       }
 
+      // Same as Print's, but calls our write() directly instead of through the vtable for each character.
+      size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+        size_t n = size;
+        while (n--) {
+          HardwareSerial::write(*buffer++);
+        }
+        return size;
+      }
+
       void HardwareSerial::printHex(const uint8_t b) {
         char x = (b >> 4) | '0';
         if (x > '9')
@@ -876,6 +912,73 @@
         println();
         return p;
       }
+  #if defined(SERIAL_FRAME_TCB)
+      HardwareSerial * volatile HardwareSerial::_frame_port = NULL;
+      serialFrameHandler HardwareSerial::_frame_handler = NULL;
+
+      uint8_t HardwareSerial::frameReceive(uint16_t idleMicros, serialFrameHandler handler) {
+        // Counting at CLK_PER/2; at 24 MHz the longest timeout this allows is about 5.4 ms.
+        uint32_t ticks = ((uint32_t) idleMicros * (getCPUFrequency() / 10000UL)) / 200;
+        if (ticks > 0xFFFF) {
+          ticks = 0xFFFF;
+        } else if (ticks == 0) {
+          ticks = 1;
+        }
+        uint8_t oldSREG = SREG;
+        cli();
+        _SERIAL_FRAME_TIMER.CTRLA    = 0;
+        _SERIAL_FRAME_TIMER.CTRLB    = TCB_CNTMODE_INT_gc;   // Periodic interrupt mode, but it's stopped on the first one.
+        _SERIAL_FRAME_TIMER.CCMP     = ticks;
+        _SERIAL_FRAME_TIMER.CNT      = 0;
+        _SERIAL_FRAME_TIMER.INTFLAGS = TCB_CAPT_bm;
+        _SERIAL_FRAME_TIMER.INTCTRL  = handler ? TCB_CAPT_bm : 0;
+        _frame_handler = handler;
+        _frame_port    = handler ? this : NULL;
+        SREG = oldSREG;
+        return 0;
+      }
+
+      void HardwareSerial::_frame_timeout() {
+        HardwareSerial *port = _frame_port;
+        if (port == NULL || _frame_handler == NULL) {
+          return;
+        }
+        rx_buffer_index_t head  = port->_rx_buffer_head;
+        rx_buffer_index_t start = port->_frame_start;
+        uint16_t length = (uint16_t)(head - start) & (SERIAL_RX_BUFFER_SIZE - 1);
+        if (length == 0) {
+          return;                                   // everything got dropped because the buffer was full.
+        }
+        uint16_t first = SERIAL_RX_BUFFER_SIZE - start;
+        bool consumed;
+        if (length > first) {
+          consumed = _frame_handler(&port->_rx_buffer[start], first, &port->_rx_buffer[0], length - first);
+        } else {
+          consumed = _frame_handler(&port->_rx_buffer[start], length, NULL, 0);
+        }
+        if (consumed) {
+          // Take out the frame's own characters only. If read() has got into the frame, the rest of it goes;
+          // if it hasn't reached the frame yet, what's before it is still unread, so the frame comes off the end.
+          rx_buffer_index_t tail = port->_rx_buffer_tail;
+          if (((uint16_t)(tail - start) & (SERIAL_RX_BUFFER_SIZE - 1)) <= length) {
+            port->_rx_buffer_tail = head;
+          } else {
+            port->_rx_buffer_head = start;          // the receive interrupt can't add to it while we're in this one
+          }
+        }
+      }
+
+      ISR(_SERIAL_FRAME_VECT) {
+        _SERIAL_FRAME_TIMER.CTRLA    = 0;           // the line went idle; stop until the next character comes in.
+        _SERIAL_FRAME_TIMER.INTFLAGS = TCB_CAPT_bm;
+        HardwareSerial::_frame_timeout();
+      }
+  #else
+      uint8_t HardwareSerial::frameReceive(__attribute__((unused)) uint16_t idleMicros, __attribute__((unused)) serialFrameHandler handler) {
+        badCall("frameReceive() requires SERIAL_FRAME_TCB to be defined as the number of a free type B timer");
+        return 1;
+      }
+  #endif
       volatile uint8_t * HardwareSerial::printHex(volatile uint8_t* p, uint8_t len, char sep) {
         for (byte i = 0; i < len; i++) {
           if (sep && i) write(sep);
@@ -124,9 +124,11 @@
 #define   SERIAL_TX_ONLY       (((uint16_t) USART_RXEN_bm)    << 8)// 0x8000 The TXEN/RXEN bits are swapped - we invert the meaning of this bit.
 #define   SERIAL_RX_ONLY       (((uint16_t) USART_TXEN_bm)    << 8)// 0x4000 so if not specified, you get a serial port with both pins. Do not specify both. That will not enable anything.
 #define   SERIAL_EVENT_RX       ((uint16_t)                 0x2000)// 0x2000
+#define   SERIAL_IGNORE_ECHO    ((uint16_t)                 0x1000)// 0x1000 RX interrupt off while sending, and whatever came in meanwhile is discarded on TXC. Implied by SERIAL_HALF_DUPLEX.
 //#define SERIAL_MODE_SYNC      Defined Above                     // 0x0040 - works much like a modifier to enable synchronous mode.
 // See the Serial reference for more information as additional steps are required
   #define SERIAL_HALF_DUPLEX     (SERIAL_LOOPBACK | SERIAL_OPENDRAIN)
+  #define SERIAL_RS485_HALF_DUPLEX (SERIAL_RS485 | SERIAL_IGNORE_ECHO) // 2-wire RS485: XDIR drives DE, and we don't hear ourselves.
   //
 
 #define SERIAL_AUTOBAUD                     (0x80000000) // OR with baud rate for topology 3 in Ref. Serial
@@ -97,7 +97,13 @@
     volatile voidFuncPtr * intFunc[] = {NULL, NULL, NULL, NULL, NULL, NULL, NULL};
   #endif
 
-  // static void _attachInterruopt(uint8_t pin, void (*userFunc)(void), uint8_t mode);
+  #if defined(CORE_ATTACH_FASTDISPATCH)
+    /* One bit per pin, set if the handler on that pin was attached with attachInterruptLean(), so the ISR
+     * can call it without saving the rest of the call-used registers. */
+    volatile uint8_t intFuncLean[7];
+  #endif
+
+  static void _attachInterrupt(uint8_t pin, void (*userFunc)(void), uint8_t mode, uint8_t lean);
 
   volatile uint8_t* portbase = (volatile uint8_t*)((uint16_t)0x400);
   /* On modern AVRs, the PORT registers start at 0x400
@@ -107,7 +113,15 @@
    * future part with 8 ports anyway. We will cross that bridge once Microchip has announced intent to build it.
    */
 
-  void  attachInterrupt(uint8_t pin, void (*userFunc)(void), uint8_t mode) {
+  void attachInterrupt(uint8_t pin, void (*userFunc)(void), uint8_t mode) {
+    _attachInterrupt(pin, userFunc, mode, false);
+  }
+
+  void attachInterruptLean(uint8_t pin, void (*userFunc)(void), uint8_t mode) {
+    _attachInterrupt(pin, userFunc, mode, true);
+  }
+
+  static void _attachInterrupt(uint8_t pin, void (*userFunc)(void), uint8_t mode, __attribute__((unused)) uint8_t lean) {
     uint8_t bitpos = digitalPinToBitPosition(pin);
     if (bitpos == NOT_A_PIN) {
       return;
@@ -131,10 +145,17 @@
     }
     if (intFunc[port] != NULL && userFunc != NULL) {
       // if it is null the port is not enabled for attachInterrupt, and obviously a null user function is invalid too.
-      intFunc[port][bitpos] = userFunc;
       uint8_t portoffset = ((port << 5) & 0xE0) + 0x10 + bitpos;
       uint8_t oldSREG = SREG;
       cli();
+      intFunc[port][bitpos] = userFunc;
+      #if defined(CORE_ATTACH_FASTDISPATCH)
+        if (lean) {
+          intFuncLean[port] |= (1 << bitpos);
+        } else {
+          intFuncLean[port] &= ~(1 << bitpos);
+        }
+      #endif
       // We now have the port, the mode, the bitpos and the pointer
       uint8_t settings = *(portbase + portoffset) & 0xF8;
       *(portbase + portoffset) = settings | mode;
@@ -143,7 +164,135 @@
 
   }
 
-#if !defined(CORE_ATTACH_EARLYCLEAR)
+#if defined(CORE_ATTACH_FASTDISPATCH)
+  /* Direct dispatch: instead of walking the flags one bit at a time and saving every call-used register up front,
+   * isolate the lowest set flag with (flags & -flags), turn that into a table offset with a 3-step binary search
+   * (same number of clocks for every bit position), clear just that flag, and call the handler. Only the registers
+   * the dispatcher itself uses, plus those a lean handler is allowed to clobber (r24-r27, r30, r31) are saved
+   * in the prologue; the remaining call-used registers (r0, r18-r23) and RAMPZ are saved around the call only
+   * when the handler was attached with plain attachInterrupt(). Flags are cleared individually just before each
+   * handler is called, so an edge on another pin that arrives while a handler is running is not lost.
+   * r15 = lean mask for this port, r16 = address of VPORTx.INTFLAGS, r17 = flags not yet serviced, Y = handler table.
+   */
+  void __attribute__((naked)) __attribute__((used)) __attribute__((noreturn)) isrBody() {
+    asm volatile (
+     "AttachedISR:"      "\n\t" // as the scene opens, we have r16 on the stack already, portnumber x 2 in the r16
+      "push  r1"         "\n\t"
+      "in    r1, 0x3f"   "\n\t" // The SREG
+      "push  r1"         "\n\t" // on the stack
+      "eor   r1, r1"     "\n\t" // handlers will want this to be zero.
+      "push  r15"        "\n\t" // call-saved, we use it for the lean mask
+      "push  r17"        "\n\t" // call-saved, we use it for the pending flags
+      "push  r24"        "\n\t" // r24-r27, r30 and r31 are the registers a lean handler may clobber
+      "push  r25"        "\n\t" // and we use them ourselves too
+      "push  r26"        "\n\t"
+      "push  r27"        "\n\t"
+      "push  r28"        "\n\t" // Not call used, but we use it.
+      "push  r29"        "\n\t" // same thing.
+      "push  r30"        "\n\t"
+      "push  r31"        "\n\t"
+      "ldi   r30, lo8(%[funcs])"  "\n\t" // address of the array of pointers to each port's handler table
+      "ldi   r31, hi8(%[funcs])"  "\n\t"
+      "add   r30,   r16"  "\n\t" // r16 is 2x the port number, and pointers are 2 bytes.
+      "adc   r31,    r1"  "\n\t"
+      "ld    r28,     Z+" "\n\t" // load the pointer to this port's function array...
+      "ld    r29,     Z"  "\n\t" // ... to the Y pointer reg.
+      "lsr   r16"         "\n\t" // now r16 is the port number
+      "ldi   r30, lo8(%[lean])"   "\n\t"
+      "ldi   r31, hi8(%[lean])"   "\n\t"
+      "add   r30,   r16"  "\n\t"
+      "adc   r31,    r1"  "\n\t"
+      "ld    r15,     Z"  "\n\t" // lean mask for this port
+      "lsl   r16"         "\n\t"
+      "lsl   r16"         "\n\t" // 4x port number, the address of the VPORT
+      "subi  r16,   253"  "\n\t" // Add 3; now this is the address of the VPORTx.INTFLAGS
+      "mov   r26,   r16"  "\n\t"
+      "ldi   r27,     0"  "\n\t"
+      "ld    r17,     X"  "\n\t" // Load flags to r17
+      "sbiw  r28,     0"  "\n\t" // port not enabled? Then just clear the flags and leave.
+      "brne  AIntLoop"    "\n\t"
+      "st      X,   r17"  "\n\t"
+      "rjmp  AIntEnd"     "\n\t"
+    "AIntLoop:"           "\n\t"
+      "mov   r24,   r17"  "\n\t"
+      "neg   r24"         "\n\t"
+      "and   r24,   r17"  "\n\t" // r24 = lowest pending flag
+      "breq  AIntEnd"     "\n\t" // none left - we're done.
+      "eor   r17,   r24"  "\n\t" // it's no longer pending
+      "mov   r26,   r16"  "\n\t" // handlers may have trashed X, so reload the INTFLAGS address every time
+      "ldi   r27,     0"  "\n\t"
+      "st      X,   r24"  "\n\t" // and clear that one flag.
+      "clt"               "\n\t" // T flag = this pin's handler is lean.
+      "mov   r25,   r15"  "\n\t"
+      "and   r25,   r24"  "\n\t"
+      "breq  .+2"         "\n\t"
+      "set"               "\n\t"
+      "movw  r30,   r28"  "\n\t" // Z = start of this port's handler table.
+      "cpi   r24,  0x10"  "\n\t" // bit 4-7?
+      "brlo  1f"          "\n\t"
+      "adiw  r30,     8"  "\n\t"
+      "swap  r24"         "\n\t"
+    "1:"                  "\n\t"
+      "cpi   r24,  0x04"  "\n\t" // bit 2-3 (of what's left)?
+      "brlo  2f"          "\n\t"
+      "adiw  r30,     4"  "\n\t"
+      "lsr   r24"         "\n\t"
+      "lsr   r24"         "\n\t"
+    "2:"                  "\n\t"
+      "cpi   r24,  0x02"  "\n\t" // bit 1?
+      "brlo  3f"          "\n\t"
+      "adiw  r30,     2"  "\n\t"
+    "3:"                  "\n\t"
+      "ld    r24,     Z+" "\n\t" // load the function pointer
+      "ld    r25,     Z"  "\n\t"
+      "movw  r30,   r24"  "\n\t"
+      "sbiw  r30,     0"  "\n\t" // zero-check it.
+      "breq  AIntLoop"    "\n\t" // don't call the null pointer
+      "brts  AIntLean"    "\n\t"
+      "push  r0"          "\n\t" // A normal handler may use any call-used register, so save the rest of them.
+      "in    r0,   0x3b"  "\n\t" // RAMPZ
+      "push  r0"          "\n\t"
+      "push  r18"         "\n\t"
+      "push  r19"         "\n\t"
+      "push  r20"         "\n\t"
+      "push  r21"         "\n\t"
+      "push  r22"         "\n\t"
+      "push  r23"         "\n\t"
+      "icall"             "\n\t"
+      "pop   r23"         "\n\t"
+      "pop   r22"         "\n\t"
+      "pop   r21"         "\n\t"
+      "pop   r20"         "\n\t"
+      "pop   r19"         "\n\t"
+      "pop   r18"         "\n\t"
+      "pop   r0"          "\n\t"
+      "out   0x3b,   r0"  "\n\t"
+      "pop   r0"          "\n\t"
+      "rjmp  AIntLoop"    "\n\t"
+    "AIntLean:"           "\n\t"
+      "icall"             "\n\t" // lean handler: only r24-r27, r30, r31 and SREG may be changed.
+      "rjmp  AIntLoop"    "\n\t"
+    "AIntEnd:"            "\n\t"
+      "pop   r31"         "\n\t"
+      "pop   r30"         "\n\t"
+      "pop   r29"         "\n\t"
+      "pop   r28"         "\n\t"
+      "pop   r27"         "\n\t"
+      "pop   r26"         "\n\t"
+      "pop   r25"         "\n\t"
+      "pop   r24"         "\n\t"
+      "pop   r17"         "\n\t"
+      "pop   r15"         "\n\t"
+      "pop   r1"          "\n\t"
+      "out   0x3f,   r1"  "\n\t"
+      "pop   r1"          "\n\t"
+      "pop   r16"         "\n\t" // this was the reg we pushed back in the port-specific file.
+      "reti"              "\n"
+      :: [funcs] "i" (&intFunc), [lean] "i" (&intFuncLean)
+      );
+      __builtin_unreachable();
+  }
+#elif !defined(CORE_ATTACH_EARLYCLEAR)
   void __attribute__((naked)) __attribute__((used)) __attribute__((noreturn)) isrBody() {
     asm volatile (
      "AttachedISR:"      "\n\t" // as the scene opens, we have r16 on the stack already, portnumber x 2 in the r16
@@ -325,6 +474,9 @@
     *(((volatile uint8_t*) &PORTA_PIN0CTRL) + p) &= 0xF1; // int off....
     *((volatile uint8_t*) ((uint16_t)((port << 4) + 3)))  = (1 << bitpos);// flag clear
     intFunc[port][bitpos] = 0; // clear pointer
+    #if defined(CORE_ATTACH_FASTDISPATCH)
+      intFuncLean[port] &= ~(1 << bitpos);
+    #endif
   }
 /* If not enabling attach on all ports always, instead the identical ISR definitions are in the WInterruptsA/B/C/D/E/F/G.c files.
  * Okay, so what the f-- is going on here?
@@ -526,6 +678,10 @@
     }
   }
 
+  void attachInterruptLean(uint8_t pin, void (*userFunc)(void), uint8_t mode) {
+    attachInterrupt(pin, userFunc, mode); // the old implementation always saves everything.
+  }
+
   void detachInterrupt(uint8_t pin) {
     /* Get bit position and check pin validity */
     uint8_t bit_pos = digitalPinToBitPosition(pin);
@@ -22,6 +22,7 @@
 #include <math.h>
 
 #include "Print.h"
+#include "num_fast.h"
 
 // Public Methods //////////////////////////////////////////////////////////////
 
@@ -87,12 +88,8 @@ size_t Print::print(long n, int base) {
   if (base == 0) {
     return write(n);
   } else if (base == 10) {
-    if (n < 0) {
-      int t = print('-');
-      n = -n;
-      return printNumber(n, 10) + t;
-    }
-    return printNumber(n, 10);
+    char buf[12];
+    return write(buf, fast_ltoa10(n, buf));
   } else {
     return printNumber(n, base);
   }
@@ -110,6 +107,11 @@ size_t Print::print(double n, int digits) {
   return printFloat(n, digits);
 }
 
+size_t Print::printFixed(long value, uint8_t decimals) {
+  char buf[13];
+  return write(buf, fast_fixtoa(value, decimals, buf));
+}
+
 size_t Print::println(const __FlashStringHelper *ifsh) {
   size_t n = print(ifsh);
   n += println();
@@ -184,30 +186,222 @@ size_t Print::println(const Printable &x) {
   return n;
 }
 
+size_t Print::printlnFixed(long value, uint8_t decimals) {
+  size_t n = printFixed(value, decimals);
+  n += println();
+  return n;
+}
+
 // Custom implementation of printf borrowed from the teensy core files
+// Output is collected in a small buffer on the stack and handed to write(buffer, size) a chunk at a time, instead of
+// making a virtual write() call for every character. PRINTF_BUFFER_SIZE can be changed as a build flag.
+#if !defined(PRINTF_BUFFER_SIZE)
+  #define PRINTF_BUFFER_SIZE 32
+#endif
+
+typedef struct {
+  Print *dest;
+  uint8_t len;
+  char buf[PRINTF_BUFFER_SIZE];
+} printf_buffer_t;
+
+static void printf_flush(printf_buffer_t *pb) {
+  if (pb->len) {
+    pb->dest->write((const uint8_t *)pb->buf, pb->len);
+    pb->len = 0;
+  }
+}
+
+static void printf_put(printf_buffer_t *pb, char c) {
+  pb->buf[pb->len++] = c;
+  if (pb->len == PRINTF_BUFFER_SIZE) {
+    printf_flush(pb);
+  }
+}
+
 static int16_t printf_putchar(char c, FILE *fp) {
-  ((class Print *)(fdev_get_udata(fp)))->write((uint8_t)c);
+  printf_put((printf_buffer_t *)(fdev_get_udata(fp)), c);
   return 0;
 }
 
 int16_t Print::printf(const char *format, ...) {
   FILE f;
   va_list ap;
+  printf_buffer_t pb;
+  pb.dest = this;
+  pb.len = 0;
 
   fdev_setup_stream(&f, printf_putchar, NULL, _FDEV_SETUP_WRITE);
-  fdev_set_udata(&f, this);
+  fdev_set_udata(&f, &pb);
   va_start(ap, format);
-  return vfprintf(&f, format, ap);
+  int16_t ret = vfprintf(&f, format, ap);
+  va_end(ap);
+  printf_flush(&pb);
+  return ret;
 }
 
 int16_t Print::printf(const __FlashStringHelper *format, ...) {
   FILE f;
   va_list ap;
+  printf_buffer_t pb;
+  pb.dest = this;
+  pb.len = 0;
 
   fdev_setup_stream(&f, printf_putchar, NULL, _FDEV_SETUP_WRITE);
-  fdev_set_udata(&f, this);
+  fdev_set_udata(&f, &pb);
+  va_start(ap, format);
+  int16_t ret = vfprintf_P(&f, (const char *)format, ap);
+  va_end(ap);
+  printf_flush(&pb);
+  return ret;
+}
+
+/* iprintf() - integer only printf, which does not use vfprintf at all. Understands %d %i %u %x %X %o %c %s %S (a
+ * string in flash) and %%, with an l length modifier, a width, and the - and 0 flags. Anything else is copied as-is.
+ * A NULL string prints as (null). */
+static int16_t printf_int(printf_buffer_t *pb, const char *format, bool progmem, va_list ap) {
+  int16_t count = 0;
+  char tmp[3 * sizeof(long) + 2];  // 11 octal digits is the longest
+  while (1) {
+    char c = progmem ? pgm_read_byte(format++) : *format++;
+    if (c == 0) {
+      break;
+    }
+    if (c != '%') {
+      printf_put(pb, c);
+      count++;
+      continue;
+    }
+    bool left = false;
+    bool islong = false;
+    char pad = ' ';
+    uint8_t width = 0;
+    c = progmem ? pgm_read_byte(format++) : *format++;
+    if (c == '-') {
+      left = true;
+      c = progmem ? pgm_read_byte(format++) : *format++;
+    }
+    if (c == '0') {
+      pad = '0';
+      c = progmem ? pgm_read_byte(format++) : *format++;
+    }
+    while (c >= '0' && c <= '9') {
+      width = width * 10 + (c - '0');
+      c = progmem ? pgm_read_byte(format++) : *format++;
+    }
+    if (c == 'l') {
+      islong = true;
+      c = progmem ? pgm_read_byte(format++) : *format++;
+    }
+    const char *str = tmp;
+    bool strP = false;
+    char sign = 0;
+    uint8_t base = 0;
+    unsigned long u = 0;
+    switch (c) {
+      case 0:
+        return count;   // format string ended in the middle of a conversion
+      case 'd':
+      case 'i': {
+        long v = islong ? va_arg(ap, long) : va_arg(ap, int);
+        u = v;
+        if (v < 0) {
+          sign = '-';
+          u = -u;
+        }
+        base = 10;
+        break;
+      }
+      case 'u':
+        base = 10;
+        break;
+      case 'x':
+      case 'X':
+        base = 16;
+        break;
+      case 'o':
+        base = 8;
+        break;
+      case 'c':
+        tmp[0] = (char) va_arg(ap, int);
+        tmp[1] = 0;
+        break;
+      case 's':
+      case 'S':
+        str = va_arg(ap, const char *);
+        strP = (c == 'S');
+        if (str == NULL) {
+          str = PSTR("(null)");
+          strP = true;
+        }
+        break;
+      default:          // %% and anything we don't understand
+        tmp[0] = c;
+        tmp[1] = 0;
+        break;
+    }
+    if (base) {
+      if (c != 'd' && c != 'i') {
+        u = islong ? va_arg(ap, unsigned long) : va_arg(ap, unsigned int);
+      }
+      ultoa(u, tmp, base);
+      if (c == 'X') {
+        strupr(tmp);
+      }
+    }
+    size_t len = strP ? strlen_P(str) : strlen(str);
+    uint8_t fill = (width > len) ? width - len : 0;
+    if (sign) {
+      fill = fill ? fill - 1 : 0;
+      if (pad == '0') {   // the sign goes before leading zeros, but after leading spaces.
+        printf_put(pb, sign);
+        count++;
+        sign = 0;
+      }
+    }
+    count += len + fill + (sign ? 1 : 0);
+    if (!left) {
+      while (fill) {
+        printf_put(pb, pad);
+        fill--;
+      }
+    }
+    if (sign) {
+      printf_put(pb, sign);
+    }
+    while (len--) {
+      printf_put(pb, strP ? pgm_read_byte(str++) : *str++);
+    }
+    while (fill) {
+      printf_put(pb, ' ');
+      fill--;
+    }
+  }
+  return count;
+}
+
+int16_t Print::iprintf(const char *format, ...) {
+  va_list ap;
+  printf_buffer_t pb;
+  pb.dest = this;
+  pb.len = 0;
+  va_start(ap, format);
+  int16_t ret = printf_int(&pb, format, false, ap);
+  va_end(ap);
+  printf_flush(&pb);
+  return ret;
+}
+
+int16_t Print::iprintf(const __FlashStringHelper *format, ...) {
+  va_list ap;
+  printf_buffer_t pb;
+  pb.dest = this;
+  pb.len = 0;
   va_start(ap, format);
-  return vfprintf_P(&f, (const char *)format, ap);
+  int16_t ret = printf_int(&pb, (const char *)format, true, ap);
+  va_end(ap);
+  printf_flush(&pb);
+  return ret;
 }
 
 // Private Methods /////////////////////////////////////////////////////////////
@@ -222,6 +416,22 @@ size_t Print::printNumber(unsigned long n, uint8_t base) {
   if (base < 2) {
     base = 10;
   }
+  if (base == 10) {
+    return write(buf, fast_utoa10(n, buf));
+  }
+  if (base == 16) {
+    return write(buf, fast_utoa16(n, buf, 1));
+  }
+  if (!(base & (base - 1))) {     // 2, 4, 8, 32... shift instead of dividing.
+    uint8_t shift = __builtin_ctz(base);
+    uint8_t mask = base - 1;
+    do {
+      char c = (uint8_t) n & mask;
+      n >>= shift;
+      *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+    return write(str);
+  }
 
   do {
     char c = n % base;
@@ -255,6 +465,38 @@ size_t Print::printFloat(double number, uint8_t digits) {
     number = -number;
   }
 
+  // Split it into the integer part and the fraction, as 32-bit fixed point - both exact - and round the fraction to
+  // the requested digits with integer math, instead of pulling the digits out with a double multiply and subtract
+  // each. Scaling the whole number by 10^digits in a double (which is a float here) would lose digits above 2^24.
+  if (digits <= 9) {
+    unsigned long int_part = (unsigned long)number;
+    double frac = (number - (double)int_part) * 4294967296.0;
+    unsigned long frac32 = (unsigned long)frac;
+    if ((double)frac32 == frac) {   // not if the fraction has bits below 2^-32 - then the old way does better
+      static const unsigned long powers_of_ten[10] PROGMEM = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+      unsigned long scale = pgm_read_dword(&powers_of_ten[digits]);
+      unsigned long frac_part = ((uint64_t)frac32 * scale + 0x80000000UL) >> 32;
+      if (frac_part >= scale) {     // rounded up into the integer part
+        frac_part -= scale;
+        int_part++;
+      }
+      if (int_part < 2147483647UL / scale) {
+        return n + printFixed((long)(int_part * scale + frac_part), digits);
+      }
+      n += print(int_part);
+      if (digits > 0) {
+        char buf[10];
+        buf[0] = '.';
+        for (uint8_t i = digits; i > 0; i--) {
+          buf[i] = '0' + frac_part % 10;
+          frac_part /= 10;
+        }
+        n += write(buf, digits + 1);
+      }
+      return n;
+    }
+  }
+
   // Round correctly so that print(1.999, 2) prints as "2.00"
   double rounding = 0.5;
   for (uint8_t i = 0; i < digits; ++i) {
@@ -75,6 +75,8 @@ class Print {
     size_t print(unsigned long, int = DEC);
     size_t print(double, int = 2);
     size_t print(const Printable &);
+    // value / 10^decimals, without any floating point: printFixed(-1234, 2) prints -12.34
+    size_t printFixed(long value, uint8_t decimals);
 
     size_t println(const __FlashStringHelper *);
     size_t println(const String &s);
@@ -87,10 +89,14 @@ class Print {
     size_t println(unsigned long, int = DEC);
     size_t println(double, int = 2);
     size_t println(const Printable &);
+    size_t printlnFixed(long value, uint8_t decimals);
     size_t println(void);
 
     int16_t printf(const char *format, ...) __attribute__ ((format (printf, 2, 3)));
     int16_t printf(const __FlashStringHelper *format, ...);
+    // Integers, characters and strings only (no floats, no vfprintf), see Print.cpp for what it understands.
+    int16_t iprintf(const char *format, ...) __attribute__ ((format (printf, 2, 3)));
+    int16_t iprintf(const __FlashStringHelper *format, ...);
 
     virtual void flush() { /* Empty implementation for backward compatibility */ }
 };
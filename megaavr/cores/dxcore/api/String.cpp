@@ -21,6 +21,7 @@
 
 #include "String.h"
 #include "itoa.h"
+#include "num_fast.h"
 #include "deprecated-avr-comp/avr/dtostrf.h"
 
 /*********************************************/
@@ -66,35 +67,55 @@ String::String(char c) {
 String::String(unsigned char value, unsigned char base) {
   init();
   char buf[1 + 8 * sizeof(unsigned char)];
-  utoa(value, buf, base);
+  if (base == 10) {
+    fast_utoa10(value, buf);
+  } else {
+    utoa(value, buf, base);
+  }
   *this = buf;
 }
 
 String::String(int value, unsigned char base) {
   init();
   char buf[2 + 8 * sizeof(int)];
-  itoa(value, buf, base);
+  if (base == 10) {
+    fast_ltoa10(value, buf);
+  } else {
+    itoa(value, buf, base);
+  }
   *this = buf;
 }
 
 String::String(unsigned int value, unsigned char base) {
   init();
   char buf[1 + 8 * sizeof(unsigned int)];
-  utoa(value, buf, base);
+  if (base == 10) {
+    fast_utoa10(value, buf);
+  } else {
+    utoa(value, buf, base);
+  }
   *this = buf;
 }
 
 String::String(long value, unsigned char base) {
   init();
   char buf[2 + 8 * sizeof(long)];
-  ltoa(value, buf, base);
+  if (base == 10) {
+    fast_ltoa10(value, buf);
+  } else {
+    ltoa(value, buf, base);
+  }
   *this = buf;
 }
 
 String::String(unsigned long value, unsigned char base) {
   init();
   char buf[1 + 8 * sizeof(unsigned long)];
-  ultoa(value, buf, base);
+  if (base == 10) {
+    fast_utoa10(value, buf);
+  } else {
+    ultoa(value, buf, base);
+  }
   *this = buf;
 }
 
@@ -290,32 +311,27 @@ unsigned char String::concat(char c) {
 
 unsigned char String::concat(unsigned char num) {
   char buf[1 + 3 * sizeof(unsigned char)];
-  itoa(num, buf, 10);
-  return concat(buf, strlen(buf));
+  return concat(buf, fast_utoa10(num, buf));
 }
 
 unsigned char String::concat(int num) {
   char buf[2 + 3 * sizeof(int)];
-  itoa(num, buf, 10);
-  return concat(buf, strlen(buf));
+  return concat(buf, fast_ltoa10(num, buf));
 }
 
 unsigned char String::concat(unsigned int num) {
   char buf[1 + 3 * sizeof(unsigned int)];
-  utoa(num, buf, 10);
-  return concat(buf, strlen(buf));
+  return concat(buf, fast_utoa10(num, buf));
 }
 
 unsigned char String::concat(long num) {
   char buf[2 + 3 * sizeof(long)];
-  ltoa(num, buf, 10);
-  return concat(buf, strlen(buf));
+  return concat(buf, fast_ltoa10(num, buf));
 }
 
 unsigned char String::concat(unsigned long num) {
   char buf[1 + 3 * sizeof(unsigned long)];
-  ultoa(num, buf, 10);
-  return concat(buf, strlen(buf));
+  return concat(buf, fast_utoa10(num, buf));
 }
 
 unsigned char String::concat(float num) {
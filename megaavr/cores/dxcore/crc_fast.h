@@ -0,0 +1,105 @@
+/* crc_fast.h - table driven CRC8 (SMBus PEC), CRC16 (Modbus) and CRC32 for DxCore
+ * Part of DxCore - this is free software (LGPL 2.1), see LICENSE.md
+ *
+ * Every algorithm comes in two sizes: the full table versions use one lookup per byte
+ * (256 bytes of flash for CRC8, 512 for CRC16, 1k for CRC32), and the _nibble versions
+ * use two lookups per byte in a 16 entry table. The tables are in PROGMEM and read
+ * with LPM, which works on every part regardless of FLMAP; only the tables for
+ * functions that are actually used end up in the binary.
+ *
+ * The multi-byte tables are stored as separate byte-wide tables (lo, hi, ...), so that
+ * the index is never multiplied and each byte of the result is one lpm straight into
+ * the register it is xored with.
+ *
+ * The update functions take the running CRC and the next byte, so they can be called
+ * as bytes are sent or received; the block functions do the same thing over a buffer.
+ * The update functions work on the raw CRC register: start from the _INIT value, and for
+ * CRC32 invert the result at the end. The crc32() block function does the inversion
+ * itself, like zlib: start with 0 and pass the previous result to continue.
+ *
+ *  | Function             | Polynomial       | Init       | Used by                      |
+ *  |----------------------|------------------|------------|------------------------------|
+ *  | crc8_smbus           | 0x07             | 0x00       | SMBus PEC, many sensors      |
+ *  | crc16_modbus         | 0x8005 reflected | 0xFFFF     | Modbus RTU (low byte first)  |
+ *  | crc32                | 0x04C11DB7 refl. | 0xFFFFFFFF | Ethernet, zip, etc           |
+ *
+ * Running the CRC over a message *and* its crc8_smbus or crc16_modbus checksum leaves 0
+ * if the message is intact.
+ ****************************************************************/
+#ifndef CRC_FAST_H
+#define CRC_FAST_H
+#include <stdint.h>
+#include <stddef.h>
+#include <avr/pgmspace.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const uint8_t  crc8_smbus_table[256] PROGMEM;
+extern const uint8_t  crc8_smbus_nibble_table[16] PROGMEM;
+extern const uint8_t  crc16_modbus_table_lo[256] PROGMEM;
+extern const uint8_t  crc16_modbus_table_hi[256] PROGMEM;
+extern const uint16_t crc16_modbus_nibble_table[16] PROGMEM;
+extern const uint8_t  crc32_table_0[256] PROGMEM;
+extern const uint8_t  crc32_table_1[256] PROGMEM;
+extern const uint8_t  crc32_table_2[256] PROGMEM;
+extern const uint8_t  crc32_table_3[256] PROGMEM;
+extern const uint32_t crc32_nibble_table[16] PROGMEM;
+
+#define CRC8_SMBUS_INIT   (0x00)
+#define CRC16_MODBUS_INIT (0xFFFF)
+#define CRC32_INIT        (0xFFFFFFFFUL)
+
+static inline uint8_t crc8_smbus_update(uint8_t crc, uint8_t data) {
+  return pgm_read_byte(&crc8_smbus_table[crc ^ data]);
+}
+
+static inline uint8_t crc8_smbus_update_nibble(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  crc = (crc << 4) ^ pgm_read_byte(&crc8_smbus_nibble_table[crc >> 4]);
+  return (crc << 4) ^ pgm_read_byte(&crc8_smbus_nibble_table[crc >> 4]);
+}
+
+static inline uint16_t crc16_modbus_update(uint16_t crc, uint8_t data) {
+  uint8_t idx = ((uint8_t) crc) ^ data;
+  uint8_t lo  = ((uint8_t)(crc >> 8)) ^ pgm_read_byte(&crc16_modbus_table_lo[idx]);
+  uint8_t hi  = pgm_read_byte(&crc16_modbus_table_hi[idx]);
+  return (((uint16_t) hi) << 8) | lo;
+}
+
+static inline uint16_t crc16_modbus_update_nibble(uint16_t crc, uint8_t data) {
+  crc ^= data;
+  crc = (crc >> 4) ^ pgm_read_word(&crc16_modbus_nibble_table[crc & 0x0F]);
+  return (crc >> 4) ^ pgm_read_word(&crc16_modbus_nibble_table[crc & 0x0F]);
+}
+
+static inline uint32_t crc32_update(uint32_t crc, uint8_t data) {
+  union {
+    uint32_t val;
+    uint8_t  b[4];
+  } c;
+  c.val = crc;
+  uint8_t idx = c.b[0] ^ data;
+  c.b[0] = c.b[1] ^ pgm_read_byte(&crc32_table_0[idx]);
+  c.b[1] = c.b[2] ^ pgm_read_byte(&crc32_table_1[idx]);
+  c.b[2] = c.b[3] ^ pgm_read_byte(&crc32_table_2[idx]);
+  c.b[3] =          pgm_read_byte(&crc32_table_3[idx]);
+  return c.val;
+}
+
+static inline uint32_t crc32_update_nibble(uint32_t crc, uint8_t data) {
+  crc ^= data;
+  crc = (crc >> 4) ^ pgm_read_dword(&crc32_nibble_table[crc & 0x0F]);
+  return (crc >> 4) ^ pgm_read_dword(&crc32_nibble_table[crc & 0x0F]);
+}
+
+// Block versions: pass the _INIT value (0 for crc32) to start, or a previous result to continue.
+uint8_t  crc8_smbus(uint8_t crc, const void *data, size_t length);
+uint16_t crc16_modbus(uint16_t crc, const void *data, size_t length);
+uint32_t crc32(uint32_t crc, const void *data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,129 @@
+/* num_fast.c - integer to decimal/hex and fixed point to decimal conversion for DxCore
+ * Part of DxCore - this is free software (LGPL 2.1), see LICENSE.md
+ * See num_fast.h for what these do and how.
+ ****************************************************************/
+#include <avr/pgmspace.h>
+#include "num_fast.h"
+
+static const char digit_pairs[200] PROGMEM =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+/* Hacker's Delight divu10: q is at most one too small, which the remainder tells us. */
+static inline uint32_t divmod10(uint32_t n, uint8_t *rem) {
+  uint32_t q = (n >> 1) + (n >> 2);
+  q += q >> 4;
+  q += q >> 8;
+  q += q >> 16;
+  q >>= 3;
+  uint8_t r = (uint8_t) n - (uint8_t)((uint8_t) q * 10);  // r < 20, so the low byte is all we need.
+  if (r > 9) {
+    q++;
+    r -= 10;
+  }
+  *rem = r;
+  return q;
+}
+
+/* Writes the digits of n so that the last one is just before end, and returns a pointer to the first. */
+static char *utoa10_backwards(uint32_t n, char *end) {
+  char *p = end;
+  while (n > 0xFFFF) {
+    uint8_t r;
+    n = divmod10(n, &r);
+    *--p = '0' + r;
+  }
+  uint16_t x = n;
+  while (x >= 100) {
+    uint16_t q = ((uint32_t)(x >> 2) * 0x147B) >> 17;   // x / 100, exact for all 16-bit x
+    uint8_t r = x - q * 100;
+    p -= 2;
+    p[0] = pgm_read_byte(&digit_pairs[2 * r]);
+    p[1] = pgm_read_byte(&digit_pairs[2 * r + 1]);
+    x = q;
+  }
+  if (x >= 10) {
+    p -= 2;
+    p[0] = pgm_read_byte(&digit_pairs[2 * x]);
+    p[1] = pgm_read_byte(&digit_pairs[2 * x + 1]);
+  } else {
+    *--p = '0' + x;
+  }
+  return p;
+}
+
+static uint8_t copy_out(const char *from, const char *end, char *buf) {
+  uint8_t len = end - from;
+  for (uint8_t i = 0; i < len; i++) {
+    buf[i] = from[i];
+  }
+  buf[len] = 0;
+  return len;
+}
+
+uint8_t fast_utoa10(uint32_t value, char *buf) {
+  char tmp[10];
+  return copy_out(utoa10_backwards(value, tmp + 10), tmp + 10, buf);
+}
+
+uint8_t fast_ltoa10(int32_t value, char *buf) {
+  if (value < 0) {
+    *buf = '-';
+    return fast_utoa10(-(uint32_t) value, buf + 1) + 1;
+  }
+  return fast_utoa10(value, buf);
+}
+
+uint8_t fast_utoa16(uint32_t value, char *buf, uint8_t uppercase) {
+  char tmp[8];
+  char *p = tmp + 8;
+  char a = uppercase ? 'A' - 10 : 'a' - 10;
+  do {
+    uint8_t d = (uint8_t) value & 0x0F;
+    *--p = d + (d < 10 ? '0' : a);
+    value >>= 4;
+  } while (value);
+  return copy_out(p, tmp + 8, buf);
+}
+
+uint8_t fast_fixtoa(int32_t value, uint8_t decimals, char *buf) {
+  char tmp[11];                     // 10 digits, plus the leading 0 of 0.xxxxxxxxx
+  char *end = tmp + 11;
+  uint8_t neg = 0;
+  uint32_t n = value;
+  if (value < 0) {
+    neg = 1;
+    n = -n;
+  }
+  if (decimals > 9) {
+    decimals = 9;
+  }
+  char *p = utoa10_backwards(n, end);
+  while (end - p <= decimals) {     // zero pad so there's at least one digit before the point.
+    *--p = '0';
+  }
+  char *out = buf;
+  if (neg) {
+    *out++ = '-';
+  }
+  char *point = end - decimals;
+  while (p < point) {
+    *out++ = *p++;
+  }
+  if (decimals) {
+    *out++ = '.';
+    while (p < end) {
+      *out++ = *p++;
+    }
+  }
+  *out = 0;
+  return out - buf;
+}
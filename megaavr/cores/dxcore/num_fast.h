@@ -0,0 +1,35 @@
+/* num_fast.h - integer to decimal/hex and fixed point to decimal conversion for DxCore
+ * Part of DxCore - this is free software (LGPL 2.1), see LICENSE.md
+ *
+ * The AVR has no divide instruction, so ultoa(n, buf, 10) or print(n) does a 32-bit
+ * software division (hundreds of clocks) for every digit. These don't divide at all:
+ *  * While the value is over 16 bits, digits come off one at a time with the shift-and-add
+ *    divide by 10 from Hacker's Delight (divu10), which is exact for every 32-bit value.
+ *  * Once it fits in 16 bits, two digits at a time: x / 100 is a 16 x 16 multiply by the
+ *    reciprocal, and the remainder indexes a 200 byte table of digit pairs in PROGMEM.
+ *  * Hex is just nybbles.
+ *
+ * All of them write a null terminated string to buf and return its length (not counting the
+ * terminator). Buffers must be big enough for the worst case: 11 bytes for fast_utoa10,
+ * 12 for fast_ltoa10, 9 for fast_utoa16, and 13 for fast_fixtoa.
+ *
+ * fast_fixtoa prints a fixed point value: value / 10^decimals, so fast_fixtoa(-1234, 2, buf)
+ * gives "-12.34" and fast_fixtoa(5, 3, buf) gives "0.005". decimals can be 0 to 9.
+ ****************************************************************/
+#ifndef NUM_FAST_H
+#define NUM_FAST_H
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint8_t fast_utoa10(uint32_t value, char *buf);
+uint8_t fast_ltoa10(int32_t value, char *buf);
+uint8_t fast_utoa16(uint32_t value, char *buf, uint8_t uppercase);
+uint8_t fast_fixtoa(int32_t value, uint8_t decimals, char *buf);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
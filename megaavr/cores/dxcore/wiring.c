@@ -464,6 +464,108 @@ inline uint32_t microsecondsToClockCycles(const uint32_t microseconds) {
 
 
   #if !defined(MILLIS_USE_TIMERRTC)
+    /* Reciprocal multiply for converting timer ticks to microseconds
+     *
+     * For every combination of F_CPU and millis timer that doesn't have a hand-tuned (or trivial) conversion
+     * in micros(), we instead multiply the ticks by a 16-bit fixed point approximation of the number of
+     * microseconds per tick, and keep only the high bits. That's 4 hardware multiplies, which is faster than
+     * all but the shortest of the shift-and-add series, and it's accurate to within a fraction of a
+     * microsecond at every clock speed, instead of only at the ones someone sat down with a spreadsheet for.
+     *
+     * MICROS_RECIP_SHIFT is the largest shift that keeps the multiplier in 16 bits, and MICROS_RECIP_MULT
+     * is (us per tick) << MICROS_RECIP_SHIFT, rounded UP. Rounding up means that a tick count that lands
+     * exactly on a microsecond boundary is never truncated to the one before it; the excess this introduces
+     * is less than ticks / 2^MICROS_RECIP_SHIFT, which is under 1/32 us for any timer configuration we use.
+     * This is all done by the preprocessor, so each F_CPU gets its own pair of constants at compile time and
+     * nothing is calculated at runtime. Since the multiplier is constant, the result is monotonic in ticks,
+     * so it can never send time backwards, and the check below ensures that the highest tick count can't
+     * reach the next overflow's worth of microseconds either.
+     *
+     * Since we only want the high word of the product, the ticks are leftshifted first if the shift is under
+     * 16 (only with the 8-bit TCA tick counts), and the high word is rightshifted after if it's over 16.
+     */
+    #define _MICROS_RECIP(s) ((((TIME_TRACKING_TIMER_DIVIDER * 1000000ULL) << (s)) + (F_CPU) - 1) / (F_CPU))
+    #if   (_MICROS_RECIP(22) < 0x10000)
+      #define MICROS_RECIP_SHIFT      (22)
+    #elif (_MICROS_RECIP(21) < 0x10000)
+      #define MICROS_RECIP_SHIFT      (21)
+    #elif (_MICROS_RECIP(20) < 0x10000)
+      #define MICROS_RECIP_SHIFT      (20)
+    #elif (_MICROS_RECIP(19) < 0x10000)
+      #define MICROS_RECIP_SHIFT      (19)
+    #elif (_MICROS_RECIP(18) < 0x10000)
+      #define MICROS_RECIP_SHIFT      (18)
+    #elif (_MICROS_RECIP(17) < 0x10000)
+      #define MICROS_RECIP_SHIFT      (17)
+    #elif (_MICROS_RECIP(16) < 0x10000)
+      #define MICROS_RECIP_SHIFT      (16)
+    #elif (_MICROS_RECIP(15) < 0x10000)
+      #define MICROS_RECIP_SHIFT      (15)
+    #elif (_MICROS_RECIP(14) < 0x10000)
+      #define MICROS_RECIP_SHIFT      (14)
+    #elif (_MICROS_RECIP(13) < 0x10000)
+      #define MICROS_RECIP_SHIFT      (13)
+    #elif (_MICROS_RECIP(12) < 0x10000)
+      #define MICROS_RECIP_SHIFT      (12)
+    #else
+      #error "Millis timer prescaler is too large relative to F_CPU for micros() to convert ticks to microseconds"
+    #endif
+    #define MICROS_RECIP_MULT         (_MICROS_RECIP(MICROS_RECIP_SHIFT))
+    #if (MICROS_RECIP_SHIFT >= 16)
+      #define MICROS_RECIP_PRESHIFT   (0)
+      #define MICROS_RECIP_POSTSHIFT  (MICROS_RECIP_SHIFT - 16)
+    #else
+      #define MICROS_RECIP_PRESHIFT   (16 - MICROS_RECIP_SHIFT)
+      #define MICROS_RECIP_POSTSHIFT  (0)
+    #endif
+    #if ((TIME_TRACKING_TICKS_PER_OVF << MICROS_RECIP_PRESHIFT) > 0x10000)
+      #error "Millis timer ticks per overflow too large for the micros() reciprocal conversion"
+    #endif
+    #if (((((TIME_TRACKING_TICKS_PER_OVF - 1) * MICROS_RECIP_MULT) >> MICROS_RECIP_SHIFT) * (F_CPU)) >= (TIME_TRACKING_CYCLES_PER_OVF * 1000000ULL))
+      #error "micros() reciprocal conversion would overshoot the timer period - time would travel backwards"
+    #endif
+
+    static inline __attribute__((always_inline)) uint32_t _umul16x16(uint16_t a, uint16_t b) {
+      uint32_t product;
+      /* 16 x 16 -> 32 bit unsigned multiply. The compiler would call __umulhisi3 for this, which is the same
+       * thing plus the call overhead and a couple of extra moves. 14 words, 18 clocks.                     */
+      __asm__ __volatile__(
+        "mul  %A1, %A2"   "\n\t" // low x low
+        "movw %A0, r0"    "\n\t"
+        "mul  %B1, %B2"   "\n\t" // high x high
+        "movw %C0, r0"    "\n\t"
+        "mul  %B1, %A2"   "\n\t" // high x low, into the middle bytes
+        "add  %B0, r0"    "\n\t"
+        "adc  %C0, r1"    "\n\t"
+        "eor  r1,  r1"    "\n\t" // need a known zero to carry with
+        "adc  %D0, r1"    "\n\t"
+        "mul  %A1, %B2"   "\n\t" // low x high, into the middle bytes
+        "add  %B0, r0"    "\n\t"
+        "adc  %C0, r1"    "\n\t"
+        "eor  r1,  r1"    "\n\t" // restore zero_reg
+        "adc  %D0, r1"    "\n"
+        : "=&r" (product)
+        : "r" (a), "r" (b));
+      return product;
+    }
+
+    __attribute__((unused)) static inline __attribute__((always_inline)) uint16_t _ticksToMicros(uint16_t ticks) {
+      uint32_t product = _umul16x16(ticks << MICROS_RECIP_PRESHIFT, (uint16_t) MICROS_RECIP_MULT);
+      return ((uint16_t)(product >> 16)) >> MICROS_RECIP_POSTSHIFT;
+    }
+
+    #if defined(MILLIS_USE_TCB)
+      /* When setCPUFrequency() changes the clock, the TCB period is changed so that an overflow is still
+       * the same length of time, which means the tick count no longer means what the constants above (or
+       * the hand-tuned conversions in micros()) think it does. setCPUFrequency() calculates a replacement
+       * multiplier and shift the same way the preprocessor does, and micros() uses that whenever
+       * _microsRuntimeMult is nonzero. If the clock is put back to F_CPU, it's zeroed again, and we're back
+       * on the fast path. If setCPUFrequency() is never called, this is never written, and with LTO the
+       * compiler can see that and throw out the runtime path entirely.                                    */
+      static uint16_t _microsRuntimeMult  = 0;
+      static uint8_t  _microsRuntimeShift = 0;
+    #endif
+
     unsigned long micros() {
       uint32_t overflows, microseconds;
       #if (defined(MILLIS_USE_TCD) || defined(MILLIS_USE_TCB))
@@ -540,6 +642,9 @@ inline uint32_t microsecondsToClockCycles(const uint32_t microseconds) {
         #endif
       */
       #if defined(MILLIS_USE_TCB)
+        if (_microsRuntimeMult) { // the clock has been changed by setCPUFrequency(), so none of the below apply.
+          return overflows * 1000 + (uint16_t)(_umul16x16(ticks, _microsRuntimeMult) >> _microsRuntimeShift);
+        }
         /* Ersatz Division for TCBs - now with inline assembly!
          *
          * It's well known that division is an operator you want to avoid like the plague on AVR.
@@ -620,29 +725,9 @@ inline uint32_t microsecondsToClockCycles(const uint32_t microseconds) {
          * where we calculate overflows * 1000, the (now 0-999) ticks to it, and return it.
          *
          */
-          // Oddball clock speeds
-        #if   (F_CPU == 44000000UL) // Extreme overclocking
-          ticks = ticks >> 4;
-          microseconds = overflows * 1000 + (ticks - /* (ticks >> 1)  + */ (ticks >> 2) - (ticks >> 5) + /* (ticks >> 6) - */ (ticks >> 7)); // + (ticks >> 10)
-        #elif (F_CPU == 36000000UL) // 50% overclock!
-          ticks = ticks >> 4;
-          microseconds = overflows * 1000 + (ticks - (ticks >> 3) + (ticks >> 6)); // - (ticks >> 9) + (ticks >> 10) // with 5 terms it is DEAD ON
-        #elif (F_CPU == 28000000UL) // Not supported by DxCore - nobody wants it.
-          ticks = ticks >> 4;
-          microseconds = overflows * 1000 + (ticks + (ticks >> 2) - (ticks >> 3) + (ticks >> 5) - (ticks >> 6)); // + (ticks >> 8) - (ticks >> 9)
-        #elif (F_CPU == 14000000UL) // Not supported by DxCore - nobody wants it.
-          ticks = ticks >> 3;
-          microseconds = overflows * 1000 + (ticks + (ticks >> 2) - (ticks >> 3) + (ticks >> 5) - (ticks >> 6)); // + (ticks >> 8) - (ticks >> 9)
-        #elif (F_CPU == 30000000UL) // Easy overclock
-          ticks = ticks >> 4;
-          microseconds = overflows * 1000 + (ticks + (ticks >> 3) - (ticks >> 4) + (ticks >> 7) - (ticks >> 8)); // 5 terms is the optimal. Good but not as close as we get for most.
-        #elif (F_CPU == 27000000UL) // You'd think this one would be a flaming bitch right?
-          ticks = ticks >> 4;
-          microseconds = overflows * 1000 + (ticks + (ticks >> 2) - (ticks >> 4) - (ticks >> 9)); // +0.1 average error with only 4 terms, minimal scatter... that's just not supposed to happen!
-        #elif (F_CPU == 25000000UL) // Barely overclocked.
-          ticks = ticks >> 4;
-          microseconds = overflows * 1000 + (ticks + /* (ticks >> 1) -*/ (ticks >> 2) + /* (ticks >> 4) -*/ (ticks >> 5)); // DEAD ON with 5 terms
-
+          /* Oddball clock speeds (44, 36, 30, 28, 27, 25, 14, 7 MHz, etc) no longer get their own
+           * shift-and-add series - they fall through to the reciprocal multiply at the end of this
+           * chain, which is both faster and more accurate than the series we had for them.      */
         /* The Terrible Twelves (or threes) - Twelve may be a great number in a lot of ways... but here, it's actually 3 in disguise.
          * NINE TERMS in the damned bitshift division expansion. And the result isn't even amazing. - it's worse than what can be done
          * with just 5 terms for dividing by 36 or 25, or a mere 3 terms with 27... where you're dividing by 9, 12.5, and 13.5 respectively,
@@ -667,7 +752,7 @@ inline uint32_t microsecondsToClockCycles(const uint32_t microseconds) {
          * 67 replaced with 32 save 35 clocks @ 24 = 1.5us saved
          * 77 replaced with 34 save 43 clocks @ 48 = 1 us saved
          */
-        #elif (F_CPU == 48000000UL || F_CPU == 24000000UL || F_CPU == 12000000UL || F_CPU == 6000000UL || F_CPU == 3000000UL)
+        #if   (F_CPU == 48000000UL || F_CPU == 24000000UL || F_CPU == 12000000UL || F_CPU == 6000000UL || F_CPU == 3000000UL)
           __asm__ __volatile__(
             "movw r0,%A0"   "\n\t" // we copy ticks to r0 (temp_reg) and r1 (zero_reg) so we don't need to allocate more registers.
             "lsr r1"        "\n\t" // notice how at first, each shift takes insns. Compiler wants to use an upper register, ldi number of shifts
@@ -806,31 +891,21 @@ inline uint32_t microsecondsToClockCycles(const uint32_t microseconds) {
           microseconds = overflows * 1000 + (ticks - (ticks >> 2) + (ticks >> 4) - (ticks >> 6)); // + (ticks >> 8)
         */
 
-        // powers of 2  - and a catchall for parts without dedicated implementations. It gives wrong results, but
-        // it also doesn't take forever like doing division would.
-        #elif (F_CPU  == 32000000UL || F_CPU > 24000000UL)
+        // powers of 2 - these are just a shift.
+        #elif (F_CPU  == 32000000UL)
           microseconds = overflows * 1000 + (ticks >> 4);
-        #elif (F_CPU  == 16000000UL || F_CPU > 12000000UL)
+        #elif (F_CPU  == 16000000UL)
           microseconds = overflows * 1000 + (ticks >> 3);
-        #elif (F_CPU  ==  8000000UL || F_CPU >  6000000UL)
+        #elif (F_CPU  ==  8000000UL)
           microseconds = overflows * 1000 + (ticks >> 2);
-        #elif (F_CPU  ==  4000000UL || F_CPU >= 3000000UL)
+        #elif (F_CPU  ==  4000000UL)
           microseconds = overflows * 1000 + (ticks >> 1);
-        #else //(F_CPU == 1000000UL || F_CPU == 2000000UL) - here clock is running at system clock instead of half system clock.
+        #elif (F_CPU == 1000000UL || F_CPU == 2000000UL) // here clock is running at system clock instead of half system clock.
               // and hence overflows only once per 2ms. On 2 MHz
               // also works at 2MHz, since we use CLKPER for 1MHz vs CLKPER/2 for all others.
           microseconds   = overflows * 1000 + ticks;
-        #endif
-        #if !((F_CPU == 48000000UL || F_CPU == 36000000UL || F_CPU == 24000000UL || F_CPU == 12000000UL || /* multiples of 12           */ \
-               F_CPU == 40000000UL || F_CPU == 30000000UL || F_CPU == 20000000UL || F_CPU == 10000000UL || /* multiples of 10           */ \
-               F_CPU == 32000000UL || F_CPU == 16000000UL || F_CPU ==  8000000UL || F_CPU ==  4000000UL || /* powers of 2               */ \
-               F_CPU ==  2000000UL || F_CPU ==  1000000UL || F_CPU == 25000000UL || F_CPU ==  5000000UL || /* powers of 2 cont, 25, 5   */ \
-               F_CPU == 44000000UL || F_CPU == 28000000UL || F_CPU == 14000000UL || F_CPU ==  3000000UL || /* oddball frequencies       */ \
-               F_CPU == 27000000UL)&& /* warn fools who messed with the timers.h file too and expected that the core would sort out how */ \
-              ((TIME_TRACKING_TIMER_DIVIDER == 2 && TIME_TRACKING_TICKS_PER_OVF == F_CPU/2000) || /*how to make the timer work correctly*/ \
-               (TIME_TRACKING_TIMER_DIVIDER == 1 && (TIME_TRACKING_TICKS_PER_OVF == F_CPU/500 && F_CPU == 1000000) || (TIME_TRACKING_TICKS_PER_OVF == F_CPU/1000 && F_CPU == 2000000))))
-                                                   /*  without them implementing it. No such luck  */
-          #warning "Millis timer (TCBn) at this frequency and/or configuration unsupported, micros() will return totally bogus values."
+        #else // Everything else - see _ticksToMicros() above.
+          microseconds   = overflows * 1000 + _ticksToMicros(ticks);
         #endif
       #else /* = defined(MILLIS_USE_TCA) */
         __attribute__((unused)) uint8_t ticks_temp;  // As this is the case for TCA, ticks is always 8 bit
@@ -874,12 +949,8 @@ inline uint32_t microsecondsToClockCycles(const uint32_t microseconds) {
           ticks_acc += (ticks_temp = (ticks >> 2));       // (1/4)  1 tick = 6.25us  => 6.25us-6.27s =  -0.020us
           ticks_acc += (ticks_temp = (ticks_temp >> 4));  // (1/64) 1 tick = 6.266us => 6.266us-6.27s = -0.004us
           microseconds  = (overflows * clockCyclesToMicroseconds(TIME_TRACKING_CYCLES_PER_OVF)) + ticks_acc;
-        #else
-          #if (TIME_TRACKING_TIMER_DIVIDER%(F_CPU/1000000))
-            #warning "Millis timer (TCA) at this frequency unsupported, micros() will return bogus values."
-          #endif
-          microseconds = ((overflows * millisClockCyclesToMicroseconds(TIME_TRACKING_CYCLES_PER_OVF))
-                        + (ticks * (millisClockCyclesToMicroseconds(TIME_TRACKING_CYCLES_PER_OVF) / TIME_TRACKING_TIMER_PERIOD)));
+        #else // Any other speed or timer configuration - see _ticksToMicros() above.
+          microseconds  = (overflows * millisClockCyclesToMicroseconds(TIME_TRACKING_CYCLES_PER_OVF)) + _ticksToMicros(ticks);
         #endif
       #endif // end of timer-specific part of micros calculations
       return microseconds;
@@ -978,6 +1049,13 @@ inline __attribute__((always_inline)) void delayMicroseconds(unsigned int us) {
   if (__builtin_constant_p(us)) {
     _delay_us(us); // Constant microseconds use the avr-libc _delay_us() which is highly accurate for all values and efficient!
   } else { // If it is not, we have to use the Arduino style implementation.
+    if (__CPUFrequencyScale) {
+      /* setCPUFrequency() has changed the clock, and the loop below is counted out for F_CPU. The scale factor is
+       * new clock / F_CPU in 8.8 fixed point, so a longer loop count when running faster, and a shorter one when slower.
+       * Constant delays cannot be corrected this way - _delay_us() is expanded at compile time. */
+      uint32_t scaled = ((uint32_t) us * __CPUFrequencyScale) >> 8;
+      us = (scaled > 0xFFFF ? 0xFFFF : (unsigned int) scaled);
+    }
     _delayMicroseconds(us);
   }
 }
@@ -1652,6 +1730,7 @@ void  __attribute__((weak)) init_clock() {
     #else
       #error "F_CPU defined as an unsupported value for the internal oscillator."
     #endif
+    init_clock_tune();
   #elif (CLOCK_SOURCE == 1 || CLOCK_SOURCE == 2)
   /* For this, we don't really care what speed it is at - we will run at crystal frequency, and THE USER MUST TELL US WHAT THAT IS.
    * It is foolish to determine what we're running at at runtime, as the user should really knoe the basic parameters of the
@@ -1707,6 +1786,288 @@ void  __attribute__((weak)) init_clock() {
 }
 
 
+void __attribute__((weak)) init_clock_tune() {
+  return;
+}
+
+
+/******************************** RUNTIME CLOCK CHANGES ****************************************/
+/* setCPUFrequency() lets the clock be changed after startup - typically to drop down to a low     *
+ * speed between bursts of activity to save power, and go back up when there's work to do. The     *
+ * compile-time F_CPU is still what everything was calculated for at startup, and what the        *
+ * constant-folded paths still assume, so rather than trying to recalculate everything, we fix up  *
+ * the things that would otherwise break, with the ratio between the new clock and F_CPU:          *
+ *   millis timer - a TCB gets a new period so an overflow still takes the same amount of time,   *
+ *     and micros() switches to a runtime reciprocal. A TCA gets a new prescaler so that the ticks  *
+ *     come at the same rate, and nothing else needs to know (so the ratio must be a power of 2     *
+ *     that has a prescaler). TCA0/TCA1 get the same treatment for PWM if they're still ours.       *
+ *   USARTs that are enabled get their BAUD register scaled, swapping U2X on or off as needed.      *
+ *   Wire, if it's linked in, gets told to scale MBAUD, through the weak TWI_ClockChanged().        *
+ *   delayMicroseconds() with a non-constant argument scales the loop count.                        *
+ *   onClockChange() is called last, and can be overridden to deal with anything else.              *
+ * Not handled: constant delayMicroseconds() and delay() with millis disabled (_delay_us/_ms are   *
+ * expanded at compile time), clockCyclesPerMicrosecond() and friends, TCD0, the ADC clock          *
+ * prescaler, and anything a library or the sketch calculated from F_CPU on its own.                *
+ * Return values:                                                                                  *
+ *   0 - Success (or the clock was already at that speed).                                         *
+ *   1 - That frequency can't be generated from the current clock source.                          *
+ *   2 - The millis timer can't keep time at that frequency (including millis on TCD0).            *
+ ***********************************************************************************************/
+
+uint32_t __CPUFrequency      = F_CPU;
+uint16_t __CPUFrequencyScale = 0;
+
+void __attribute__((weak)) onClockChange(__attribute__((unused)) uint32_t oldfreq, __attribute__((unused)) uint32_t newfreq) {
+  return;
+}
+
+/* Wire supplies this if it's used; otherwise the weak reference is null and we skip it. */
+extern void TWI_ClockChanged(uint16_t oldkhz, uint16_t newkhz) __attribute__((weak));
+
+static const uint8_t _TCAPrescalers[] = {0, 1, 2, 3, 4, 6, 8, 10}; /* log2 of the TCA prescale for each CLKSEL value */
+
+/* Returns the CLKSEL value that would keep the TCA ticking at the same rate, or 0xFF if there isn't one */
+static uint8_t _TCAClkselFor(uint8_t clksel, uint32_t oldkhz, uint32_t newkhz) {
+  uint8_t log2 = _TCAPrescalers[clksel & 0x07];
+  while (oldkhz < newkhz) {
+    oldkhz <<= 1;
+    log2++;
+  }
+  while (newkhz < oldkhz) {
+    newkhz <<= 1;
+    log2--;                                         /* if it wraps, it won't match anything below */
+  }
+  if (oldkhz != newkhz) {
+    return 0xFF;                                    /* not a power of 2 ratio */
+  }
+  for (uint8_t i = 0; i < 8; i++) {
+    if (_TCAPrescalers[i] == log2) {
+      return i;
+    }
+  }
+  return 0xFF;
+}
+
+/* Scaling the BAUD register by the ratio each time would accumulate rounding error (and lose everything if it ever
+ * got clamped), so we remember what it was and what clock it was for, the first time we see it, and scale from that
+ * every time after, until begin() writes something else to it. The reference is in 8x oversampling (U2X) units so
+ * we can pick the mode the same way begin() does. */
+#if   defined(USART5)
+  #define _USART_COUNT 6
+#elif defined(USART4)
+  #define _USART_COUNT 5
+#elif defined(USART3)
+  #define _USART_COUNT 4
+#elif defined(USART2)
+  #define _USART_COUNT 3
+#else
+  #define _USART_COUNT 2
+#endif
+
+static struct {
+  uint16_t written;
+  uint16_t refkhz;
+  uint32_t ref;
+} _usartRef[_USART_COUNT];
+
+static uint32_t _scaleKhz(uint32_t val, uint16_t fromkhz, uint16_t tokhz) {
+  /* val * tokhz / fromkhz, rounded, without overflowing 32 bits or pulling in 64-bit math */
+  return (val / fromkhz) * tokhz + (((val % fromkhz) * tokhz + (fromkhz >> 1)) / fromkhz);
+}
+
+static void _rescaleUSART(volatile USART_t *usart, uint8_t idx, uint16_t oldkhz, uint16_t newkhz) {
+  uint8_t ctrlb = usart->CTRLB;
+  if (!(ctrlb & (USART_RXEN_bm | USART_TXEN_bm))) {
+    return;                                         /* Not in use - begin() will calculate it fresh anyway */
+  }
+  uint16_t baud = usart->BAUD;
+  uint8_t async = !(usart->CTRLC & USART_CMODE_gm);
+  if (baud != _usartRef[idx].written || _usartRef[idx].refkhz == 0) {
+    _usartRef[idx].refkhz = oldkhz;                 /* begin() has been called since we last touched it */
+    _usartRef[idx].ref    = ((async && !(ctrlb & USART_RXMODE_gm)) ? ((uint32_t) baud << 1) : baud);
+  }
+  uint32_t newbaud = _scaleKhz(_usartRef[idx].ref, _usartRef[idx].refkhz, newkhz);
+  if (async && !(ctrlb & USART_RXMODE_gm & ~USART_RXMODE0_bm)) { /* normal or U2X, not one of the autobaud modes */
+    if ((newbaud >> 1) >= 64) {                     /* Same rule as begin(): U2X only when it would be too fast without it */
+      ctrlb  &= ~USART_RXMODE0_bm;
+      newbaud = (newbaud + 1) >> 1;
+    } else {
+      ctrlb  |= USART_RXMODE0_bm;
+      if (newbaud < 64) {
+        newbaud = 64;                               /* as fast as it'll go, like begin() does */
+      }
+    }
+  }
+  if (newbaud > 0xFFFF) {
+    newbaud = 0xFFFF;
+  }
+  usart->BAUD  = (uint16_t) newbaud;
+  usart->CTRLB = ctrlb;
+  _usartRef[idx].written = (uint16_t) newbaud;
+}
+
+uint8_t setCPUFrequency(uint32_t hz) {
+  if (hz == __CPUFrequency) {
+    return 0;
+  }
+  if (hz % 1000) {
+    return 1;                                       /* every supported speed is a whole number of kHz */
+  }
+  /* Find an oscillator setting and prescaler that give that frequency. The prescaler is only used when the
+   * oscillator can't do it directly, as that uses less power than running the oscillator fast and dividing it.
+   * With an external clock or crystal, all we can do is prescale it. */
+  uint8_t prescale = 0, freqsel = 0xFF;
+  for (; prescale <= 6; prescale++) {
+    uint32_t base = hz << prescale;
+    #if CLOCK_SOURCE == 0
+      if (!(base % 1000000UL) && base <= 32000000UL) {
+        uint8_t mhz = base / 1000000UL;
+        if (mhz <= 4 && mhz != 0) {
+          freqsel = mhz - 1;                        /* 1, 2, 3, 4 MHz are 0x00 - 0x03 */
+        } else if (mhz == 8) {
+          freqsel = 0x05;
+        } else if (!(mhz % 4) && mhz >= 12) {
+          freqsel = mhz / 4 + 3;                    /* 12 through 32 MHz are 0x06 - 0x0B */
+        }
+      }
+    #else
+      if (base == F_CPU) {
+        freqsel = 0;
+      }
+    #endif
+    if (freqsel != 0xFF) {
+      break;
+    }
+  }
+  if (freqsel == 0xFF) {
+    return 1;
+  }
+  uint16_t oldkhz = __CPUFrequency / 1000;
+  uint16_t newkhz = hz / 1000;
+  /* Work out what we're going to do with the millis timer before touching anything, so that if it won't
+   * work, we can return an error with nothing changed. */
+  #if defined(MILLIS_USE_TIMERD0)
+    return 2;
+  #elif defined(MILLIS_USE_TCB)
+    uint32_t newperiod = (uint32_t) TIME_TRACKING_TICKS_PER_OVF * newkhz;
+    if (newperiod % (F_CPU / 1000)) {
+      return 2;                                     /* Overflow would not be a whole number of ticks */
+    }
+    newperiod /= (F_CPU / 1000);
+    if (newperiod > 0xFFFF || newperiod < 250) {
+      return 2;                                     /* Too slow for the timer or too fast for the ISR */
+    }
+    uint16_t mult = 0;
+    uint8_t shift = 0;
+    if (hz != F_CPU) {
+      /* Same thing the preprocessor does for MICROS_RECIP_MULT: largest shift that keeps the multiplier in 16 bits,
+       * rounded up, and then make sure the highest tick count can't reach the next overflow. */
+      const uint32_t us_per_ovf = MILLIS_INC * 1000UL;
+      shift = (us_per_ovf > 1000 ? 21 : 22);
+      uint32_t m;
+      while (1) {
+        m = ((us_per_ovf << shift) + newperiod - 1) / newperiod;
+        if (m <= 0xFFFF || shift == 8) {
+          break;
+        }
+        shift--;
+      }
+      if (m > 0xFFFF || ((((uint32_t) (newperiod - 1) * m) >> shift) >= us_per_ovf)) {
+        return 2;
+      }
+      mult = m;
+    }
+  #elif defined(MILLIS_USE_TIMERA0) || defined(MILLIS_USE_TIMERA1)
+    #if defined(MILLIS_USE_TIMERA0)
+      uint8_t millis_clksel = _TCAClkselFor((TCA0.SPLIT.CTRLA >> 1), oldkhz, newkhz);
+    #else
+      uint8_t millis_clksel = _TCAClkselFor((TCA1.SPLIT.CTRLA >> 1), oldkhz, newkhz);
+    #endif
+    if (millis_clksel == 0xFF) {
+      return 2;
+    }
+  #endif
+  uint8_t oldSREG = SREG;
+  cli();
+  /* Change the prescaler first if we're dividing by more, otherwise the oscillator first, so that we never pass
+   * through a speed faster than both the old and new one. */
+  uint8_t mclkctrlb = (prescale ? (((prescale - 1) << 1) | CLKCTRL_PEN_bm) : 0);
+  uint8_t oldprescale = CLKCTRL.MCLKCTRLB;
+  oldprescale = (oldprescale & CLKCTRL_PEN_bm) ? ((oldprescale >> 1) + 1) : 0; /* only ever set to powers of 2 here */
+  if (prescale > oldprescale) {
+    _PROTECTED_WRITE(CLKCTRL_MCLKCTRLB, mclkctrlb);
+  }
+  #if CLOCK_SOURCE == 0
+    _PROTECTED_WRITE(CLKCTRL_OSCHFCTRLA, ((CLKCTRL.OSCHFCTRLA & ~CLKCTRL_FREQSEL_gm) | (freqsel << 2))); /* keep autotune and runstandby */
+  #endif
+  if (prescale <= oldprescale) {
+    _PROTECTED_WRITE(CLKCTRL_MCLKCTRLB, mclkctrlb);
+  }
+  #if defined(MILLIS_USE_TCB)
+    /* Scale the count, too, so the fraction of a millisecond we were part way through isn't lost */
+    uint16_t oldperiod = _timer->CCMP + 1;
+    uint16_t newcount  = ((uint32_t) _timer->CNT * newperiod) / oldperiod;
+    _timer->CCMP       = newperiod - 1;
+    _timer->CNT        = newcount;
+    _microsRuntimeMult  = mult;
+    _microsRuntimeShift = shift;
+  #elif defined(MILLIS_USE_TIMERA0)
+    TCA0.SPLIT.CTRLA = (TCA0.SPLIT.CTRLA & ~TCA_SPLIT_CLKSEL_gm) | (millis_clksel << 1);
+  #elif defined(MILLIS_USE_TIMERA1)
+    TCA1.SPLIT.CTRLA = (TCA1.SPLIT.CTRLA & ~TCA_SPLIT_CLKSEL_gm) | (millis_clksel << 1);
+  #endif
+  /* PWM on TCAs we still own: keep the frequency the same if we can, otherwise it just scales with the clock */
+  #if !defined(MILLIS_USE_TIMERA0)
+    if (__PeripheralControl & TIMERA0) {
+      uint8_t clksel = _TCAClkselFor((TCA0.SPLIT.CTRLA >> 1), oldkhz, newkhz);
+      if (clksel != 0xFF) {
+        TCA0.SPLIT.CTRLA = (TCA0.SPLIT.CTRLA & ~TCA_SPLIT_CLKSEL_gm) | (clksel << 1);
+      }
+    }
+  #endif
+  #if defined(TCA1) && !defined(MILLIS_USE_TIMERA1)
+    if (__PeripheralControl & TIMERA1) {
+      uint8_t clksel = _TCAClkselFor((TCA1.SPLIT.CTRLA >> 1), oldkhz, newkhz);
+      if (clksel != 0xFF) {
+        TCA1.SPLIT.CTRLA = (TCA1.SPLIT.CTRLA & ~TCA_SPLIT_CLKSEL_gm) | (clksel << 1);
+      }
+    }
+  #endif
+  #if defined(USART0)
+    _rescaleUSART(&USART0, 0, oldkhz, newkhz);
+  #endif
+  #if defined(USART1)
+    _rescaleUSART(&USART1, 1, oldkhz, newkhz);
+  #endif
+  #if defined(USART2)
+    _rescaleUSART(&USART2, 2, oldkhz, newkhz);
+  #endif
+  #if defined(USART3)
+    _rescaleUSART(&USART3, 3, oldkhz, newkhz);
+  #endif
+  #if defined(USART4)
+    _rescaleUSART(&USART4, 4, oldkhz, newkhz);
+  #endif
+  #if defined(USART5)
+    _rescaleUSART(&USART5, 5, oldkhz, newkhz);
+  #endif
+  uint32_t oldfreq = __CPUFrequency;
+  __CPUFrequency = hz;
+  if (hz == F_CPU) {
+    __CPUFrequencyScale = 0;
+  } else {
+    uint16_t scale = ((uint32_t) newkhz << 8) / (F_CPU / 1000);
+    __CPUFrequencyScale = (scale ? scale : 1);
+  }
+  SREG = oldSREG;
+  if (TWI_ClockChanged) {
+    TWI_ClockChanged(oldkhz, newkhz);
+  }
+  onClockChange(oldfreq, hz);
+  return 0;
+}
+
+
 /********************************* CLOCK FAILURE HANDLING **************************************/
 /*                                                                                             *
  * These are used for blink codes which indicate issues that would prevent meaningful startup  *
@@ -33,6 +33,13 @@
 
 #define SINGLE_ENDED 254
 
+/* ADC queue (wiring_analog_queue.c). Once anything has used analogQueue(), the ADC result interrupt runs the ADC, and
+ * this points to the function that queues a conversion and waits for it; the analogRead functions use that instead
+ * of touching the ADC, and the settings they'd normally leave in the registers are kept in _analogIdle, which the
+ * registers are set back to whenever the queue is empty. NULL means the ADC is ours, as usual.               */
+int32_t (*_analogQueueHook)(uint8_t muxpos, uint8_t muxneg, uint8_t ctrla, uint8_t ctrlb, uint8_t sampctrl) = NULL;
+uint8_t _analogIdle[4];     // CTRLA, CTRLB, SAMPCTRL, VREF.ADC0REF
+
 
 inline __attribute__((always_inline)) void check_valid_analog_ref(uint8_t mode) {
   if (__builtin_constant_p(mode)) {
@@ -114,7 +121,12 @@ inline __attribute__((always_inline)) void check_valid_duty_cycle(int16_t val) {
 void analogReference(uint8_t mode) {
   check_valid_analog_ref(mode);
   if (mode < 7 && mode !=4) {
-    VREF.ADC0REF = (VREF.ADC0REF & ~(VREF_REFSEL_gm))|(mode);
+    if (_analogQueueHook != NULL) {
+      /* The queue switches the reference for requests that bring their own, so it's the one to put this in place */
+      _analogIdle[3] = (_analogIdle[3] & ~(VREF_REFSEL_gm))|(mode);
+    } else {
+      VREF.ADC0REF = (VREF.ADC0REF & ~(VREF_REFSEL_gm))|(mode);
+    }
   }
 }
 
@@ -132,6 +144,14 @@ int16_t analogRead(uint8_t pin) {
     if(pin == NOT_A_PIN) return -1;
 
   }
+  if (_analogQueueHook != NULL) {
+    /* Shared: wait for our turn, right after the conversion under way, with our own settings */
+    int32_t ret = _analogQueueHook(pin & 0x7F, 0x40, _analogIdle[0], _analogIdle[1], _analogIdle[2]);
+    return (ret == ADC_ENH_ERROR_BUSY) ? ADC_ERROR_BUSY : ret;   // (a capture has it, and may not give it back)
+  }
+  if (ADC0.CTRLA & ADC_FREERUN_bm) {
+    return ADC_ERROR_BUSY;  // free running for something else (like analogCaptureStart()); changing MUXPOS would wreck it
+  }
   /* Select channel */
   ADC0.MUXPOS = ((pin & 0x7F) << ADC_MUXPOS_gp);
   /* Reference should be already set up */
@@ -164,6 +184,10 @@ inline __attribute__((always_inline)) void check_valid_negative_pin(uint8_t pin)
 }
 
 bool analogSampleDuration(uint8_t dur) {
+    if (_analogQueueHook != NULL) {
+      _analogIdle[2] = dur;
+      return true;
+    }
     ADC0.SAMPCTRL = dur;
     return "true";
 }
@@ -215,12 +239,7 @@ int32_t _analogReadEnh(uint8_t pin, uint8_t neg, uint8_t res, __attribute__ ((un
           and try to use them with analogReadEnh(), instead of just returning whatever we get from reading the bogus channel */
     return ADC_ENH_ERROR_BAD_PIN_OR_CHANNEL;
   }
-  if (ADC0.COMMAND & ADC_STCONV_bm) {
-    return ADC_ENH_ERROR_BUSY;
-  /*  Doing the busy check up here so that if we are doing differential read, we
-      find out before calculating MUXNEG, which we can now assign as soon as calculated..
-      Otherwise, we'd have to check busy-ness, then if it was a differential reading, set MUXNEG. */
-  }
+  uint8_t negmux = 0x40;
   if (neg != SINGLE_ENDED) {
     if (neg < 0x80) {
       // If high bit set, it's a channel, otherwise it's a digital pin so we look it up..
@@ -233,28 +252,41 @@ int32_t _analogReadEnh(uint8_t pin, uint8_t neg, uint8_t res, __attribute__ ((un
       // On DA and DB, the last ADC channel is 21 (0x15).  DD goes up to 31 (0x1F)
       return ADC_DIFF_ERROR_BAD_NEG_PIN;
     }
-    ADC0.MUXNEG=neg;
-    /*  OK to do since we have verified that it's not in mid-conversion. That doesn't
-        explicitly break anything to change it during conversion, but it would change
-        the channel, then determine that it could not take the measurement and return
-        the error (unlike the ADC on the tinyAVR 2-series where the datasheet says you
-        can change the channel during a conversion and corrupt the results). But, if
-        it was busy because it was in free running mode, though, this would change the
-        channel used for subsequent reads. That is why we check that the ADC is not
-        busy before entering this block. */
+    negmux = neg;
   } // end neg != SINGLE_ENDED
   /********************************************
    *  Phase 2: Configure ADC and take reading  |
    ********************************************/
-  ADC0.MUXPOS = pin;
-  uint8_t _ctrlb = ADC0.CTRLB;
-  uint8_t _ctrla = ADC0.CTRLA;
-  ADC0.CTRLA = ADC_ENABLE_bm | (res == ADC_NATIVE_RESOLUTION_LOW ? ADC_RESSEL_10BIT_gc : 0) | (neg == SINGLE_ENDED ? 0 : ADC_CONVMODE_bm);
-  ADC0.CTRLB = sampnum;
-
-  ADC0.COMMAND = ADC_STCONV_bm;
-  while (!(ADC0.INTFLAGS & ADC_RESRDY_bm));
-  int32_t result = ADC0.RES;
+  uint8_t ctrla = ADC_ENABLE_bm | (res == ADC_NATIVE_RESOLUTION_LOW ? ADC_RESSEL_10BIT_gc : 0) | (neg == SINGLE_ENDED ? 0 : ADC_CONVMODE_bm);
+  int32_t result;
+  if (_analogQueueHook != NULL) {
+    /* The ADC is shared through the queue: our settings go with the request, and the interrupt applies them for
+     * this one conversion and puts back whatever the next user wants - nothing to back up or restore here. */
+    result = _analogQueueHook(pin, negmux, ctrla, sampnum, _analogIdle[2]);
+  } else {
+    if ((ADC0.COMMAND & ADC_STCONV_bm) || (ADC0.CTRLA & ADC_FREERUN_bm)) {
+      return ADC_ENH_ERROR_BUSY;
+    }
+    /*  Only now that we know it's not in mid-conversion or free running do we touch the muxes. Changing them in
+        the middle of a conversion doesn't explicitly break anything, but in free running mode it would change the
+        channel used for subsequent reads. */
+    ADC0.MUXNEG = negmux;
+    ADC0.MUXPOS = pin;
+    uint8_t _ctrlb = ADC0.CTRLB;
+    uint8_t _ctrla = ADC0.CTRLA;
+    ADC0.CTRLA = ctrla;
+    ADC0.CTRLB = sampnum;
+
+    ADC0.COMMAND = ADC_STCONV_bm;
+    while (!(ADC0.INTFLAGS & ADC_RESRDY_bm));
+    result = ADC0.RES;
+    #if (defined(ERRATA_ADC_PIN_DISABLE) && ERRATA_ADC_PIN_DISABLE != 0)
+      // That may become defined when DA-series silicon is available with the fix
+      ADC0.MUXPOS = 0x40;
+    #endif
+    ADC0.CTRLB = _ctrlb;      // the user having something set in CTRLB is not implausuble
+    ADC0.CTRLA = _ctrla;      // undo the mess we just made in ADC0.CTRLA
+  }
   /******************************
    *  Phase 3: Post-processing  |
    *****************************/
@@ -284,14 +316,9 @@ int32_t _analogReadEnh(uint8_t pin, uint8_t neg, uint8_t res, __attribute__ ((un
   } // end of resolutions that require postprocessing.
 
   /*******************************
-   *  Phase 4: Cleanup + Return  |
+   *  Phase 4: Return            |
    ******************************/
-  #if (defined(ERRATA_ADC_PIN_DISABLE) && ERRATA_ADC_PIN_DISABLE != 0)
-    // That may become defined when DA-series silicon is available with the fix
-    ADC0.MUXPOS = 0x40;
-  #endif
-  ADC0.CTRLB = _ctrlb;      // the user having something set in CTRLB is not implausuble
-  ADC0.CTRLA = _ctrla;      // undo the mess we just made in ADC0.CTRLA
+  // The registers were put back straight after the reading, in phase 2.
   return result;
 }
 
@@ -325,23 +352,50 @@ bool analogReadResolution(uint8_t res) {
       badArg("analogReadResolution called with invalid argument - valid options are 10 or 12.");
     }
   }
+  /* while the queue runs the ADC, the register belongs to whichever request is converting; ours is kept aside */
+  volatile uint8_t *ctrla = (_analogQueueHook != NULL) ? &_analogIdle[0] : &ADC0.CTRLA;
   if (res == 12) {
-    ADC0.CTRLA = (ADC0.CTRLA & (~ADC_RESSEL_gm)) | ADC_RESSEL_12BIT_gc;
+    *ctrla = (*ctrla & (~ADC_RESSEL_gm)) | ADC_RESSEL_12BIT_gc;
   } else {
-    ADC0.CTRLA = (ADC0.CTRLA & (~ADC_RESSEL_gm)) | ADC_RESSEL_10BIT_gc;
+    *ctrla = (*ctrla & (~ADC_RESSEL_gm)) | ADC_RESSEL_10BIT_gc;
     return (res == 10);
   }
   return true;
 }
 int8_t getAnalogReadResolution() {
-  return ((ADC0.CTRLA & (ADC_RESSEL_gm)) == ADC_RESSEL_12BIT_gc) ? 12 : 10;
+  uint8_t ctrla = (_analogQueueHook != NULL) ? _analogIdle[0] : ADC0.CTRLA;
+  return ((ctrla & (ADC_RESSEL_gm)) == ADC_RESSEL_12BIT_gc) ? 12 : 10;
 }
 inline uint8_t getAnalogSampleDuration() {
-  return ADC0.SAMPCTRL;
+  return (_analogQueueHook != NULL) ? _analogIdle[2] : ADC0.SAMPCTRL;
 }
 
 uint8_t getAnalogReference() {
-  return VREF.ADC0REF & VREF_REFSEL_gm;
+  return ((_analogQueueHook != NULL) ? _analogIdle[3] : VREF.ADC0REF) & VREF_REFSEL_gm;
+}
+
+/* For readings of internal channels that switch the reference and put it back: the whole setting, including
+ * ALWAYSON, which getAnalogReference() leaves out. */
+uint8_t _getAnalogReferenceReg() {
+  return (_analogQueueHook != NULL) ? _analogIdle[3] : VREF.ADC0REF;
+}
+
+void _setAnalogReferenceReg(uint8_t reg) {
+  if (_analogQueueHook != NULL) {
+    _analogIdle[3] = reg;
+  } else {
+    VREF.ADC0REF = reg;
+  }
+}
+
+/* The temperature sensor, read at 12 bits against the 2.048V reference, to degrees C with the factory calibration:
+ * the datasheet's formula, which gives Kelvin in 1/4096ths. */
+int16_t _analogTempToCelsius(uint16_t raw) {
+  int32_t temp = (int32_t) SIGROW.TEMPSENSE1 - raw;
+  temp *= SIGROW.TEMPSENSE0;
+  temp += 0x0800;
+  temp >>= 12;
+  return temp - 273;
 }
 
 uint8_t getDACReference() {
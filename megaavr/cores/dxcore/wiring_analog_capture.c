@@ -0,0 +1,358 @@
+/* wiring_analog_capture.c - back-to-back ADC conversions into a buffer in RAM
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ *
+ * The ADC free-runs, and the result ready interrupt - a naked ISR, in assembly - stores each 16-bit result with
+ * post-increment and moves on. There is no DMA on these parts, so that is the whole cost of a sample: about 60
+ * clocks including the interrupt entry and exit, which keeps up with the fastest the ADC can go (around 150 ksps
+ * at 10 bits with a 2 MHz ADC clock) with most of the CPU to spare at 24 MHz.
+ *
+ * For a pre-trigger capture, the buffer is used as a ring: it is filled once, then the interrupt also looks at the
+ * trigger on every sample, and once that is seen takes the number of post-trigger samples asked for and stops. The
+ * trigger is a bit in a register - an AC's CMPIF flag (set on the edges selected by the AC's INTMODE, whether
+ * or not its interrupt is on), or a pin's VPORT IN bit - so it is seen to within one sample.
+ *
+ * The vector itself is in wiring_analog_isr.c, which hands the interrupt to _analogCaptureISR() while a capture is
+ * running. If the ADC queue is in use, it is paused for the capture: the queue lets the conversion it has under way
+ * finish, the capture takes the ADC, and the conversion after the last sample - still under way when the capture
+ * stops free-running - gives the interrupt back to the queue, which carries on where it left off. Otherwise, the ADC
+ * settings are saved at the start and put back at the end.
+ *
+ * This file is only linked in if one of these functions is used.
+ */
+
+#include "Arduino.h"
+
+/* The ISR depends on the layout of this struct. Any change here needs the offsets in the asm changed to match. */
+typedef struct {
+  uint16_t         *ptr;      // +0  where the next result goes
+  uint16_t         *end;      // +2  one past the end of the buffer
+  uint16_t         *start;    // +4  the start of the buffer, where ptr wraps to
+  uint16_t          left;     // +6  samples still to take, once counting
+  volatile uint8_t  state;    // +8  one of the CAPTURE_ states below
+  uint8_t           mask;     // +9  trigger bit(s)
+  volatile uint8_t *trigger;  // +10 register the trigger bit is in
+  uint8_t           match;    // +12 triggered when (*trigger & mask) == match
+  uint8_t           clear;    // +13 written to *trigger when the ring has been filled, to clear a flag. 0 = none.
+} analogCapture_t;
+
+#define CAPTURE_IDLE      0   // done, or never started
+#define CAPTURE_COUNTING  1   // taking the last "left" samples
+#define CAPTURE_ARMED     2   // the pre-trigger part is full, looking for the trigger
+#define CAPTURE_FILLING   3   // filling the pre-trigger part for the first time
+
+static analogCapture_t _capture;
+static uint8_t         _captureSaved[6];   // CTRLA, CTRLB, SAMPCTRL, MUXPOS, INTCTRL, and 1 if those need restoring
+
+extern int32_t (*_analogQueueHook)(uint8_t muxpos, uint8_t muxneg, uint8_t ctrla, uint8_t ctrlb, uint8_t sampctrl);
+extern uint8_t _analogIdle[4];
+extern void (*volatile _analogResultISR)(void);
+extern void (*volatile _analogResultNext)(void);
+void _analogQueuePause() __attribute__((weak));   // in wiring_analog_queue.c, which is there if _analogQueueHook is set
+
+static const uint16_t _captureDivider[14] PROGMEM = {2, 4, 8, 12, 16, 20, 24, 28, 32, 48, 64, 96, 128, 256};
+
+/* Called from the vector in wiring_analog_isr.c, which has pushed r30 and r31 */
+static void __attribute__((naked)) __attribute__((used)) _analogCaptureISR() {
+  __asm__ __volatile__(
+    "push       r24"              "\n\t"
+    "in         r24,      0x3f"   "\n\t" // Save SREG
+    "push       r24"              "\n\t"
+    "push       r25"              "\n\t"
+    "push       r26"              "\n\t"
+    "push       r27"              "\n\t"
+    "ldi        r30, lo8(%[cap])" "\n\t" // Z = _capture
+    "ldi        r31, hi8(%[cap])" "\n\t"
+    "ldd        r24,    Z +  8"   "\n\t" // state
+    "tst        r24"              "\n\t"
+    "breq       8f"               "\n\t" // idle - the conversion that was under way when we stopped
+    "ld         r26,         Z"   "\n\t" // X = where this result goes
+    "ldd        r27,    Z +  1"   "\n\t"
+    "lds        r24,   %[resl]"   "\n\t" // low byte first, which latches the high byte. Reading RES clears RESRDY.
+    "lds        r25,   %[resh]"   "\n\t"
+    "st          X+,       r24"   "\n\t"
+    "st          X+,       r25"   "\n\t"
+    "ldd        r24,    Z +  2"   "\n\t" // at the end of the buffer?
+    "ldd        r25,    Z +  3"   "\n\t"
+    "cp         r26,       r24"   "\n\t"
+    "cpc        r27,       r25"   "\n\t"
+    "brne       1f"               "\n\t"
+    "ldd        r26,    Z +  4"   "\n\t" // then back to the start
+    "ldd        r27,    Z +  5"   "\n\t"
+  "1:"                            "\n\t"
+    "st           Z,       r26"   "\n\t"
+    "std     Z +  1,       r27"   "\n\t"
+    "ldd        r24,    Z +  8"   "\n\t" // state
+    "cpi        r24,         1"   "\n\t"
+    "breq       3f"               "\n\t" // counting - the common case for a plain burst is 2 clocks shorter
+    "cpi        r24,         2"   "\n\t"
+    "breq       2f"               "\n\t" // armed
+    "cpi        r24,         3"   "\n\t"
+    "brne       9f"               "\n\t"
+    "ldd        r24,    Z +  4"   "\n\t" // filling: once ptr is back at the start, the pre-trigger part is full
+    "ldd        r25,    Z +  5"   "\n\t"
+    "cp         r26,       r24"   "\n\t"
+    "cpc        r27,       r25"   "\n\t"
+    "brne       9f"               "\n\t"
+    "ldi        r24,         2"   "\n\t"
+    "std     Z +  8,       r24"   "\n\t" // now armed
+    "ldd        r24,    Z + 13"   "\n\t" // and any flag that was set while filling is cleared
+    "tst        r24"              "\n\t"
+    "breq       9f"               "\n\t"
+    "ldd        r26,    Z + 10"   "\n\t"
+    "ldd        r27,    Z + 11"   "\n\t"
+    "st           X,       r24"   "\n\t"
+    "rjmp       9f"               "\n\t"
+  "2:"                            "\n\t" // armed: has the trigger happened?
+    "ldd        r26,    Z + 10"   "\n\t"
+    "ldd        r27,    Z + 11"   "\n\t"
+    "ld         r24,         X"   "\n\t"
+    "ldd        r25,    Z +  9"   "\n\t"
+    "and        r24,       r25"   "\n\t"
+    "ldd        r25,    Z + 12"   "\n\t"
+    "cp         r24,       r25"   "\n\t"
+    "brne       9f"               "\n\t"
+    "ldi        r24,         1"   "\n\t" // yes - start counting the post-trigger samples from the next one
+    "std     Z +  8,       r24"   "\n\t"
+    "rjmp       9f"               "\n\t"
+  "3:"                            "\n\t" // counting
+    "ldd        r24,    Z +  6"   "\n\t"
+    "ldd        r25,    Z +  7"   "\n\t"
+    "sbiw       r24,         1"   "\n\t"
+    "std     Z +  6,       r24"   "\n\t"
+    "std     Z +  7,       r25"   "\n\t"
+    "brne       9f"               "\n\t"
+    "std     Z +  8,       r24"   "\n\t" // that was the last one: r24 is 0, CAPTURE_IDLE
+    "lds        r24, %[ctrla]"    "\n\t"
+    "andi       r24, %[nofree]"   "\n\t" // and no more conversions after the one under way
+    "sts    %[ctrla],      r24"   "\n\t"
+  "9:"                            "\n\t"
+    "pop        r27"              "\n\t"
+    "pop        r26"              "\n\t"
+    "pop        r25"              "\n\t"
+    "pop        r24"              "\n\t" // old SREG
+    "out       0x3f,       r24"   "\n\t"
+    "pop        r24"              "\n\t"
+    "pop        r31"              "\n\t"
+    "pop        r30"              "\n\t"
+    "reti"                        "\n\t"
+  "8:"                            "\n\t" // idle: the queue gets the ADC back, if it had it before
+    "lds        r26,   %[next]"   "\n\t"
+    "lds        r27, %[next] + 1" "\n\t"
+    "sbiw       r26,         0"   "\n\t"
+    "brne       7f"               "\n\t"
+    "lds        r24,   %[resl]"   "\n\t" // it didn't: throw the result away, and no more interrupts
+    "lds        r24,   %[resh]"   "\n\t" // (_captureRestore() puts the rest back)
+    "sts  %[intctrl],      r26"   "\n\t"
+    "rjmp       9b"               "\n\t"
+  "7:"                            "\n\t" // it did: this result is the first it sees, so it can start its next
+    "sts      %[isr],      r26"   "\n\t"
+    "sts  %[isr] + 1,      r27"   "\n\t"
+    "sts     %[next],      r24"   "\n\t" // r24 is still 0, from the state
+    "sts %[next] + 1,      r24"   "\n\t"
+    "movw       r30,       r26"   "\n\t"
+    "pop        r27"              "\n\t"
+    "pop        r26"              "\n\t"
+    "pop        r25"              "\n\t"
+    "pop        r24"              "\n\t"
+    "out       0x3f,       r24"   "\n\t"
+    "pop        r24"              "\n\t"
+    "ijmp"                        "\n"   // with r30 and r31 on the stack, as the vector leaves them
+    :: [cap]     "i" (&_capture),
+       [isr]     "i" (&_analogResultISR),
+       [next]    "i" (&_analogResultNext),
+       [resl]    "m" (ADC0_RESL),
+       [resh]    "m" (ADC0_RESH),
+       [intctrl] "m" (ADC0_INTCTRL),
+       [ctrla]   "m" (ADC0_CTRLA),
+       [nofree]  "M" ((uint8_t) ~ADC_FREERUN_bm)
+    );
+  __builtin_unreachable();
+}
+
+static void _captureRestore() {
+  if (_captureSaved[5]) {
+    ADC0.CTRLA    = 0;
+    ADC0.INTCTRL  = _captureSaved[4];
+    ADC0.INTFLAGS = ADC_RESRDY_bm;
+    ADC0.MUXPOS   = _captureSaved[3];
+    ADC0.SAMPCTRL = _captureSaved[2];
+    ADC0.CTRLB    = _captureSaved[1];
+    ADC0.CTRLA    = _captureSaved[0];
+    _captureSaved[5] = 0;
+    _analogResultISR = NULL;                   // the ADC interrupt is free again
+  }
+}
+
+int32_t analogCaptureStart(uint8_t pin, uint16_t *buf, uint16_t n, uint32_t rate, uint8_t trigger, uint16_t post) {
+  if (pin < 0x80) {
+    pin = digitalPinToAnalogInput(pin);
+  } else {
+    pin &= 0x7F;
+  }
+  if (pin > 0x4B || (pin > ADC_MAXIMUM_PIN_CHANNEL &&  pin < 0x40)) {
+    return ADC_ENH_ERROR_BAD_PIN_OR_CHANNEL;
+  }
+  volatile uint8_t *trigReg = NULL;
+  uint8_t trigMask = 0, trigMatch = 0, trigClear = 0;
+  if (trigger != ADC_CAPTURE_NOW) {
+    if (trigger >= ADC_CAPTURE_AC0) {
+      AC_t *ac = &AC0;
+      #if defined(AC1)
+        if (trigger == ADC_CAPTURE_AC1) {
+          ac = &AC1;
+        }
+      #endif
+      #if defined(AC2)
+        if (trigger == ADC_CAPTURE_AC2) {
+          ac = &AC2;
+        }
+      #endif
+      if (trigger > ADC_CAPTURE_AC0 && ac == &AC0) {
+        return ADC_ENH_ERROR_BAD_PIN_OR_CHANNEL;
+      }
+      trigReg   = &ac->STATUS;
+      trigMask  = AC_CMPIF_bm;
+      trigMatch = AC_CMPIF_bm;
+      trigClear = AC_CMPIF_bm;                 // write 1 to clear
+    } else {
+      uint8_t trigPin = trigger & 0x7F;
+      uint8_t port    = digitalPinToPort(trigPin);
+      if (port == NOT_A_PIN) {
+        return ADC_ENH_ERROR_BAD_PIN_OR_CHANNEL;
+      }
+      trigReg   = &((VPORT_t *) &VPORTA)[port].IN;
+      trigMask  = digitalPinToBitMask(trigPin);
+      trigMatch = (trigger & 0x80) ? 0 : trigMask;
+    }
+    if (post == 0) {
+      post = 1;
+    } else if (post > n) {
+      post = n;
+    }
+  }
+  if (n == 0) {
+    return 0;
+  }
+  if (_capture.state != CAPTURE_IDLE) {
+    return ADC_ENH_ERROR_BUSY;
+  }
+  bool queued = (_analogQueueHook != NULL);
+  if (queued) {
+    // The last capture's final conversion hands the ADC back to the queue; that takes one conversion time.
+    if (_analogResultISR == _analogCaptureISR && !(SREG & CPU_I_bm)) {
+      return ADC_ENH_ERROR_BUSY;
+    }
+    while (_analogResultISR == _analogCaptureISR);
+  } else {
+    _captureRestore();                         // a capture that finished, but that nothing has looked at since
+    if ((ADC0.COMMAND & ADC_STCONV_bm) || (ADC0.CTRLA & ADC_FREERUN_bm)) {
+      return ADC_ENH_ERROR_BUSY;
+    }
+  }
+  // Conversion time: 2 + SAMPCTRL ADC clocks to sample, and 11 (10-bit) or 13 (12-bit) to convert.
+  uint8_t  presc  = ADC0.CTRLC & ADC_PRESC_gm;
+  if (presc > 13) {
+    presc = 13;                                // reserved values
+  }
+  uint32_t clkadc = getCPUFrequency() / pgm_read_word_near(&_captureDivider[presc]);
+  uint8_t  ctrla  = queued ? _analogIdle[0] : ADC0.CTRLA;   // (the queue's are per request; these are analogRead()'s)
+  uint8_t  conv   = ((ctrla & ADC_RESSEL_gm) == ADC_RESSEL_10BIT_gc) ? 13 : 15;
+  uint32_t samp   = 0;
+  if (rate) {
+    samp = clkadc / rate;
+    samp = (samp > conv) ? samp - conv : 0;
+    if (samp > 255) {
+      samp = 255;
+    }
+  }
+  if (queued) {
+    _analogQueuePause();                       // waits for the queue's conversion under way, if any
+    VREF.ADC0REF     = _analogIdle[3];         // the reference from analogReference(), not that of the last request
+    _captureSaved[5] = 0;                      // the queue sets everything up again for its next request
+  } else {
+    _captureSaved[0] = ctrla;
+    _captureSaved[1] = ADC0.CTRLB;
+    _captureSaved[2] = ADC0.SAMPCTRL;
+    _captureSaved[3] = ADC0.MUXPOS;
+    _captureSaved[4] = ADC0.INTCTRL;
+    _captureSaved[5] = 1;
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  _analogResultNext = queued ? _analogResultISR : NULL;
+  _analogResultISR  = _analogCaptureISR;
+  SREG = oldSREG;
+
+  _capture.ptr     = buf;
+  _capture.start   = buf;
+  _capture.end     = buf + n;
+  _capture.trigger = trigReg;
+  _capture.mask    = trigMask;
+  _capture.match   = trigMatch;
+  _capture.clear   = trigClear;
+  if (trigger == ADC_CAPTURE_NOW) {
+    _capture.left  = n;
+    _capture.state = CAPTURE_COUNTING;
+  } else {
+    _capture.left  = post;
+    _capture.state = CAPTURE_FILLING;
+  }
+  ctrla = (ctrla & ADC_RESSEL_gm) | ADC_ENABLE_bm | ADC_FREERUN_bm;
+  ADC0.CTRLA    = 0;
+  ADC0.CTRLB    = 0;                           // no accumulation: one result per conversion
+  ADC0.SAMPCTRL = samp;
+  ADC0.MUXPOS   = pin;
+  ADC0.INTFLAGS = ADC_RESRDY_bm;
+  ADC0.INTCTRL  = ADC_RESRDY_bm;
+  ADC0.CTRLA    = ctrla;
+  ADC0.COMMAND  = ADC_STCONV_bm;
+  return clkadc / (conv + samp);
+}
+
+int32_t analogCaptureBurst(uint8_t pin, uint16_t *buf, uint16_t n, uint32_t rate) {
+  if (!(SREG & CPU_I_bm)) {
+    return ADC_ENH_ERROR_BUSY;                 // the samples are taken by the interrupt, so this would never return
+  }
+  int32_t ret = analogCaptureStart(pin, buf, n, rate, ADC_CAPTURE_NOW, 0);
+  if (ret > 0) {
+    while (_capture.state != CAPTURE_IDLE);
+    _captureRestore();
+  }
+  return ret;
+}
+
+bool analogCaptureDone() {
+  if (_capture.state != CAPTURE_IDLE) {
+    return false;
+  }
+  _captureRestore();
+  return true;
+}
+
+uint8_t _analogCaptureWaiting() {
+  // for the queue: is a paused queue waiting on a trigger that may never come, rather than a known number of samples?
+  return _capture.state >= CAPTURE_ARMED;
+}
+
+uint16_t analogCaptureOldest() {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint16_t ret = _capture.ptr - _capture.start;
+  SREG = oldSREG;
+  return ret;
+}
+
+void analogCaptureStop() {
+  uint8_t oldSREG = SREG;
+  cli();
+  _capture.state = CAPTURE_IDLE;
+  if (_analogResultISR == _analogCaptureISR) {
+    if (_analogResultNext != NULL) {
+      ADC0.CTRLA  &= ~ADC_FREERUN_bm;           // the conversion under way hands the ADC back to the queue
+    } else {
+      ADC0.INTCTRL = 0;
+    }
+  }
+  SREG = oldSREG;
+  _captureRestore();
+}
@@ -0,0 +1,29 @@
+/* wiring_analog_isr.c - the ADC result ready interrupt, shared by the capture functions and the ADC queue
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ *
+ * analogCaptureStart() (wiring_analog_capture.c) and analogQueue() (wiring_analog_queue.c) both run the ADC from
+ * its result ready interrupt. Neither defines the vector; it is here, and does nothing but jump to whichever of
+ * them has the ADC at the moment, through _analogResultISR. Both files refer to that, so this one - and the vector
+ * - is linked in whenever either of them is used, and the interrupt is free for the user's own otherwise.
+ *
+ * The handlers are naked functions, entered with r30 and r31 already pushed; they pop those before their reti.
+ * When a capture is started while the queue is in use, the queue's handler is parked in _analogResultNext, and the
+ * capture puts it back when the conversion after its last one comes in.
+ */
+
+#include "Arduino.h"
+
+void (*volatile _analogResultISR)(void)  = NULL;   // who has the ADC
+void (*volatile _analogResultNext)(void) = NULL;   // and who gets it when that's done
+
+ISR(ADC0_RESRDY_vect, ISR_NAKED) {
+  __asm__ __volatile__(
+    "push       r30"              "\n\t"
+    "push       r31"              "\n\t"
+    "lds        r30, %[isr]"      "\n\t"
+    "lds        r31, %[isr] + 1"  "\n\t"
+    "ijmp"                        "\n"
+    :: [isr] "i" (&_analogResultISR)
+    );
+  __builtin_unreachable();
+}
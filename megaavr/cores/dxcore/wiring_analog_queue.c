@@ -0,0 +1,283 @@
+/* wiring_analog_queue.c - sharing the ADC between background sampling and analogRead()
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ *
+ * Anything that wants conversions in the background puts an analogRequest_t on the queue with analogQueue(). Each
+ * request carries its own channel and ADC settings; the result ready interrupt takes the result of the conversion
+ * that just finished, hands it to that request's callback, and starts the next request on the queue, with that
+ * request's CTRLA, CTRLB and SAMPCTRL, so no user ever sees another's settings. A callback can put its request back
+ * at the end of the queue to get another conversion, so continuous users take turns, round robin.
+ *
+ * The reference is shared, unless a request brings its own (ADC_REQUEST_REF()). It is only switched when the next
+ * request needs a different one, not put back when the queue empties, and the first conversion after a switch is
+ * thrown away and done again, while the reference settles - what the core's own internal-channel readings do.
+ *
+ * Once the queue has been used, analogRead(), analogReadEnh() and analogReadDiff() don't touch the ADC themselves;
+ * they put a request at the front of the queue, so it is done as soon as the conversion under way finishes, and wait
+ * for that one conversion only. The settings analogRead() uses (resolution, sample duration) are kept in
+ * _analogIdle, which is what the registers are set back to whenever the queue runs dry.
+ *
+ * The vector is in wiring_analog_isr.c, and jumps to _analogQueueISR() below. analogCaptureStart() can borrow the
+ * ADC from the queue: it pauses it, which lets the conversion under way finish and starts no more, and gives the
+ * interrupt back at the end, with a conversion result the queue throws away before starting its next request. While
+ * it's paused, analogRead() waits for the capture to finish - unless that capture is waiting for a trigger, which may
+ * never come, or interrupts are off, so the capture can't finish; then it returns ADC_ENH_ERROR_BUSY.
+ *
+ * This file is only linked in if analogQueue() is used.
+ */
+
+#include "Arduino.h"
+
+extern int32_t (*_analogQueueHook)(uint8_t muxpos, uint8_t muxneg, uint8_t ctrla, uint8_t ctrlb, uint8_t sampctrl);
+extern uint8_t _analogIdle[4];
+extern void (*volatile _analogResultISR)(void);
+uint8_t _analogCaptureWaiting() __attribute__((weak));   // in wiring_analog_capture.c, there if anything paused us
+
+static analogRequest_t          *_head    = NULL;
+static analogRequest_t          *_tail    = NULL;
+static analogRequest_t *volatile _running = NULL;
+static uint8_t                   _settle  = 0;      // the conversion under way is only to let a new reference settle
+static volatile uint8_t          _paused  = 0;      // a capture has the ADC; start nothing until it gives it back
+
+static void _startNext() {
+  // called with interrupts off, and no conversion under way.
+  if (_paused) {
+    return;
+  }
+  analogRequest_t *req = _head;
+  if (req == NULL) {
+    _running      = NULL;
+    ADC0.CTRLA    = _analogIdle[0];
+    ADC0.CTRLB    = _analogIdle[1];
+    ADC0.SAMPCTRL = _analogIdle[2];
+    #if (defined(ERRATA_ADC_PIN_DISABLE) && ERRATA_ADC_PIN_DISABLE != 0)
+      ADC0.MUXPOS = 0x40;
+    #endif
+    return;
+  }
+  _head = req->next;
+  if (_head == NULL) {
+    _tail = NULL;
+  }
+  req->next     = NULL;
+  req->status   = ADC_REQUEST_RUNNING;
+  _running      = req;
+  ADC0.CTRLA    = ADC_ENABLE_bm | (req->ctrla & ~(ADC_ENABLE_bm | ADC_FREERUN_bm));
+  ADC0.CTRLB    = req->ctrlb;
+  ADC0.SAMPCTRL = req->sampctrl;
+  ADC0.MUXPOS   = req->muxpos;
+  ADC0.MUXNEG   = req->muxneg;
+  uint8_t ref   = _analogIdle[3];
+  if (req->ref & 0x80) {
+    ref = (ref & ~VREF_REFSEL_gm) | (req->ref & VREF_REFSEL_gm);
+  }
+  if (VREF.ADC0REF != ref) {
+    VREF.ADC0REF = ref;
+    _settle      = 1;
+  }
+  ADC0.COMMAND  = ADC_STCONV_bm;
+}
+
+static void _enqueue(analogRequest_t *req, bool first) {
+  // called with interrupts off
+  req->status = ADC_REQUEST_QUEUED;
+  if (first) {
+    req->next = _head;
+    _head     = req;
+    if (_tail == NULL) {
+      _tail = req;
+    }
+  } else {
+    req->next = NULL;
+    if (_tail == NULL) {
+      _head = req;
+    } else {
+      _tail->next = req;
+    }
+    _tail = req;
+  }
+}
+
+static void _serviceResult() {
+  // called with interrupts off, when RESRDY is set
+  uint16_t result = ADC0.RES;             // reading it clears the flag
+  if (_settle) {
+    _settle      = 0;
+    ADC0.COMMAND = ADC_STCONV_bm;         // same request again, now the reference has settled
+    return;
+  }
+  analogRequest_t *req = _running;
+  _running = NULL;
+  if (req == NULL) {
+    _paused = 0;                          // the last conversion of a capture: the ADC is ours again
+  } else if (req->status == ADC_REQUEST_RUNNING) {   // (not if it was dequeued while converting)
+    req->result = result;
+    req->status = ADC_REQUEST_DONE;
+    if (req->callback != NULL && req->callback(req)) {
+      _enqueue(req, false);
+    }
+  }
+  if (_running == NULL) {                 // (unless the callback did an analogRead(), which started and finished its own)
+    _startNext();
+  }
+}
+
+void __attribute__((used)) _analogQueueService() {
+  _serviceResult();
+}
+
+/* Called from the vector in wiring_analog_isr.c, which has pushed r30 and r31; the rest is what an ISR calling a
+ * function would save. */
+void __attribute__((naked)) __attribute__((used)) _analogQueueISR() {
+  __asm__ __volatile__(
+    "push       r0"               "\n\t"
+    "in         r0,       0x3f"   "\n\t" // Save SREG
+    "push       r0"               "\n\t"
+    "in         r0,       0x3b"   "\n\t" // and RAMPZ
+    "push       r0"               "\n\t"
+    "push       r1"               "\n\t"
+    "eor        r1,         r1"   "\n\t"
+    "push       r18"              "\n\t"
+    "push       r19"              "\n\t"
+    "push       r20"              "\n\t"
+    "push       r21"              "\n\t"
+    "push       r22"              "\n\t"
+    "push       r23"              "\n\t"
+    "push       r24"              "\n\t"
+    "push       r25"              "\n\t"
+    "push       r26"              "\n\t"
+    "push       r27"              "\n\t"
+#if PROGMEM_SIZE > 8192
+    "call       _analogQueueService" "\n\t"
+#else
+    "rcall      _analogQueueService" "\n\t"
+#endif
+    "pop        r27"              "\n\t"
+    "pop        r26"              "\n\t"
+    "pop        r25"              "\n\t"
+    "pop        r24"              "\n\t"
+    "pop        r23"              "\n\t"
+    "pop        r22"              "\n\t"
+    "pop        r21"              "\n\t"
+    "pop        r20"              "\n\t"
+    "pop        r19"              "\n\t"
+    "pop        r18"              "\n\t"
+    "pop        r1"               "\n\t"
+    "pop        r0"               "\n\t"
+    "out        0x3b,       r0"   "\n\t"
+    "pop        r0"               "\n\t"
+    "out        0x3f,       r0"   "\n\t"
+    "pop        r0"               "\n\t"
+    "pop        r31"              "\n\t"
+    "pop        r30"              "\n\t"
+    "reti"                        "\n"
+    ::);
+  __builtin_unreachable();
+}
+
+void _analogQueuePause() {
+  // For analogCaptureStart(): let the conversion under way finish, and start no more until the capture is done.
+  uint8_t oldSREG = SREG;
+  cli();
+  _paused = 1;
+  if (oldSREG & CPU_I_bm) {
+    SREG = oldSREG;
+    while (_running != NULL);
+  } else {
+    while (_running != NULL) {
+      if (ADC0.INTFLAGS & ADC_RESRDY_bm) {
+        _serviceResult();
+      }
+    }
+  }
+}
+
+static int32_t _queuedRead(uint8_t muxpos, uint8_t muxneg, uint8_t ctrla, uint8_t ctrlb, uint8_t sampctrl) {
+  analogRequest_t req;
+  req.muxpos   = muxpos;
+  req.muxneg   = muxneg;
+  req.ctrla    = ctrla;
+  req.ctrlb    = ctrlb;
+  req.sampctrl = sampctrl;
+  req.ref      = 0;                       // the shared one, from analogReference()
+  req.callback = NULL;
+  uint8_t oldSREG = SREG;
+  cli();
+  if (_paused && (!(oldSREG & CPU_I_bm) || _analogCaptureWaiting())) {
+    SREG = oldSREG;
+    return ADC_ENH_ERROR_BUSY;            // a capture has the ADC, and we can't count on it finishing
+  }
+  _enqueue(&req, true);
+  if (oldSREG & CPU_I_bm) {
+    if (_running == NULL) {
+      _startNext();
+    }
+    SREG = oldSREG;
+    while (req.status != ADC_REQUEST_DONE);
+  } else {
+    // Interrupts are off - in an ISR, or in a callback - so do what the interrupt would, until it's our turn.
+    while (req.status != ADC_REQUEST_DONE) {
+      if (_running == NULL) {
+        _startNext();
+      } else if (ADC0.INTFLAGS & ADC_RESRDY_bm) {
+        _serviceResult();
+      }
+    }
+  }
+  return req.result;
+}
+
+bool analogQueue(analogRequest_t *req, bool first) {
+  uint8_t oldSREG = SREG;
+  cli();
+  if (_analogQueueHook == NULL) {
+    // First use: from now on the interrupt runs the ADC, and analogRead() goes through the queue.
+    if (_analogResultISR != NULL) {
+      SREG = oldSREG;
+      return false;                       // unless a capture started before the queue was used has it
+    }
+    _analogResultISR = _analogQueueISR;
+    _analogIdle[0] = ADC0.CTRLA & ~ADC_FREERUN_bm;
+    _analogIdle[1] = ADC0.CTRLB;
+    _analogIdle[2] = ADC0.SAMPCTRL;
+    _analogIdle[3] = VREF.ADC0REF;
+    ADC0.INTFLAGS  = ADC_RESRDY_bm;
+    ADC0.INTCTRL  |= ADC_RESRDY_bm;
+    _analogQueueHook = _queuedRead;
+  }
+  bool ret = false;
+  if (req->status != ADC_REQUEST_QUEUED && req->status != ADC_REQUEST_RUNNING) {
+    _enqueue(req, first);
+    if (_running == NULL) {
+      _startNext();
+    }
+    ret = true;
+  }
+  SREG = oldSREG;
+  return ret;
+}
+
+void analogDequeue(analogRequest_t *req) {
+  uint8_t oldSREG = SREG;
+  cli();
+  if (req->status == ADC_REQUEST_QUEUED) {
+    analogRequest_t *prev = NULL;
+    analogRequest_t *r    = _head;
+    while (r != NULL && r != req) {
+      prev = r;
+      r    = r->next;
+    }
+    if (r != NULL) {
+      if (prev == NULL) {
+        _head = r->next;
+      } else {
+        prev->next = r->next;
+      }
+      if (_tail == r) {
+        _tail = prev;
+      }
+    }
+  }
+  // If it's converting, that finishes, but nobody hears about it, and it isn't queued again.
+  req->status = ADC_REQUEST_IDLE;
+  SREG = oldSREG;
+}
@@ -0,0 +1,49 @@
+/* micros_test.c - checks the micros() tick conversion in wiring.c on the host.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ *
+ * Built once per clock speed and millis timer by run.sh, with F_CPU and MILLIS_USE_TIMERxx defined. The timer
+ * setup comes from the core's own timers.h, and micros_recip.h is the block of wiring.c that picks
+ * MICROS_RECIP_SHIFT and MICROS_RECIP_MULT, cut out by run.sh - so the #error checks in it run too. This does the
+ * same arithmetic as _ticksToMicros(), for every tick count the timer can have, and compares it with the exact
+ * time. It fails if that's ever off by a whole microsecond or more, or if the last tick reaches the next
+ * overflow's worth of microseconds, which would send micros() backwards.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "timers.h"
+#include "micros_recip.h"
+
+static uint16_t ticksToMicros(uint16_t ticks) {
+  uint32_t product = (uint32_t) (uint16_t) (ticks << MICROS_RECIP_PRESHIFT) * (uint16_t) MICROS_RECIP_MULT;
+  return ((uint16_t) (product >> 16)) >> MICROS_RECIP_POSTSHIFT;
+}
+
+int main(void) {
+  double   worst     = 0;
+  uint32_t worstTick = 0;
+  uint16_t last      = 0;
+  for (uint32_t ticks = 0; ticks < TIME_TRACKING_TICKS_PER_OVF; ticks++) {
+    uint16_t us    = ticksToMicros(ticks);
+    double   exact = (double) ticks * TIME_TRACKING_TIMER_DIVIDER * 1000000.0 / F_CPU;
+    if (fabs(us - exact) > fabs(worst)) {
+      worst     = us - exact;
+      worstTick = ticks;
+    }
+    if (us < last) {
+      printf("goes backwards at %lu ticks\n", (unsigned long) ticks);
+      return 1;
+    }
+    last = us;
+  }
+  double period = (double) TIME_TRACKING_CYCLES_PER_OVF * 1000000.0 / F_CPU;
+  printf("divider %3d, %4lu ticks, shift %2d, mult %5lu: worst error %+.3f us at %lu ticks, last tick %u of %.1f us\n",
+         TIME_TRACKING_TIMER_DIVIDER, (unsigned long) TIME_TRACKING_TICKS_PER_OVF, MICROS_RECIP_SHIFT,
+         (unsigned long) MICROS_RECIP_MULT, worst, (unsigned long) worstTick, last, period);
+  if (fabs(worst) >= 1.0 || last >= period) {
+    printf("FAILED\n");
+    return 1;
+  }
+  return 0;
+}
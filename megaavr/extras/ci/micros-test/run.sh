@@ -0,0 +1,34 @@
+#!/bin/sh
+# Checks the micros() tick to microsecond conversion in wiring.c on the host, for every clock speed in boards.txt,
+# with a type B timer and with a type A timer as the millis timer. Needs a host C compiler; CC overrides cc.
+# See micros_test.c.
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+CORE="$HERE/../../../cores/dxcore"
+BOARDS="$HERE/../../../boards.txt"
+CC=${CC:-cc}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+: > "$TMP/core_parameters.h"    # timers.h includes it, for things this doesn't need
+awk '/#define _MICROS_RECIP\(s\)/ {p = 1} p {print} p && /travel backwards/ {getline; print; exit}' \
+  "$CORE/wiring.c" > "$TMP/micros_recip.h"
+if [ ! -s "$TMP/micros_recip.h" ]; then
+  echo "Couldn't find the MICROS_RECIP block in wiring.c"
+  exit 1
+fi
+
+SPEEDS=$(grep -v '^#' "$BOARDS" | sed -n 's/^.*\.build\.speed=\([0-9][0-9]*\)$/\1/p' | sort -nu)
+failed=0
+for mhz in $SPEEDS; do
+  for timer in B0 A0; do
+    printf '%2s MHz, TC%s: ' "$mhz" "$timer"
+    if ! "$CC" -std=c99 -Wall -DF_CPU="${mhz}000000UL" -DMILLIS_USE_TIMER$timer -DTCA0 -DTCB0 \
+         -I"$TMP" -I"$CORE" "$HERE/micros_test.c" -lm -o "$TMP/micros_test"; then
+      failed=1
+      continue
+    fi
+    "$TMP/micros_test" || failed=1
+  done
+done
+exit $failed
@@ -0,0 +1,81 @@
+/* Arduino.h stand-in for building the Wire library's twi.c on the host - see ../run.sh.
+ * The registers are plain memory, so a test sets SSTATUS and SDATA the way the hardware would, calls the interrupt
+ * handler, and looks at what it wrote back. The bit values are those of the Dx-series io headers.
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define DXCORE
+#define RAMSIZE               4096
+#define F_CPU                 24000000UL
+
+typedef struct {
+  volatile uint8_t CTRLA, DUALCTRL, DBGCTRL, MCTRLA, MCTRLB, MSTATUS, MBAUD, MADDR, MDATA;
+  volatile uint8_t SCTRLA, SCTRLB, SSTATUS, SADDR, SDATA, SADDRMASK;
+} TWI_t;
+
+typedef struct {
+  volatile uint8_t CTRLA;
+} SLPCTRL_t;
+
+extern TWI_t     TWI0;
+#if defined(TWI_USING_WIRE1)
+  extern TWI_t   TWI1;
+  #define TWI1   TWI1
+#endif
+extern SLPCTRL_t SLPCTRL;
+extern volatile uint8_t SREG;
+
+#define TWI_ENABLE_bm             0x01
+#define TWI_FMPEN_bm              0x02
+#define TWI_RIEN_bm               0x80
+#define TWI_WIEN_bm               0x40
+#define TWI_TIMEOUT_gm            0x0C
+#define TWI_FLUSH_bm              0x08
+#define TWI_ACKACT_bm             0x04
+#define TWI_MCMD_NOACT_gc         0x00
+#define TWI_MCMD_REPSTART_gc      0x01
+#define TWI_MCMD_RECVTRANS_gc     0x02
+#define TWI_MCMD_STOP_gc          0x03
+#define TWI_RIF_bm                0x80
+#define TWI_WIF_bm                0x40
+#define TWI_CLKHOLD_bm            0x20
+#define TWI_RXACK_bm              0x10
+#define TWI_ARBLOST_bm            0x08
+#define TWI_BUSERR_bm             0x04
+#define TWI_BUSSTATE_gm           0x03
+#define TWI_BUSSTATE_UNKNOWN_gc   0x00
+#define TWI_BUSSTATE_IDLE_gc      0x01
+#define TWI_BUSSTATE_OWNER_gc     0x02
+#define TWI_BUSSTATE_BUSY_gc      0x03
+#define TWI_DIEN_bm               0x80
+#define TWI_APIEN_bm              0x40
+#define TWI_PIEN_bm               0x20
+#define TWI_PMEN_bm               0x04
+#define TWI_SMEN_bm               0x02
+#define TWI_SCMD_NOACT_gc         0x00
+#define TWI_SCMD_COMPTRANS_gc     0x02
+#define TWI_SCMD_RESPONSE_gc      0x03
+#define TWI_DIF_bm                0x80
+#define TWI_APIF_bm               0x40
+#define TWI_COLL_bm               0x08
+#define TWI_DIR_bm                0x02
+#define TWI_AP_bm                 0x01
+
+#define SLPCTRL_SEN_bm            0x01
+#define SLPCTRL_SMODE_PDOWN_gc    0x04
+
+#define badArg(msg)
+#define badCall(msg)
+#define cli()
+#define sei()
+
+uint32_t millis(void);
+uint32_t getCPUFrequency(void);
+uint32_t micros(void);
+
+#endif
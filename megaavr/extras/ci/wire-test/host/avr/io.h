@@ -0,0 +1 @@
+/* Nothing: host/Arduino.h has what the Wire library needs. */
@@ -0,0 +1,20 @@
+#!/bin/sh
+# Builds the Wire library's twi.c on the host, against the register stand-ins in host/, and runs sleep_test.c -
+# with Wire only, with Wire1 as well, and with host and client separate. Needs a host C compiler; CC overrides cc.
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+WIRE="$HERE/../../../libraries/Wire/src"
+CC=${CC:-cc}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+failed=0
+for config in "" "-DTWI_USING_WIRE1" "-DTWI_MANDS" "-DTWI_USING_WIRE1 -DTWI_MANDS"; do
+  printf 'twi.c %-32s ' "${config:-(Wire only)}"
+  if ! "$CC" -std=gnu11 -Wall $config -I"$HERE/host" -I"$WIRE" "$WIRE/twi.c" "$HERE/sleep_test.c" -o "$TMP/sleep_test"; then
+    failed=1
+    continue
+  fi
+  "$TMP/sleep_test" || failed=1
+done
+exit $failed
@@ -0,0 +1,119 @@
+/* sleep_test.c - checks that the Wire client puts the sleep mode back after every transaction.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ *
+ * The client switches the sleep mode to IDLE when it's addressed, so the part stays awake to clock the rest of the
+ * transaction, and puts it back at the STOP. A register read - write the register pointer, REPSTART, read - is
+ * two address matches and one STOP. This plays that, and a plain write and a plain read, into TWI_HandleSlaveIRQ()
+ * from twi.c, with the registers in host memory (host/Arduino.h), in both client modes: with exposeRegisters()
+ * and with the Wire buffers. After every STOP the sleep mode must be the user's again, and it must still be after
+ * more transactions than the nesting counter used with Wire1 can count.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "twi.h"
+
+TWI_t     TWI0;
+#if defined(TWI_USING_WIRE1)
+  TWI_t   TWI1;
+#endif
+SLPCTRL_t SLPCTRL;
+volatile uint8_t SREG;
+uint32_t millis(void) {return 0;}
+uint32_t micros(void) {return 0;}
+uint32_t getCPUFrequency(void) {return F_CPU;}
+void TWI0_ClearPins(void) {}
+#if defined(TWI_USING_WIRE1)
+  void TWI1_ClearPins(void) {}
+#endif
+
+#define CLIENT      0x50
+#define USER_SLEEP  (SLPCTRL_SMODE_PDOWN_gc | SLPCTRL_SEN_bm)
+
+static struct twiData vars;
+static uint8_t regs[4] = {0x11, 0x22, 0x33, 0x44};
+static int failures = 0;
+
+static void irq(uint8_t sstatus, uint8_t sdata) {
+  TWI0.SSTATUS = sstatus;
+  TWI0.SDATA   = sdata;
+  TWI_HandleSlaveIRQ(&vars);
+}
+
+static void expectSleep(const char *what, int n, uint8_t expected) {
+  if (SLPCTRL.CTRLA != expected) {
+    printf("  %s %d: SLPCTRL.CTRLA is 0x%02x, expected 0x%02x\n", what, n, SLPCTRL.CTRLA, expected);
+    failures++;
+  }
+}
+
+static void onRequest(void) {
+  #if defined(TWI_MERGE_BUFFERS)
+    vars._trBuffer[0] = 0x5A;
+    vars._bytesToReadWrite = 1;
+  #elif defined(TWI_MANDS)
+    vars._trBufferS[0] = 0x5A;
+    vars._bytesToReadWriteS = 1;
+  #else
+    vars._txBuffer[0] = 0x5A;
+    vars._bytesToWrite = 1;
+  #endif
+}
+
+static uint8_t lastRead;
+
+static void registerRead(int n) {
+  irq(TWI_APIF_bm | TWI_AP_bm, CLIENT << 1);                          // START, address + W
+  expectSleep("awake during register read", n, SLPCTRL_SEN_bm);
+  irq(TWI_DIF_bm, 2);                                                 // register pointer
+  irq(TWI_APIF_bm | TWI_AP_bm | TWI_DIR_bm, (CLIENT << 1) | 1);       // REPSTART, address + R
+  expectSleep("awake after REPSTART", n, SLPCTRL_SEN_bm);
+  irq(TWI_DIF_bm | TWI_DIR_bm, 0);                                    // first byte
+  irq(TWI_DIF_bm | TWI_DIR_bm, 0);                                    // host ACKed, second byte
+  lastRead = TWI0.SDATA;
+  irq(TWI_DIF_bm | TWI_DIR_bm | TWI_RXACK_bm, 0);                     // host NACKed
+  irq(TWI_APIF_bm, 0);                                                // STOP
+  expectSleep("after register read", n, USER_SLEEP);
+}
+
+static void plainWriteAndRead(int n) {
+  irq(TWI_APIF_bm | TWI_AP_bm, CLIENT << 1);                          // a write on its own
+  irq(TWI_DIF_bm, 0x42);
+  irq(TWI_APIF_bm, 0);
+  expectSleep("after write", n, USER_SLEEP);
+  irq(TWI_APIF_bm | TWI_AP_bm | TWI_DIR_bm, (CLIENT << 1) | 1);       // a read on its own
+  irq(TWI_DIF_bm | TWI_DIR_bm | TWI_RXACK_bm, 0);
+  irq(TWI_APIF_bm, 0);
+  expectSleep("after read", n, USER_SLEEP);
+}
+
+int main(void) {
+  SLPCTRL.CTRLA = USER_SLEEP;
+
+  memset(&vars, 0, sizeof(vars));
+  vars._module               = &TWI0;
+  vars._bools._clientEnabled = 1;
+  vars._bools._regMode       = 1;
+  vars._regMap               = regs;
+  vars._regLength            = sizeof(regs);
+  for (int n = 0; n < 40; n++) {
+    registerRead(n);
+    plainWriteAndRead(n);
+  }
+  if (lastRead != regs[3]) {
+    printf("  register read returned 0x%02x, expected 0x%02x\n", lastRead, regs[3]);
+    failures++;
+  }
+
+  memset(&vars, 0, sizeof(vars));
+  vars._module               = &TWI0;
+  vars._bools._clientEnabled = 1;
+  vars.user_onRequest        = onRequest;
+  for (int n = 0; n < 40; n++) {
+    registerRead(n);
+    plainWriteAndRead(n);
+  }
+
+  printf("%s\n", failures ? "FAILED" : "passed");
+  return failures ? 1 : 0;
+}
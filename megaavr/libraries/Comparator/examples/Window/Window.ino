@@ -0,0 +1,64 @@
+/***********************************************************************|
+| Modern AVR Comparator library - window comparator and timestamps      |
+|                                                                       |
+| AVR DA or DB only - this uses all three comparators.                  |
+|                                                                       |
+| AC0 and AC1 watch PD2 as a window comparator, with both limits set by |
+| their DACREFs from the 2.048V reference. Each time the signal leaves  |
+| the window, the interrupt counts it; every time it rises through the  |
+| lower limit, TCB1 records exactly when. Once a second, we print the   |
+| count, a coarse measurement of the input made with AC2's DACREF, and  |
+| the time between the last two upward crossings.                       |
+|                                                                       |
+| TCB1 must not be the millis timer.                                    |
+|***********************************************************************/
+
+#include <Comparator.h>
+#include <ComparatorCapture.h>
+
+ComparatorWindow window(Comparator0, Comparator1);
+volatile uint16_t excursions = 0;
+
+void outOfRange() {
+  excursions++;
+}
+
+void setup() {
+  Serial.begin(115200);
+  Comparator0.input_p   = comparator::in_p::in0;      // PD2 - the signal
+  Comparator0.input_n   = comparator::in_n::dacref;   // bottom of the window
+  Comparator1.input_n   = comparator::in_n::dacref;   // top of the window
+  Comparator0.reference = comparator::ref::vref_2v048;
+  if (!window.init()) {
+    Serial.println("Can't pair those comparators");
+  }
+  window.setLimits(64, 192);                           // 0.512 V to 1.536 V
+  window.attachInterrupt(outOfRange, comparator::window::int_outside);
+  window.start();
+
+  Comparator2.input_p   = comparator::in_p::in0;      // PD2 again, just for measure()
+  Comparator2.input_n   = comparator::in_n::dacref;
+  Comparator2.init();
+  Comparator2.start();
+
+  // Comparator0's output goes high when the input rises through the bottom of the window
+  ComparatorCapture1.begin(Comparator0, RISING);
+}
+
+void loop() {
+  static uint32_t last = 0;
+  static uint32_t period = 0;
+  while (ComparatorCapture1.available()) {
+    uint32_t t = ComparatorCapture1.read();
+    period = t - last;
+    last = t;
+  }
+  Serial.print("Excursions: ");
+  Serial.print(excursions);
+  Serial.print("  input ~");
+  Serial.print((uint32_t) Comparator2.measure() * 2048 / 256);
+  Serial.print(" mV  period: ");
+  Serial.print(period / (ComparatorCapture::ticksPerSecond() / 1000000));
+  Serial.println(" us");
+  delay(1000);
+}
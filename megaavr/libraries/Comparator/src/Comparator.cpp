@@ -662,3 +662,26 @@ void AnalogComparator::stop(bool restorepins) {
     #endif
   }
 }
+
+#if defined(DXCORE)
+uint8_t AnalogComparator::measure(uint8_t settle) {
+  uint8_t dacref_was  = AC.DACREF;
+  uint8_t ctrla_was   = AC.CTRLA;
+  uint8_t muxctrl_was = AC.MUXCTRL;
+  // Hysteresis would bias every comparison toward the last result, and inversion would flip them all.
+  AC.CTRLA   = ctrla_was & ~AC_HYSMODE_gm;
+  AC.MUXCTRL = muxctrl_was & ~AC_INVERT_bm;
+  uint8_t code = 0;
+  for (uint8_t bit = 0x80; bit; bit >>= 1) {
+    AC.DACREF = code | bit;
+    delayMicroseconds(settle);
+    if (read()) {                 // input above this DACREF, so keep the bit
+      code |= bit;
+    }
+  }
+  AC.MUXCTRL = muxctrl_was;
+  AC.CTRLA   = ctrla_was;
+  AC.DACREF  = dacref_was;
+  return code;
+}
+#endif
@@ -205,6 +205,24 @@ namespace comparator {
     disable    = 0x08,
     };
   };
+
+  #if defined(DXCORE) && defined(AC1)
+    namespace window {
+      // where the input is, from ComparatorWindow::state()
+      enum state_t : uint8_t {
+        above       = 0x00,   // above both limits
+        inside      = 0x40,
+        below       = 0x80,   // below both limits
+      };
+      // when ComparatorWindow::attachInterrupt() fires
+      enum interrupt_t : uint8_t {
+        int_above   = 0x00,   // goes above the upper limit
+        int_inside  = 0x10,   // comes back inside the window
+        int_below   = 0x20,   // goes below the lower limit
+        int_outside = 0x30,   // leaves the window either way
+      };
+    };
+  #endif
 };
 
 // Legacy definitions
@@ -316,6 +334,12 @@ class AnalogComparator {
     AC_t& getPeripheral() {
       return AC;
     }
+    #if defined(DXCORE)
+      // Measure the positive input against the DACREF by successive approximation, with input_n set to dacref and
+      // the comparator started: 8 comparisons, settle microseconds each. Returns the DACREF code; the input is about
+      // code / 256 of the reference. Leaves the DACREF as it was.
+      uint8_t measure(uint8_t settle = 1);
+    #endif
 
     comparator::out::output_t      output         = comparator::out::disable;
     #if defined(DXCORE)
@@ -406,4 +430,26 @@ class AnalogComparator {
   extern AnalogComparator Comparator2;
 #endif
 
+#if defined(DXCORE) && defined(AC1)
+/* Two comparators as one window comparator. Both get the same positive input (that of lower); the negative input
+ * of lower is the bottom of the window, and that of upper, which must be the next comparator or (where there is
+ * one) the one after, is the top. With both negative inputs on dacref, setLimits() moves the window on the fly.
+ * State and interrupt are those of lower. */
+class ComparatorWindow {
+  public:
+    ComparatorWindow(AnalogComparator &lower, AnalogComparator &upper) : _lower(lower), _upper(upper) {}
+    bool init();                                   // false if upper can't be paired with lower
+    void start(bool state = true);
+    void stop(bool restorepins = false);
+    void setLimits(uint8_t low, uint8_t high);    // the two DACREFs
+    comparator::window::state_t state();
+    void attachInterrupt(voidFuncPtr callback, comparator::window::interrupt_t mode);
+    void detachInterrupt();
+
+  private:
+    AnalogComparator &_lower;
+    AnalogComparator &_upper;
+};
+#endif
+
 #endif
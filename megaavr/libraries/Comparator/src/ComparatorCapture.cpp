@@ -0,0 +1,112 @@
+/* ComparatorCapture.cpp - timestamps of comparator crossings, captured by a TCB through the event system.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ * Each ComparatorCaptureN is in a file of its own with TCBn's vector, which the library's archive only pulls in
+ * when a sketch names that object - a sketch capturing with TCB2 can still have its own TCB0 or TCB1 interrupt.
+ */
+#include "ComparatorCapture.h"
+
+uint8_t ComparatorCapture::begin(AnalogComparator &comparator, uint8_t edge) {
+  if (edge != RISING && edge != FALLING && edge != CHANGE) {
+    return COMPARATOR_CAPTURE_BAD_ARGUMENT;
+  }
+  end();
+  Event &ch = Event::assign_generator(Event::gen_from_peripheral(comparator.getPeripheral()));
+  _channel = ch.get_channel_number();
+  if (_channel == 255) {
+    return COMPARATOR_CAPTURE_NO_CHANNEL;
+  }
+  _change   = (edge == CHANGE);
+  _head     = 0;
+  _tail     = 0;
+  _high     = 0;
+  _overflow = 0;
+  _timer.CTRLA    = 0;
+  _timer.CTRLB    = TCB_CNTMODE_CAPT_gc;          // free running, CNT copied to CCMP on the event
+  // For CHANGE, start with whichever edge comes next.
+  _timer.EVCTRL   = TCB_CAPTEI_bm | ((edge == FALLING || (_change && comparator.read())) ? TCB_EDGE_bm : 0);
+  _timer.CNT      = 0;
+  _timer.INTFLAGS = TCB_CAPT_bm | TCB_OVF_bm;
+  _timer.INTCTRL  = TCB_CAPT_bm | TCB_OVF_bm;
+  ch.set_user(Event::user_from_peripheral(_timer, 0));
+  ch.start();
+  _timer.CTRLA    = TCB_CLKSEL_DIV2_gc | TCB_ENABLE_bm;
+  return COMPARATOR_CAPTURE_OK;
+}
+
+void ComparatorCapture::end() {
+  if (_channel == 255) {
+    return;
+  }
+  _timer.CTRLA   = 0;
+  _timer.INTCTRL = 0;
+  _timer.EVCTRL  = 0;
+  Event::clear_user(Event::user_from_peripheral(_timer, 0));
+  Event &ch = Event::get_channel(_channel);
+  ch.stop();
+  ch.set_generator(event::gen::disable);
+  _channel = 255;
+}
+
+uint8_t ComparatorCapture::available() {
+  return (_head - _tail) & (COMPARATOR_CAPTURE_BUFFER - 1);
+}
+
+uint32_t ComparatorCapture::read() {
+  if (_head == _tail) {
+    return 0;
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  uint32_t t = _buffer[_tail];
+  _tail = (_tail + 1) & (COMPARATOR_CAPTURE_BUFFER - 1);
+  SREG = oldSREG;
+  return t;
+}
+
+uint32_t ComparatorCapture::now() {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint16_t count = _timer.CNT;
+  uint16_t high  = _high;
+  // An overflow the interrupt hasn't counted yet (we're in a critical section, or this is called from an ISR).
+  if ((_timer.INTFLAGS & TCB_OVF_bm) && count < 0x8000) {
+    high++;
+  }
+  SREG = oldSREG;
+  return ((uint32_t) high << 16) | count;
+}
+
+bool ComparatorCapture::overflow() {
+  uint8_t oldSREG = SREG;
+  cli();
+  bool ret = _overflow;
+  _overflow = 0;
+  SREG = oldSREG;
+  return ret;
+}
+
+void ComparatorCapture::_service() {
+  uint8_t flags = _timer.INTFLAGS;
+  if (flags & TCB_CAPT_bm) {
+    uint16_t count = _timer.CCMP;                  // also clears CAPT
+    uint16_t high  = _high;
+    // If the counter has wrapped since and we haven't counted it yet, a small count was captured after the wrap.
+    if ((flags & TCB_OVF_bm) && count < 0x8000) {
+      high++;
+    }
+    if (_change) {
+      _timer.EVCTRL ^= TCB_EDGE_bm;
+    }
+    uint8_t next = (_head + 1) & (COMPARATOR_CAPTURE_BUFFER - 1);
+    if (next == _tail) {
+      _overflow = 1;
+    } else {
+      _buffer[_head] = ((uint32_t) high << 16) | count;
+      _head = next;
+    }
+  }
+  if (flags & TCB_OVF_bm) {
+    _timer.INTFLAGS = TCB_OVF_bm;
+    _high++;
+  }
+}
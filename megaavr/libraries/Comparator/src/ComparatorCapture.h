@@ -0,0 +1,71 @@
+/* ComparatorCapture.h - timestamps of comparator crossings, captured by a TCB through the event system.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ *
+ * The comparator's output is an event generator; a TCB in input capture mode, running from CLK_PER/2, copies its
+ * count into CCMP on the chosen edge, so the timestamp is exact to the timer clock no matter how late the interrupt
+ * that collects it is. The interrupt extends it to 32 bits (the TCB's overflows are counted in the same vector),
+ * and puts it in a small buffer. ComparatorCaptureN uses TCBn, and any of them can watch any of the comparators;
+ * there's none on the millis timer's TCB.
+ */
+#ifndef COMPARATORCAPTURE_H
+#define COMPARATORCAPTURE_H
+
+#include <Arduino.h>
+#include <Event.h>
+#include "Comparator.h"
+
+#if !defined(DXCORE)
+  #error "ComparatorCapture is only supported on DxCore"
+#endif
+
+#define COMPARATOR_CAPTURE_BUFFER   8   // must be a power of 2
+
+// begin() return values
+#define COMPARATOR_CAPTURE_OK           0
+#define COMPARATOR_CAPTURE_BAD_ARGUMENT 1  // edge is not RISING, FALLING or CHANGE, or the TCB is the millis timer
+#define COMPARATOR_CAPTURE_NO_CHANNEL   2  // out of event channels
+
+class ComparatorCapture {
+  public:
+    explicit ComparatorCapture(TCB_t &timer) : _timer(timer) {}
+    // The comparator has to be set up and started separately. CHANGE works by flipping the edge in the interrupt
+    // after each capture, so two crossings closer together than the interrupt latency will lose the second one.
+    uint8_t  begin(AnalogComparator &comparator, uint8_t edge = RISING);
+    void     end();
+    uint8_t  available();       // how many timestamps are waiting
+    uint32_t read();            // the oldest one, in timer ticks (CLK_PER/2); 0 if there are none
+    uint32_t now();             // the current time on the same clock, to compare them with
+    bool     overflow();        // true once if timestamps were dropped because the buffer was full
+    static uint32_t ticksPerSecond() {
+      return getCPUFrequency() / 2;
+    }
+
+    void     _service();        // called by the TCB interrupt
+  private:
+    TCB_t             &_timer;
+    uint8_t            _channel  = 255;     // 255 = not started
+    uint8_t            _change   = 0;       // flip the edge after each capture
+    volatile uint8_t   _overflow = 0;
+    volatile uint8_t   _head     = 0;
+    volatile uint8_t   _tail     = 0;
+    volatile uint16_t  _high     = 0;       // the TCB's overflows: the top 16 bits of the time
+    volatile uint32_t  _buffer[COMPARATOR_CAPTURE_BUFFER];
+};
+
+#if defined(TCB0) && !defined(MILLIS_USE_TIMERB0)
+  extern ComparatorCapture ComparatorCapture0;
+#endif
+#if defined(TCB1) && !defined(MILLIS_USE_TIMERB1)
+  extern ComparatorCapture ComparatorCapture1;
+#endif
+#if defined(TCB2) && !defined(MILLIS_USE_TIMERB2)
+  extern ComparatorCapture ComparatorCapture2;
+#endif
+#if defined(TCB3) && !defined(MILLIS_USE_TIMERB3)
+  extern ComparatorCapture ComparatorCapture3;
+#endif
+#if defined(TCB4) && !defined(MILLIS_USE_TIMERB4)
+  extern ComparatorCapture ComparatorCapture4;
+#endif
+
+#endif
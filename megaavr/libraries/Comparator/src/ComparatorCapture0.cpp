@@ -0,0 +1,10 @@
+/* ComparatorCapture0.cpp - ComparatorCapture0, on TCB0, and TCB0's interrupt. */
+#include "ComparatorCapture.h"
+
+#if defined(TCB0) && !defined(MILLIS_USE_TIMERB0)
+  ComparatorCapture ComparatorCapture0(TCB0);
+
+  ISR(TCB0_INT_vect) {
+    ComparatorCapture0._service();
+  }
+#endif
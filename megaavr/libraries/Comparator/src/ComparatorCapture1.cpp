@@ -0,0 +1,10 @@
+/* ComparatorCapture1.cpp - ComparatorCapture1, on TCB1, and TCB1's interrupt. */
+#include "ComparatorCapture.h"
+
+#if defined(TCB1) && !defined(MILLIS_USE_TIMERB1)
+  ComparatorCapture ComparatorCapture1(TCB1);
+
+  ISR(TCB1_INT_vect) {
+    ComparatorCapture1._service();
+  }
+#endif
@@ -0,0 +1,10 @@
+/* ComparatorCapture2.cpp - ComparatorCapture2, on TCB2, and TCB2's interrupt. */
+#include "ComparatorCapture.h"
+
+#if defined(TCB2) && !defined(MILLIS_USE_TIMERB2)
+  ComparatorCapture ComparatorCapture2(TCB2);
+
+  ISR(TCB2_INT_vect) {
+    ComparatorCapture2._service();
+  }
+#endif
@@ -0,0 +1,10 @@
+/* ComparatorCapture3.cpp - ComparatorCapture3, on TCB3, and TCB3's interrupt. */
+#include "ComparatorCapture.h"
+
+#if defined(TCB3) && !defined(MILLIS_USE_TIMERB3)
+  ComparatorCapture ComparatorCapture3(TCB3);
+
+  ISR(TCB3_INT_vect) {
+    ComparatorCapture3._service();
+  }
+#endif
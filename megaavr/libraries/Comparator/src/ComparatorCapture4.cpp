@@ -0,0 +1,10 @@
+/* ComparatorCapture4.cpp - ComparatorCapture4, on TCB4, and TCB4's interrupt. */
+#include "ComparatorCapture.h"
+
+#if defined(TCB4) && !defined(MILLIS_USE_TIMERB4)
+  ComparatorCapture ComparatorCapture4(TCB4);
+
+  ISR(TCB4_INT_vect) {
+    ComparatorCapture4._service();
+  }
+#endif
@@ -0,0 +1,81 @@
+#include "Comparator.h"
+
+#if defined(DXCORE) && defined(AC1)
+/* The pin behind each positive input mux setting, as (port << 4) | bit, for AC0, AC1 and AC2. IN P0 and P3 are the
+ * same pin on every comparator, but P1 and P2 are not, so the upper comparator may need a different setting to
+ * watch the same pin - or, if it can't reach it at all, the pair can't make a window on that pin. */
+static const uint8_t windowInputP[3][4] = {
+  {0x32, 0x40, 0x42, 0x36},   // AC0: PD2, PE0, PE2, PD6
+  {0x32, 0x33, 0x34, 0x36},   // AC1: PD2, PD3, PD4, PD6
+  {0x32, 0x34, 0x41, 0x36},   // AC2: PD2, PD4, PE1, PD6
+};
+
+bool ComparatorWindow::init() {
+  AC_t &lower = _lower.getPeripheral();
+  AC_t &upper = _upper.getPeripheral();
+  // WINSEL picks the upper comparator relative to this one: the next, or on parts with 3, the one after that.
+  uint8_t winsel = AC_WINSEL_DISABLED_gc;
+  if (&upper == &lower + 1) {
+    winsel = AC_WINSEL_UPSEL1_gc;
+  }
+  #if defined(AC2)
+    if (&upper == &lower + 2) {
+      winsel = AC_WINSEL_UPSEL2_gc;
+    }
+  #endif
+  if (winsel == AC_WINSEL_DISABLED_gc) {
+    return false;
+  }
+  uint8_t input = _lower.input_p;
+  if (input < 4) {
+    uint8_t lowerNum = &lower - &AC0;
+    uint8_t pin      = windowInputP[lowerNum][input];
+    input = 0xFF;
+    for (uint8_t i = 0; i < 4; i++) {
+      if (windowInputP[lowerNum + (winsel == AC_WINSEL_UPSEL1_gc ? 1 : 2)][i] == pin) {
+        input = i;
+        break;
+      }
+    }
+    if (input == 0xFF) {
+      return false;                   // the upper comparator can't see that pin
+    }
+  }                                   // (IN P4, where there is one, is shared)
+  _upper.input_p = (comparator::in_p::inputP_t) input;
+  _lower.init();
+  _upper.init();
+  lower.CTRLB = winsel;
+  return true;
+}
+
+void ComparatorWindow::start(bool state) {
+  _upper.start(state);
+  _lower.start(state);
+}
+
+void ComparatorWindow::stop(bool restorepins) {
+  _lower.stop(restorepins);
+  _upper.stop(restorepins);
+}
+
+void ComparatorWindow::setLimits(uint8_t low, uint8_t high) {
+  _lower.dacref = low;
+  _upper.dacref = high;
+  _lower.getPeripheral().DACREF = low;
+  _upper.getPeripheral().DACREF = high;
+}
+
+comparator::window::state_t ComparatorWindow::state() {
+  return (comparator::window::state_t) (_lower.getPeripheral().STATUS & AC_WINSTATE_gm);
+}
+
+void ComparatorWindow::attachInterrupt(voidFuncPtr callback, comparator::window::interrupt_t mode) {
+  // The lower comparator's vector and handler are used; only the condition is different.
+  _lower.attachInterrupt(callback, CHANGE);
+  _lower.getPeripheral().INTCTRL = mode | AC_CMP_bm;
+}
+
+void ComparatorWindow::detachInterrupt() {
+  _lower.detachInterrupt();
+}
+#endif
@@ -0,0 +1,55 @@
+/* Buttons.ino - debounced buttons, two ways.
+ *
+ * A start button on PIN_PA2 goes through Logic0's filter to TCB1: one interrupt per press or release, 20 ms after
+ * the first edge, however much it bounces. Four more buttons on PIN_PC0 to PIN_PC3 are sampled by the RTC's periodic
+ * interrupt every 3.9 ms, and each has to read the same 4 times in a row to count. All of them are wired between the
+ * pin and ground, with the internal pullups on, so pressed is LOW.
+ *
+ * TCB1 must not be the millis timer (Tools -> millis()/micros()); use another DebouncedInputN if it is.
+ */
+#include <DebouncedInput.h>
+
+volatile uint8_t presses = 0;
+
+void startButton(uint8_t state) {
+  if (!state) {         // pressed
+    presses++;
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  pinMode(PIN_PA2, INPUT_PULLUP);
+  uint8_t err = DebouncedInput1.begin(PIN_PA2, 20000, 0);   // 20 ms lockout, filtered by Logic0 clocked from OSC1K
+  if (err) {
+    Serial.print("DebouncedInput1.begin() failed: ");
+    Serial.println(err);
+  }
+  DebouncedInput1.attachInterrupt(startButton);
+
+  for (uint8_t pin = PIN_PC0; pin <= PIN_PC3; pin++) {
+    pinMode(pin, INPUT_PULLUP);
+    Debouncer.add(pin);
+  }
+  Debouncer.begin();
+}
+
+void loop() {
+  static uint8_t lastPresses = 0;
+  if (presses != lastPresses) {
+    lastPresses = presses;
+    Serial.print("Start button presses: ");
+    Serial.println(lastPresses);
+  }
+  uint8_t changes = Debouncer.changedPort(PC);      // all four at once
+  if (changes) {
+    uint8_t state = Debouncer.readPort(PC);
+    for (uint8_t bit = 0; bit < 4; bit++) {
+      if (changes & (1 << bit)) {
+        Serial.print("PC");
+        Serial.print(bit);
+        Serial.println((state & (1 << bit)) ? " released" : " pressed");
+      }
+    }
+  }
+}
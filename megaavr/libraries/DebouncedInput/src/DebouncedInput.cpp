@@ -0,0 +1,178 @@
+/* DebouncedInput.cpp - switch and contact debouncing in hardware, or in one periodic interrupt for many pins.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ * DebouncedInputN and its ISR are in DebouncedInputN.cpp, one file per TCB, since defining an ISR claims the
+ * vector; the rest of the TCBs stay free. DebouncedPorts is in DebouncedPorts.cpp.
+ */
+#include "DebouncedInput.h"
+
+#if defined(CCL_TRUTH5)
+  #define _DEBOUNCE_LOGIC_BLOCKS 6
+#else
+  #define _DEBOUNCE_LOGIC_BLOCKS 4
+#endif
+
+uint8_t DebouncedInput::begin(uint8_t pin, uint16_t lockout, int8_t logicBlockNumber, logic::clocksource::clocksource_t filterClock) {
+  uint8_t port = digitalPinToPort(pin);
+  if (port == NOT_A_PIN || logicBlockNumber >= _DEBOUNCE_LOGIC_BLOCKS || _isMillisTCB(&_timer)) {
+    return DEBOUNCE_BAD_ARGUMENT;
+  }
+  // Work out the timer clock: CLK_PER/2 if the lockout fits in 16 bits of it, otherwise TCA0's prescaled clock.
+  uint8_t  clksel = TCB_CLKSEL_DIV2_gc;
+  uint32_t ticks  = (getCPUFrequency() / 2000UL) * lockout / 1000;
+  if (ticks > 0xFFFF) {
+    uint8_t tca = TCA0.SINGLE.CTRLA;
+    if (!(tca & TCA_SINGLE_ENABLE_bm)) {
+      return DEBOUNCE_BAD_ARGUMENT;
+    }
+    ticks  = (ticks << 1) >> _tcaPrescaleShift(tca);
+    clksel = TCB_CLKSEL_TCA0_gc;
+    if (ticks > 0xFFFF) {
+      return DEBOUNCE_BAD_ARGUMENT;
+    }
+  }
+  end();
+  Event &pinChannel = Event::assign_generator_pin(pin);
+  _channel[0] = pinChannel.get_channel_number();
+  Event *trigger = &pinChannel;
+  if (logicBlockNumber >= 0) {
+    trigger = &Event::assign_generator(Event::gen_from_peripheral(CCL, logicBlockNumber));
+    _channel[1] = trigger->get_channel_number();
+  }
+  if (_channel[0] == 255 || (logicBlockNumber >= 0 && _channel[1] == 255)) {
+    _release();
+    return DEBOUNCE_NO_CHANNEL;
+  }
+  _logic = logicBlockNumber;
+  if (_logic >= 0) {
+    Logic &block = Logic::forBlock(_logic);
+    Logic::stop();
+    pinChannel.set_user(Event::user_from_peripheral(CCL, _logic * 2));
+    block.enable      = true;
+    block.input0      = logic::in::event_a;
+    block.input1      = logic::in::masked;
+    block.input2      = logic::in::masked;
+    block.truth       = 0xAA;                     // in0, once it has been steady for a few CCL clocks
+    block.filter      = logic::filter::filter;
+    block.clocksource = filterClock;
+    block.edgedetect  = logic::edgedetect::disable;
+    block.sequencer   = logic::sequencer::disable;
+    block.init();
+    Logic::start();
+  }
+  _in   = &((VPORT_t *) &VPORTA)[port].IN;
+  _mask = digitalPinToBitMask(pin);
+  _state   = (*_in & _mask) ? 1 : 0;
+  _changed = 0;
+
+  _timer.CTRLA    = 0;
+  _timer.CTRLB    = TCB_CNTMODE_SINGLE_gc;        // start on an edge, ignore further ones until CNT reaches CCMP
+  _timer.EVCTRL   = TCB_CAPTEI_bm | TCB_EDGE_bm;  // either edge
+  _timer.CCMP     = ticks;
+  _timer.CNT      = ticks;                        // not running until the first edge
+  _timer.INTFLAGS = TCB_CAPT_bm | TCB_OVF_bm;
+  _timer.INTCTRL  = TCB_CAPT_bm;
+  trigger->set_user(Event::user_from_peripheral(_timer, 0));
+  pinChannel.start();
+  trigger->start();
+  _timer.CTRLA    = clksel | TCB_ENABLE_bm;
+  return DEBOUNCE_OK;
+}
+
+void DebouncedInput::end() {
+  if (!_mask) {
+    return;
+  }
+  _timer.CTRLA   = 0;
+  _timer.INTCTRL = 0;
+  _timer.EVCTRL  = 0;
+  Event::clear_user(Event::user_from_peripheral(_timer, 0));
+  if (_logic >= 0) {
+    Logic::stop();
+    Event::clear_user(Event::user_from_peripheral(CCL, _logic * 2));
+    Logic::forBlock(_logic).enable = false;
+    Logic::forBlock(_logic).init();
+    Logic::start();
+    _logic = -1;
+  }
+  _release();
+  _mask = 0;
+}
+
+void DebouncedInput::_release() {
+  for (uint8_t i = 0; i < 2; i++) {
+    if (_channel[i] != 255) {
+      Event &ch = Event::get_channel(_channel[i]);
+      ch.stop();
+      ch.set_generator(event::gen::disable);
+      _channel[i] = 255;
+    }
+  }
+}
+
+bool DebouncedInput::read() {
+  return _state;
+}
+
+bool DebouncedInput::changed() {
+  uint8_t oldSREG = SREG;
+  cli();
+  bool ret = _changed;
+  _changed = 0;
+  SREG = oldSREG;
+  return ret;
+}
+
+bool DebouncedInput::rose() {
+  uint8_t oldSREG = SREG;
+  cli();
+  bool ret = _changed && _state;
+  if (ret) {
+    _changed = 0;
+  }
+  SREG = oldSREG;
+  return ret;
+}
+
+bool DebouncedInput::fell() {
+  uint8_t oldSREG = SREG;
+  cli();
+  bool ret = _changed && !_state;
+  if (ret) {
+    _changed = 0;
+  }
+  SREG = oldSREG;
+  return ret;
+}
+
+void DebouncedInput::attachInterrupt(void (*handler)(uint8_t state)) {
+  _handler = handler;
+}
+
+void DebouncedInput::detachInterrupt() {
+  _handler = NULL;
+}
+
+void DebouncedInput::attachEvent(Event &channel) {
+  _event = channel.get_channel_number();
+}
+
+void DebouncedInput::detachEvent() {
+  _event = 255;
+}
+
+void DebouncedInput::_service() {
+  _timer.INTFLAGS = TCB_CAPT_bm;
+  // The lockout is over. If the pin is still where the edge that started it took it, that was a real transition;
+  // if it bounced back, or the edge was a glitch, nothing happened.
+  uint8_t level = (*_in & _mask) ? 1 : 0;
+  if (level != _state) {
+    _state   = level;
+    _changed = 1;
+    if (_event != 255) {
+      Event::get_channel(_event).soft_event();
+    }
+    if (_handler != NULL) {
+      _handler(level);
+    }
+  }
+}
@@ -0,0 +1,118 @@
+/* DebouncedInput.h - switch and contact debouncing in hardware, or in one periodic interrupt for many pins.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ *
+ * DebouncedInputN - one pin, one TCB. The pin's event (optionally through a logic block with its filter on, which
+ *   drops glitches shorter than a few CCL clocks) starts TCBn in single-shot mode on either edge. Further edges are
+ *   ignored until it times out; then the TCB interrupt reads the pin, and if it differs from the last stable level,
+ *   that is a clean transition: the flag is set, and the handler and/or a software event on a channel are fired.
+ *   One interrupt per press or release, however much the contact bounces. DebouncedInputN runs on TCBn; the
+ *   millis timer's TCB has none.
+ *
+ * DebouncedPorts (the Debouncer object) - any number of slow inputs, on any ports, sampled together by one
+ *   periodic interrupt (the RTC PIT, or a call to sample() from your own timer) with a 2-bit vertical counter per
+ *   pin: a pin has to read the same for 4 samples in a row before its state changes. Each port takes a handful of
+ *   instructions per sample, whether one pin is being watched or all eight.
+ */
+#ifndef DEBOUNCEDINPUT_H
+#define DEBOUNCEDINPUT_H
+
+#include <Arduino.h>
+#include <Event.h>
+#include <Logic.h>
+
+#if defined(TINY_0_OR_1_SERIES)
+  #error "DebouncedInput is not supported on tinyAVR 0/1-series parts"
+#endif
+
+// begin() return values
+#define DEBOUNCE_OK                 0
+#define DEBOUNCE_BAD_ARGUMENT       1  // not a pin, no such logic block, or the lockout is too long for the timer clock
+#define DEBOUNCE_NO_CHANNEL         2  // out of event channels, or no free channel can take the pin
+#define DEBOUNCE_TIMER_IN_USE       3  // the RTC PIT is already running
+
+class DebouncedInput {
+  public:
+    explicit DebouncedInput(TCB_t &timer) : _timer(timer) {}
+    // Takes over the TCB. lockout is how long to ignore the pin after an edge, in microseconds; up to ~5 ms is timed
+    // from CLK_PER/2, longer from TCA0's prescaled clock, which must be running (it is, unless you took it over and
+    // stopped it). logicBlock -1 sends the pin straight to the TCB; 0 or more filters it through that block first,
+    // clocked from filterClock. The pinMode is left alone, and the current level is taken as the stable state.
+    uint8_t begin(uint8_t pin, uint16_t lockout, int8_t logicBlock = -1, logic::clocksource::clocksource_t filterClock = logic::clocksource::osc1k);
+    void    end();
+    bool    read();       // the debounced level
+    bool    changed();    // true once after each clean transition
+    bool    rose();       // true once after a clean low-to-high transition
+    bool    fell();       // true once after a clean high-to-low transition
+    // Called from the TCB interrupt with the new level, after each clean transition.
+    void    attachInterrupt(void (*handler)(uint8_t state));
+    void    detachInterrupt();
+    // A software event on this channel after each clean transition, so peripherals can act on it. Any event user
+    // can be connected to it; the channel's generator is left alone (set it to disable if it has none).
+    void    attachEvent(Event &channel);
+    void    detachEvent();
+
+    void    _service();   // called by the TCB interrupt
+  private:
+    void              _release();
+    TCB_t            &_timer;
+    void            (*_handler)(uint8_t) = NULL;
+    volatile uint8_t *_in         = NULL;  // VPORTn.IN for the pin
+    uint8_t           _mask       = 0;     // 0 = not started
+    volatile uint8_t  _state      = 0;
+    volatile uint8_t  _changed    = 0;
+    int8_t            _logic      = -1;
+    uint8_t           _channel[2] = {255, 255};
+    uint8_t           _event      = 255;   // channel for the soft event, 255 = none
+};
+
+#if defined(TCB0) && !defined(MILLIS_USE_TIMERB0)
+  extern DebouncedInput DebouncedInput0;
+#endif
+#if defined(TCB1) && !defined(MILLIS_USE_TIMERB1)
+  extern DebouncedInput DebouncedInput1;
+#endif
+#if defined(TCB2) && !defined(MILLIS_USE_TIMERB2)
+  extern DebouncedInput DebouncedInput2;
+#endif
+#if defined(TCB3) && !defined(MILLIS_USE_TIMERB3)
+  extern DebouncedInput DebouncedInput3;
+#endif
+#if defined(TCB4) && !defined(MILLIS_USE_TIMERB4)
+  extern DebouncedInput DebouncedInput4;
+#endif
+
+class DebouncedPorts {
+  public:
+    // Sample with the RTC PIT, every period RTC clocks (RTC_PERIOD_CYC32_gc to RTC_PERIOD_CYC32768_gc). The default,
+    // 128 clocks of the 32.768 kHz internal oscillator, is 3.9 ms, so a pin has to be steady for about 16 ms.
+    // If millis is on the RTC, its clock source is used. Returns DEBOUNCE_TIMER_IN_USE if the PIT is already on.
+    uint8_t begin(uint8_t period = RTC_PERIOD_CYC128_gc);
+    void    end();
+    // Start and stop watching a pin. add() takes its current level as the stable state.
+    void    add(uint8_t pin);
+    void    remove(uint8_t pin);
+    bool    read(uint8_t pin);
+    bool    changed(uint8_t pin);    // true once after each change of that pin
+    bool    rose(uint8_t pin);
+    bool    fell(uint8_t pin);
+    // Whole ports at a time (port is PA, PB, ... as returned by digitalPinToPort()).
+    uint8_t readPort(uint8_t port);
+    uint8_t changedPort(uint8_t port);    // the pins that changed since the last call, and clears them
+    // Called from the sampling interrupt with the port and the pins in it that just changed.
+    void    attachInterrupt(void (*handler)(uint8_t port, uint8_t changes));
+    void    detachInterrupt();
+    // Take one sample of every watched port. Called by the PIT interrupt; call it yourself instead of begin() if you
+    // have a periodic interrupt already, at interrupt level or with interrupts off.
+    void    sample();
+  private:
+    void            (*_handler)(uint8_t, uint8_t) = NULL;
+    uint8_t           _mask[NUM_TOTAL_PORTS]    = {0};
+    volatile uint8_t  _state[NUM_TOTAL_PORTS]   = {0};
+    volatile uint8_t  _changes[NUM_TOTAL_PORTS] = {0};
+    uint8_t           _ct0[NUM_TOTAL_PORTS]     = {0};    // the vertical counters: bit n of _ct1:_ct0 counts the
+    uint8_t           _ct1[NUM_TOTAL_PORTS]     = {0};    // samples in a row that pin n has differed from its state
+};
+
+extern DebouncedPorts Debouncer;
+
+#endif
@@ -0,0 +1,10 @@
+/* DebouncedInput0.cpp - DebouncedInput0, on TCB0, and TCB0's interrupt. */
+#include "DebouncedInput.h"
+
+#if defined(TCB0) && !defined(MILLIS_USE_TIMERB0)
+  DebouncedInput DebouncedInput0(TCB0);
+
+  ISR(TCB0_INT_vect) {
+    DebouncedInput0._service();
+  }
+#endif
@@ -0,0 +1,10 @@
+/* DebouncedInput1.cpp - DebouncedInput1, on TCB1, and TCB1's interrupt. */
+#include "DebouncedInput.h"
+
+#if defined(TCB1) && !defined(MILLIS_USE_TIMERB1)
+  DebouncedInput DebouncedInput1(TCB1);
+
+  ISR(TCB1_INT_vect) {
+    DebouncedInput1._service();
+  }
+#endif
@@ -0,0 +1,10 @@
+/* DebouncedInput2.cpp - DebouncedInput2, on TCB2, and TCB2's interrupt. */
+#include "DebouncedInput.h"
+
+#if defined(TCB2) && !defined(MILLIS_USE_TIMERB2)
+  DebouncedInput DebouncedInput2(TCB2);
+
+  ISR(TCB2_INT_vect) {
+    DebouncedInput2._service();
+  }
+#endif
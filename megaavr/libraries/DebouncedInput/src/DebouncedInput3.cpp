@@ -0,0 +1,10 @@
+/* DebouncedInput3.cpp - DebouncedInput3, on TCB3, and TCB3's interrupt. */
+#include "DebouncedInput.h"
+
+#if defined(TCB3) && !defined(MILLIS_USE_TIMERB3)
+  DebouncedInput DebouncedInput3(TCB3);
+
+  ISR(TCB3_INT_vect) {
+    DebouncedInput3._service();
+  }
+#endif
@@ -0,0 +1,10 @@
+/* DebouncedInput4.cpp - DebouncedInput4, on TCB4, and TCB4's interrupt. */
+#include "DebouncedInput.h"
+
+#if defined(TCB4) && !defined(MILLIS_USE_TIMERB4)
+  DebouncedInput DebouncedInput4(TCB4);
+
+  ISR(TCB4_INT_vect) {
+    DebouncedInput4._service();
+  }
+#endif
@@ -0,0 +1,137 @@
+/* DebouncedPorts.cpp - debouncing many slow inputs at once, with vertical counters.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ * begin(), end() and the PIT interrupt are in DebouncedPortsPIT.cpp, so that the vector is only taken if the PIT
+ * is used to do the sampling.
+ */
+#include "DebouncedInput.h"
+
+DebouncedPorts Debouncer;
+
+void DebouncedPorts::add(uint8_t pin) {
+  uint8_t port = digitalPinToPort(pin);
+  if (port == NOT_A_PIN) {
+    return;
+  }
+  uint8_t bit = digitalPinToBitMask(pin);
+  uint8_t oldSREG = SREG;
+  cli();
+  _state[port]   = (_state[port] & ~bit) | (((VPORT_t *) &VPORTA)[port].IN & bit);
+  _changes[port] &= ~bit;
+  _ct0[port]     &= ~bit;
+  _ct1[port]     &= ~bit;
+  _mask[port]    |= bit;
+  SREG = oldSREG;
+}
+
+void DebouncedPorts::remove(uint8_t pin) {
+  uint8_t port = digitalPinToPort(pin);
+  if (port == NOT_A_PIN) {
+    return;
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  _mask[port] &= ~digitalPinToBitMask(pin);
+  SREG = oldSREG;
+}
+
+bool DebouncedPorts::read(uint8_t pin) {
+  uint8_t port = digitalPinToPort(pin);
+  if (port == NOT_A_PIN) {
+    return false;
+  }
+  return _state[port] & digitalPinToBitMask(pin);
+}
+
+bool DebouncedPorts::changed(uint8_t pin) {
+  uint8_t port = digitalPinToPort(pin);
+  if (port == NOT_A_PIN) {
+    return false;
+  }
+  uint8_t bit = digitalPinToBitMask(pin);
+  uint8_t oldSREG = SREG;
+  cli();
+  bool ret = _changes[port] & bit;
+  _changes[port] &= ~bit;
+  SREG = oldSREG;
+  return ret;
+}
+
+bool DebouncedPorts::rose(uint8_t pin) {
+  uint8_t port = digitalPinToPort(pin);
+  if (port == NOT_A_PIN) {
+    return false;
+  }
+  uint8_t bit = digitalPinToBitMask(pin);
+  uint8_t oldSREG = SREG;
+  cli();
+  bool ret = _changes[port] & _state[port] & bit;
+  if (ret) {
+    _changes[port] &= ~bit;
+  }
+  SREG = oldSREG;
+  return ret;
+}
+
+bool DebouncedPorts::fell(uint8_t pin) {
+  uint8_t port = digitalPinToPort(pin);
+  if (port == NOT_A_PIN) {
+    return false;
+  }
+  uint8_t bit = digitalPinToBitMask(pin);
+  uint8_t oldSREG = SREG;
+  cli();
+  bool ret = _changes[port] & ~_state[port] & bit;
+  if (ret) {
+    _changes[port] &= ~bit;
+  }
+  SREG = oldSREG;
+  return ret;
+}
+
+uint8_t DebouncedPorts::readPort(uint8_t port) {
+  return (port < NUM_TOTAL_PORTS) ? (_state[port] & _mask[port]) : 0;
+}
+
+uint8_t DebouncedPorts::changedPort(uint8_t port) {
+  if (port >= NUM_TOTAL_PORTS) {
+    return 0;
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  uint8_t ret = _changes[port];
+  _changes[port] = 0;
+  SREG = oldSREG;
+  return ret;
+}
+
+void DebouncedPorts::attachInterrupt(void (*handler)(uint8_t port, uint8_t changes)) {
+  _handler = handler;
+}
+
+void DebouncedPorts::detachInterrupt() {
+  _handler = NULL;
+}
+
+void DebouncedPorts::sample() {
+  for (uint8_t port = 0; port < NUM_TOTAL_PORTS; port++) {
+    uint8_t mask = _mask[port];
+    if (!mask) {
+      continue;
+    }
+    // Eight 2-bit counters side by side: bit n of ct1:ct0 counts the samples in a row that pin n has differed from
+    // its state. Any sample that agrees clears it, and the fourth that doesn't wraps it to 0 and toggles the state.
+    uint8_t delta  = (((VPORT_t *) &VPORTA)[port].IN ^ _state[port]) & mask;
+    uint8_t ct1    = (_ct1[port] ^ _ct0[port]) & delta;
+    uint8_t ct0    = ~_ct0[port] & delta;
+    uint8_t toggle = delta & ~(ct0 | ct1);
+    _ct1[port] = ct1;
+    _ct0[port] = ct0;
+    if (toggle) {
+      _state[port]   ^= toggle;
+      _changes[port] |= toggle;
+      if (_handler != NULL) {
+        _handler(port, toggle);
+      }
+    }
+  }
+}
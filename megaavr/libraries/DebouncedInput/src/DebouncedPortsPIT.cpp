@@ -0,0 +1,33 @@
+/* DebouncedPortsPIT.cpp - sampling the Debouncer's ports with the RTC's periodic interrupt. Only linked in if
+ * Debouncer.begin() is used.
+ */
+#include "DebouncedInput.h"
+
+uint8_t DebouncedPorts::begin(uint8_t period) {
+  if (RTC.PITCTRLA & RTC_PITEN_bm) {
+    return DEBOUNCE_TIMER_IN_USE;
+  }
+  #if !defined(MILLIS_USE_TIMERRTC)
+    // The PIT runs from the RTC's clock. If nothing has the RTC, run it from the internal 32.768 kHz oscillator.
+    if (!(RTC.CTRLA & RTC_RTCEN_bm)) {
+      while (RTC.STATUS & RTC_CTRLABUSY_bm);
+      RTC.CLKSEL = RTC_CLKSEL_OSC32K_gc;
+    }
+  #endif
+  while (RTC.PITSTATUS & RTC_CTRLBUSY_bm);
+  RTC.PITINTFLAGS = RTC_PI_bm;
+  RTC.PITINTCTRL  = RTC_PI_bm;
+  RTC.PITCTRLA    = (period & RTC_PERIOD_gm) | RTC_PITEN_bm;
+  return DEBOUNCE_OK;
+}
+
+void DebouncedPorts::end() {
+  while (RTC.PITSTATUS & RTC_CTRLBUSY_bm);
+  RTC.PITCTRLA   = 0;
+  RTC.PITINTCTRL = 0;
+}
+
+ISR(RTC_PIT_vect) {
+  RTC.PITINTFLAGS = RTC_PI_bm;
+  Debouncer.sample();
+}
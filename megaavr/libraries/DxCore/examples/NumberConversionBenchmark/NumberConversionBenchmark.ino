@@ -0,0 +1,74 @@
+/*
+Number conversion benchmark
+
+Times ultoa() from avr-libc against the divide-free fast_utoa10(), fast_utoa16() and fast_fixtoa() in num_fast.h,
+which Print and String now use, and prints the average number of system clocks per conversion. The values are
+chosen to have 1, 5 and 10 digits, since the cost of the division based approach grows with every digit.
+
+The clock count is micros() before and after ITERATIONS conversions, scaled by F_CPU, so
+the few clocks spent on the loop itself are included in every figure.
+*/
+#include <num_fast.h>
+
+#define ITERATIONS 1000
+
+const uint32_t testValues[] = {7UL, 31415UL, 4294967295UL};
+volatile uint8_t sink;  // so the compiler can't throw the conversions away
+
+uint32_t clocksPer(uint32_t start, uint32_t end) {
+  return ((end - start) * (F_CPU / 1000000UL)) / ITERATIONS;
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(100);
+  char buf[16];
+  for (uint8_t i = 0; i < 3; i++) {
+    uint32_t v = testValues[i];
+    Serial.iprintf("Value %lu\r\n", v);
+
+    uint32_t start = micros();
+    for (uint16_t n = 0; n < ITERATIONS; n++) {
+      ultoa(v, buf, 10);
+      sink = buf[0];
+    }
+    Serial.iprintf("  ultoa(v, buf, 10):      %lu clocks\r\n", clocksPer(start, micros()));
+
+    start = micros();
+    for (uint16_t n = 0; n < ITERATIONS; n++) {
+      sink = fast_utoa10(v, buf);
+    }
+    Serial.iprintf("  fast_utoa10(v, buf):    %lu clocks\r\n", clocksPer(start, micros()));
+
+    start = micros();
+    for (uint16_t n = 0; n < ITERATIONS; n++) {
+      ultoa(v, buf, 16);
+      sink = buf[0];
+    }
+    Serial.iprintf("  ultoa(v, buf, 16):      %lu clocks\r\n", clocksPer(start, micros()));
+
+    start = micros();
+    for (uint16_t n = 0; n < ITERATIONS; n++) {
+      sink = fast_utoa16(v, buf, 1);
+    }
+    Serial.iprintf("  fast_utoa16(v, buf, 1): %lu clocks\r\n", clocksPer(start, micros()));
+
+    int32_t half = v >> 1;    // fast_fixtoa() takes a signed value
+    float f = half / 1000.0;
+    start = micros();
+    for (uint16_t n = 0; n < ITERATIONS; n++) {
+      dtostrf(f, 4, 3, buf);
+      sink = buf[0];
+    }
+    Serial.iprintf("  dtostrf(half / 1000.0): %lu clocks\r\n", clocksPer(start, micros()));
+
+    start = micros();
+    for (uint16_t n = 0; n < ITERATIONS; n++) {
+      sink = fast_fixtoa(half, 3, buf);
+    }
+    Serial.iprintf("  fast_fixtoa(half, 3):   %lu clocks\r\n", clocksPer(start, micros()));
+  }
+}
+
+void loop() {
+}
@@ -0,0 +1,106 @@
+/*
+printf benchmark
+
+Times one formatted line, like a typical log line, through:
+  * printf() the way it used to work - vfprintf() calling write(c) through the vtable for every character,
+    reproduced here as unbufferedPrintf(),
+  * printf() as it is now, which collects the output in a buffer and hands it over with write(buffer, size),
+  * iprintf(), which does the same buffering but its own integer-only formatting,
+  * and the same line as a string of print() calls,
+and prints the average number of system clocks per line for each.
+
+The output goes to a Print that just counts characters, so the figures are the cost of formatting and of getting the
+characters to the destination, not of sending them anywhere - that would depend on the baud rate. A real destination
+pays its own cost per write(buffer, size) call and per character on top, which is also what the buffering saves on:
+HardwareSerial's write(buffer, size) puts the characters in its buffer without a virtual call for each.
+
+The clock count is micros() before and after ITERATIONS lines, scaled by F_CPU, so the loop itself is included.
+*/
+
+#define ITERATIONS 200
+
+class NullPrint : public Print {
+  public:
+    uint32_t count = 0;
+    virtual size_t write(uint8_t c) {
+      (void) c;
+      count++;
+      return 1;
+    }
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+      (void) buffer;
+      count += size;
+      return size;
+    }
+};
+
+NullPrint out;
+
+// What Print::printf() used to do.
+static int unbufferedPut(char c, FILE *fp) {
+  ((Print *) fdev_get_udata(fp))->write((uint8_t) c);
+  return 0;
+}
+
+int16_t unbufferedPrintf(Print &dest, const char *format, ...) {
+  FILE f;
+  va_list ap;
+  fdev_setup_stream(&f, unbufferedPut, NULL, _FDEV_SETUP_WRITE);
+  fdev_set_udata(&f, &dest);
+  va_start(ap, format);
+  int16_t ret = vfprintf(&f, format, ap);
+  va_end(ap);
+  return ret;
+}
+
+uint32_t clocksPer(uint32_t start, uint32_t end) {
+  return ((end - start) * (F_CPU / 1000000UL)) / ITERATIONS;
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(100);
+  volatile uint32_t t = 123456;       // volatile, so the compiler can't format anything ahead of time
+  volatile uint16_t adc = 1023;
+  volatile uint8_t  state = 1;
+  uint32_t start;
+
+  Serial.iprintf("Line: \"T=%lu ms, ADC=%04x, %s\\n\" (%u characters)\r\n", t, adc, state ? "on" : "off",
+                 out.iprintf("T=%lu ms, ADC=%04x, %s\n", t, adc, state ? "on" : "off"));
+
+  start = micros();
+  for (uint16_t n = 0; n < ITERATIONS; n++) {
+    unbufferedPrintf(out, "T=%lu ms, ADC=%04x, %s\n", t, adc, state ? "on" : "off");
+  }
+  Serial.iprintf("  printf(), unbuffered:  %lu clocks\r\n", clocksPer(start, micros()));
+
+  start = micros();
+  for (uint16_t n = 0; n < ITERATIONS; n++) {
+    out.printf("T=%lu ms, ADC=%04x, %s\n", t, adc, state ? "on" : "off");
+  }
+  Serial.iprintf("  printf(), buffered:    %lu clocks\r\n", clocksPer(start, micros()));
+
+  start = micros();
+  for (uint16_t n = 0; n < ITERATIONS; n++) {
+    out.iprintf("T=%lu ms, ADC=%04x, %s\n", t, adc, state ? "on" : "off");
+  }
+  Serial.iprintf("  iprintf():             %lu clocks\r\n", clocksPer(start, micros()));
+
+  start = micros();
+  for (uint16_t n = 0; n < ITERATIONS; n++) {
+    out.print("T=");
+    out.print(t);
+    out.print(" ms, ADC=");
+    uint16_t a = adc;
+    for (uint8_t shift = 12; shift < 16; shift -= 4) {   // %04x
+      out.print((a >> shift) & 0x0F, HEX);
+    }
+    out.print(", ");
+    out.print(state ? "on" : "off");
+    out.print('\n');
+  }
+  Serial.iprintf("  print() calls:         %lu clocks\r\n", clocksPer(start, micros()));
+}
+
+void loop() {
+}
@@ -92,6 +92,37 @@ bool setTCA0MuxByPin(uint8_t pin);
 
   uint8_t getMVIOStatus(bool printInfo = 0, HardwareSerial &dbgserial = Serial);
 #endif
+// in OSCHFTune.cpp
+// Software tuning of the internal oscillator against an external reference, for boards without a 32 kHz crystal.
+// The measureOSCHFvs...() functions return the clock error in ppm (positive = fast) or OSCHF_MEASURE_FAILED,
+// and tuneOSCHF() adjusts CLKCTRL.OSCHFTUNE using one of them. See README.md.
+#define OSCHF_MEASURE_FAILED        ((int32_t)0x80000000)
+#define OSCHF_TUNE_NOT_INTERNAL     (0x0100) // Main clock isn't the internal oscillator.
+#define OSCHF_TUNE_AUTOTUNE_ON      (0x0101) // Hardware autotune is enabled, and would just overwrite it.
+#define OSCHF_TUNE_NO_REFERENCE     (0x0102) // The measurement function failed.
+#define OSCHF_TUNE_NOT_STORED       (0x0103) // Nothing stored in the USERROW to apply.
+#define OSCHF_TUNE_NO_TEMPERATURE   (-32768) // Temperature couldn't be read - also pass as temperature to storeOSCHFTune() to have it read it.
+#define OSCHF_STORE_NO_USERSIG      (-1)     // USERSIG.h wasn't included in the sketch.
+#define OSCHF_STORE_NO_TEMPERATURE  (-2)
+#define OSCHF_STORE_FAILED          (-3)
+
+// The last 8 bytes of the USERROW: magic, band applied at startup, then one byte per temperature band.
+#define OSCHF_TUNE_USERROW_OFFSET   (USER_SIGNATURES_SIZE - 8)
+#define OSCHF_TUNE_MAGIC            (0x4F)
+#define OSCHF_TUNE_BANDS            (6)      // below 5 C, 5-20, 20-35, 35-50, 50-65, 65 and up
+#define OSCHF_TUNE_BAND_LOW         (5)
+#define OSCHF_TUNE_BAND_WIDTH       (15)
+
+#ifdef __cplusplus
+  int32_t measureOSCHFvsRTC(uint16_t ticks = 4096);  // vs the RTC clock, which must be running from a 32.768 kHz crystal or clock (not OSC32K, it's worse than OSCHF)
+  int32_t measureOSCHFvsPPS(uint8_t pin);            // vs a 1 Hz pulse (like a GPS PPS output) on pin.
+  int32_t measureOSCHFvsUART(USART_t &usart, uint32_t baud, uint16_t timeout = 1000); // vs a break + 0x55 sync from the other end at baud.
+  int16_t tuneOSCHF(int32_t (*measure)(), uint8_t maxiterations = 8); // returns the new OSCHFTUNE value (-128 to 127) or an OSCHF_TUNE error.
+  int8_t  storeOSCHFTune(int8_t tune, int16_t temperature = OSCHF_TUNE_NO_TEMPERATURE); // Needs USERSIG.h. Returns band or OSCHF_STORE error.
+  int16_t applyOSCHFTune();                          // reads the temperature, applies best stored value, returns it or an OSCHF_TUNE error.
+  int16_t getOSCHFTuneTemperature();                 // Degrees C from the internal sensor.
+#endif
+
 // Reset immdiately using software reset. The bootloader, if present will run.
 
 inline void SoftwareReset() {
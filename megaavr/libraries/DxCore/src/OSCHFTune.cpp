@@ -0,0 +1,270 @@
+#include "Arduino.h"
+#include "DxCore.h"
+
+/* Software tuning of the internal high frequency oscillator against an external reference.
+ * The measurement functions each return the error of the main clock in ppm (positive = running fast),
+ * or OSCHF_MEASURE_FAILED. tuneOSCHF() takes one of those (or anything else with the same signature) and walks
+ * CLKCTRL.OSCHFTUNE to the setting with the smallest error. The results can be stored to the USERROW in one
+ * of several temperature bands, and the DxCore library applies the stored value during init_clock().
+ */
+
+/* These come from USERSIG.h if the sketch includes it. Weak references so that nobody who doesn't save the
+ * tuning is forced to pull it in - they'll just be null. */
+int8_t __USigwrite(uint8_t idx, uint8_t data) __attribute__((weak));
+int8_t __USigflush(uint8_t justerase)         __attribute__((weak));
+
+#define OSCHF_TUNE_USERROW(n) (*((volatile uint8_t *) USER_SIGNATURES_START + OSCHF_TUNE_USERROW_OFFSET + (n)))
+
+/* Applied from init_clock(), before anything else is initialized, so we can't read the temperature yet;
+ * we use whichever band was stored most recently, and applyOSCHFTune() can pick a better one later. */
+void init_clock_tune() {
+  if ((CLKCTRL.MCLKCTRLA & 0x0F) || (CLKCTRL.OSCHFCTRLA & 0x01)) {
+    return;                                           // Not on internal oscillator, or hardware autotune is in charge
+  }
+  if (OSCHF_TUNE_USERROW(0) != OSCHF_TUNE_MAGIC) {
+    return;
+  }
+  uint8_t band = OSCHF_TUNE_USERROW(1);
+  if (band < OSCHF_TUNE_BANDS) {
+    uint8_t stored = OSCHF_TUNE_USERROW(2 + band);
+    if (stored != 0xFF) {
+      _PROTECTED_WRITE(CLKCTRL.OSCHFTUNE, (uint8_t) (stored - 0x80));
+    }
+  }
+}
+
+int16_t getOSCHFTuneTemperature() {
+  /* Per the datasheet, with the 2.048V reference at 12 bits, and a long sample duration */
+  uint8_t tempRef = _getAnalogReferenceReg();        // (with ALWAYSON)
+  uint8_t tempDur = getAnalogSampleDuration();
+  analogReference(INTERNAL2V048);
+  analogSampleDuration(128);
+  analogRead(ADC_TEMPERATURE);                        // exercise the ADC with this reference
+  int32_t reading = analogReadEnh(ADC_TEMPERATURE, 12);
+  _setAnalogReferenceReg(tempRef);
+  analogSampleDuration(tempDur);
+  if (reading < 0) {
+    return OSCHF_TUNE_NO_TEMPERATURE;
+  }
+  return _analogTempToCelsius(reading);
+}
+
+static uint8_t _tempToBand(int16_t temp) {
+  if (temp < OSCHF_TUNE_BAND_LOW) {
+    return 0;
+  }
+  uint8_t band = ((temp - OSCHF_TUNE_BAND_LOW) / OSCHF_TUNE_BAND_WIDTH) + 1;
+  return (band >= OSCHF_TUNE_BANDS ? OSCHF_TUNE_BANDS - 1 : band);
+}
+
+/* ppm = 1000000 * diff / expected, without overflowing when expected is large or resorting to 64-bit math */
+static int32_t _toPPM(int32_t diff, uint32_t expected) {
+  if (expected > 100000) {
+    return (diff * 1000) / (int32_t) (expected / 1000);
+  }
+  return ((diff * 31250) / (int32_t) expected) * 32;
+}
+
+int32_t measureOSCHFvsRTC(uint16_t ticks) {
+  #if defined(MILLIS_USE_TIMERNONE) || defined(MILLIS_USE_TIMERRTC)
+    badCall("measureOSCHFvsRTC() requires micros(), so millis must be on a TCA or TCB.");
+  #endif
+  if (!(RTC.CTRLA & RTC_RTCEN_bm) || ((RTC.CLKSEL & 0x03) == 0x01) || ((RTC.CLKSEL & 0x03) == 0x03)) {
+    return OSCHF_MEASURE_FAILED;                      // needs to be running, from a 32.768 kHz source
+  }
+  uint8_t prescale = (RTC.CTRLA & RTC_PRESCALER_gm) >> RTC_PRESCALER_gp;
+  /* 1000000 / 32768 = 15625 / 512 us per RTC clock */
+  uint32_t expected = ((uint32_t) ticks * 15625UL) >> 9;
+  expected <<= prescale;
+  /* Count each change in the count, rather than subtracting, so we don't care what PER is. Line up with a tick
+   * first, so that we start and stop at the same point in a tick, and the only error is loop latency.    */
+  uint32_t timeout = millis();
+  uint16_t last = RTC.CNT;
+  while (RTC.CNT == last) {
+    if (millis() - timeout > 2000) {
+      return OSCHF_MEASURE_FAILED;
+    }
+  }
+  uint32_t start = micros();
+  last = RTC.CNT;
+  uint16_t count = 0;
+  while (count < ticks) {
+    uint16_t now = RTC.CNT;
+    if (now != last) {
+      last = now;
+      count++;
+    }
+  }
+  uint32_t elapsed = micros() - start;
+  return _toPPM((int32_t) (elapsed - expected), expected);
+}
+
+int32_t measureOSCHFvsPPS(uint8_t pin) {
+  #if defined(MILLIS_USE_TIMERNONE) || defined(MILLIS_USE_TIMERRTC)
+    badCall("measureOSCHFvsPPS() requires micros(), so millis must be on a TCA or TCB.");
+  #endif
+  uint8_t port = digitalPinToPort(pin);
+  uint8_t mask = digitalPinToBitMask(pin);
+  if (port == NOT_A_PIN) {
+    return OSCHF_MEASURE_FAILED;
+  }
+  volatile uint8_t *in = portInputRegister(port);
+  uint32_t start = 0;
+  uint32_t timeout = millis();
+  /* Three edges: the first gets us lined up, and the time between the next two is the measurement */
+  for (uint8_t edges = 0; edges < 3; edges++) {
+    while (*in & mask) {
+      if (millis() - timeout > 2500) {
+        return OSCHF_MEASURE_FAILED;
+      }
+    }
+    while (!(*in & mask)) {
+      if (millis() - timeout > 2500) {
+        return OSCHF_MEASURE_FAILED;
+      }
+    }
+    uint32_t now = micros();
+    if (edges == 1) {
+      start = now;
+      timeout = millis();
+    } else if (edges == 2) {
+      return _toPPM((int32_t) (now - start - 1000000UL), 1000000UL);
+    }
+  }
+  return OSCHF_MEASURE_FAILED;
+}
+
+int32_t measureOSCHFvsUART(USART_t &usart, uint32_t baud, uint16_t timeout) {
+  /* Use the generic autobaud mode: the other end sends a break and then 0x55, the hardware measures the sync
+   * character against our clock and puts the result in BAUD. If our clock is fast, the BAUD it calculates is
+   * larger than the one it would be at exactly the nominal clock, by the same ratio.                      */
+  uint8_t  ctrlb   = usart.CTRLB;
+  uint16_t oldbaud = usart.BAUD;
+  uint32_t expected = (4 * getCPUFrequency()) / baud;
+  usart.CTRLB  = (ctrlb & ~USART_RXMODE_gm) | USART_RXMODE_GENAUTO_gc | USART_RXEN_bm;
+  usart.STATUS = USART_WFB_bm | USART_BDF_bm | USART_ISFIF_bm;
+  int32_t retval = OSCHF_MEASURE_FAILED;
+  uint32_t started = millis();
+  while (millis() - started < timeout) {
+    uint8_t status = usart.STATUS;
+    if (status & USART_BDF_bm) {
+      retval = _toPPM((int32_t) usart.BAUD - (int32_t) expected, expected);
+      break;
+    }
+    if (status & USART_ISFIF_bm) {                    // Something other than a sync - clear it and wait for the next break
+      usart.STATUS = USART_ISFIF_bm | USART_WFB_bm;
+      usart.CTRLB  = usart.CTRLB & ~USART_RXEN_bm;    // See the ISFIF erratum in HardwareSerial::getStatus()
+      usart.CTRLB  = usart.CTRLB | USART_RXEN_bm;
+    }
+  }
+  usart.STATUS = USART_BDF_bm | USART_ISFIF_bm;
+  usart.CTRLB  = ctrlb & ~USART_RXEN_bm;              // mode bits are enable-protected
+  usart.BAUD   = oldbaud;
+  usart.CTRLB  = ctrlb;
+  return retval;
+}
+
+int16_t tuneOSCHF(int32_t (*measure)(), uint8_t maxiterations) {
+  if (CLKCTRL.MCLKCTRLA & 0x0F) {
+    return OSCHF_TUNE_NOT_INTERNAL;
+  }
+  if (CLKCTRL.OSCHFCTRLA & 0x01) {
+    return OSCHF_TUNE_AUTOTUNE_ON;                    // Hardware autotune would just overwrite it
+  }
+  int8_t  tune = CLKCTRL.OSCHFTUNE;
+  int32_t err  = measure();
+  if (err == OSCHF_MEASURE_FAILED) {
+    return OSCHF_TUNE_NO_REFERENCE;
+  }
+  int8_t  besttune = tune;
+  int32_t besterr  = err;
+  int32_t perstep  = 0;                               // ppm per step of OSCHFTUNE, once we know it.
+  while (maxiterations--) {
+    int16_t next;
+    if (perstep == 0) {
+      next = tune + (err > 0 ? -1 : 1);               // Higher TUNE is a faster clock.
+    } else {
+      next = tune - ((err + (err > 0 ? perstep / 2 : -perstep / 2)) / perstep);
+    }
+    if (next > 127) {
+      next = 127;
+    } else if (next < -128) {
+      next = -128;
+    }
+    if (next == tune) {
+      break;
+    }
+    _PROTECTED_WRITE(CLKCTRL.OSCHFTUNE, (uint8_t) next);
+    int32_t newerr = measure();
+    if (newerr == OSCHF_MEASURE_FAILED) {
+      _PROTECTED_WRITE(CLKCTRL.OSCHFTUNE, (uint8_t) besttune);
+      return OSCHF_TUNE_NO_REFERENCE;
+    }
+    int32_t slope = (newerr - err) / (next - tune);     // ppm per step: positive, as a higher TUNE runs faster
+    if (slope > 0) {
+      perstep = slope;
+    }
+    tune = next;
+    err  = newerr;
+    if (labs(err) < labs(besterr)) {
+      besttune = tune;
+      besterr  = err;
+    }
+    if (perstep && labs(err) <= perstep / 2) {
+      break;                                          // within half a step, as good as it gets.
+    }
+  }
+  _PROTECTED_WRITE(CLKCTRL.OSCHFTUNE, (uint8_t) besttune);
+  return besttune;
+}
+
+int8_t storeOSCHFTune(int8_t tune, int16_t temperature) {
+  if (!__USigwrite || !__USigflush) {
+    return OSCHF_STORE_NO_USERSIG;
+  }
+  if (temperature == OSCHF_TUNE_NO_TEMPERATURE) {
+    temperature = getOSCHFTuneTemperature();
+    if (temperature == OSCHF_TUNE_NO_TEMPERATURE) {
+      return OSCHF_STORE_NO_TEMPERATURE;
+    }
+  }
+  if (tune == 127) {
+    tune = 126;                                       // stored as tune + 0x80, and 0xFF means nothing stored
+  }
+  uint8_t band = _tempToBand(temperature);
+  uint8_t base = OSCHF_TUNE_USERROW_OFFSET;
+  if (OSCHF_TUNE_USERROW(0) != OSCHF_TUNE_MAGIC) {
+    __USigwrite(base, OSCHF_TUNE_MAGIC);
+    for (uint8_t i = 0; i < OSCHF_TUNE_BANDS; i++) {
+      __USigwrite(base + 2 + i, 0xFF);
+    }
+  }
+  __USigwrite(base + 1, band);
+  __USigwrite(base + 2 + band, (uint8_t) tune + 0x80);
+  return __USigflush(0) < 0 ? OSCHF_STORE_FAILED : band;
+}
+
+int16_t applyOSCHFTune() {
+  if (OSCHF_TUNE_USERROW(0) != OSCHF_TUNE_MAGIC) {
+    return OSCHF_TUNE_NOT_STORED;
+  }
+  if ((CLKCTRL.MCLKCTRLA & 0x0F) || (CLKCTRL.OSCHFCTRLA & 0x01)) {
+    return OSCHF_TUNE_NOT_INTERNAL;
+  }
+  int16_t temp = getOSCHFTuneTemperature();
+  if (temp == OSCHF_TUNE_NO_TEMPERATURE) {
+    return OSCHF_TUNE_NO_TEMPERATURE;
+  }
+  /* Use the band we're in, or failing that, the nearest one that has been calibrated */
+  int8_t want = _tempToBand(temp);
+  for (uint8_t dist = 0; dist < OSCHF_TUNE_BANDS; dist++) {
+    for (int8_t b = want - dist; b <= want + dist; b += (dist ? 2 * dist : 1)) {
+      if (b >= 0 && b < OSCHF_TUNE_BANDS && OSCHF_TUNE_USERROW(2 + b) != 0xFF) {
+        int8_t tune = OSCHF_TUNE_USERROW(2 + b) - 0x80;
+        _PROTECTED_WRITE(CLKCTRL.OSCHFTUNE, (uint8_t) tune);
+        return tune;
+      }
+    }
+  }
+  return OSCHF_TUNE_NOT_STORED;
+}
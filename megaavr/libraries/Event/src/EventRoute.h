@@ -0,0 +1,269 @@
+/* EventRoute.h - compile time event channel allocation for the Event library.
+ *
+ * Describe each connection as a route - one generator and the users it drives - and list all of them in one
+ * EventRouting. The channels are picked by the compiler, so running out of channels, or two generators that
+ * can only go on the same channel, or a user that two routes both want, is a compile error instead of an
+ * Event_empty at runtime; begin() is just the register writes.
+ *
+ *   typedef EventRoute<gen::tca0_ovf_lunf, user::adc0_start, user::tcb1_capt> AdcTrigger;
+ *   typedef EventRoute<gen2::pin_pc3, user::ccl0_event_a>                       PinToLogic;
+ *   typedef EventRouting<AdcTrigger, PinToLogic>                                 Routing;
+ *
+ *   Routing::begin();                                  // in setup()
+ *   uint8_t ch = Routing::channel<AdcTrigger>();       // compile time constant, if you need to know.
+ *
+ * Generators from the gen:: namespace can go on any channel; those from genN:: only on channel N. Fixed
+ * channels are handed out first, then the rest starting from the highest channel, like assign_generator(),
+ * which leaves the low channels (the only ones that can take pins on some parts) free for later. Routes with the
+ * same generator share a channel. The EventN objects are updated too, so assign_generator() and friends used at
+ * runtime afterwards know these channels are taken.
+ *
+ * Not available on tinyAVR 0/1-series, where the event system is too different.
+ */
+#ifndef EVENTROUTE_H
+#define EVENTROUTE_H
+
+#include "Event.h"
+
+#if defined(TINY_0_OR_1_SERIES)
+  #error "EventRoute is not supported on tinyAVR 0/1-series parts"
+#endif
+
+#if   defined(EVSYS_CHANNEL15)
+  #define _EVENTROUTE_CHANNELS 16
+#elif defined(EVSYS_CHANNEL9)
+  #define _EVENTROUTE_CHANNELS 10
+#elif defined(EVSYS_CHANNEL7)
+  #define _EVENTROUTE_CHANNELS 8
+#elif defined(EVSYS_CHANNEL5)
+  #define _EVENTROUTE_CHANNELS 6
+#else
+  #define _EVENTROUTE_CHANNELS 4
+#endif
+
+namespace event {
+  namespace route {
+    // Which channel a generator of a given enum type has to go on; -1 = any.
+    template <typename T> struct fixed_channel                { static constexpr int8_t value = -1; };
+    #if !defined(PORT_EVGEN0SEL_gm)
+      #if defined(EVSYS_CHANNEL0)
+        template <> struct fixed_channel<event::gen0::generator_t> { static constexpr int8_t value = 0; };
+      #endif
+      #if defined(EVSYS_CHANNEL1) && (!defined(MEGATINYCORE) || defined(HAS_SEPARATE_GEN1))
+        template <> struct fixed_channel<event::gen1::generator_t> { static constexpr int8_t value = 1; };
+      #endif
+      #if defined(EVSYS_CHANNEL2)
+        template <> struct fixed_channel<event::gen2::generator_t> { static constexpr int8_t value = 2; };
+      #endif
+      #if defined(EVSYS_CHANNEL3) && (!defined(MEGATINYCORE) || defined(HAS_SEPARATE_GEN3))
+        template <> struct fixed_channel<event::gen3::generator_t> { static constexpr int8_t value = 3; };
+      #endif
+      #if defined(EVSYS_CHANNEL4) && (!defined(MEGATINYCORE) || defined(HAS_SEPARATE_GEN4))
+        template <> struct fixed_channel<event::gen4::generator_t> { static constexpr int8_t value = 4; };
+      #endif
+      #if defined(EVSYS_CHANNEL5)
+        template <> struct fixed_channel<event::gen5::generator_t> { static constexpr int8_t value = 5; };
+      #endif
+      #if defined(EVSYS_CHANNEL6)
+        template <> struct fixed_channel<event::gen6::generator_t> { static constexpr int8_t value = 6; };
+      #endif
+      #if defined(EVSYS_CHANNEL7)
+        template <> struct fixed_channel<event::gen7::generator_t> { static constexpr int8_t value = 7; };
+      #endif
+      #if defined(EVSYS_CHANNEL8)
+        template <> struct fixed_channel<event::gen8::generator_t> { static constexpr int8_t value = 8; };
+      #endif
+      #if defined(EVSYS_CHANNEL9)
+        template <> struct fixed_channel<event::gen9::generator_t> { static constexpr int8_t value = 9; };
+      #endif
+    #endif
+
+    template <typename A, typename B> struct same_type       { static constexpr bool value = false; };
+    template <typename A>             struct same_type<A, A> { static constexpr bool value = true;  };
+
+    // The EventN object for channel N, so the runtime side of the library sees what we did.
+    template <uint8_t N> Event &channel_object();
+    #if defined(EVSYS_CHANNEL0)
+      template <> inline Event &channel_object<0>() {return Event0;}
+    #endif
+    #if defined(EVSYS_CHANNEL1)
+      template <> inline Event &channel_object<1>() {return Event1;}
+    #endif
+    #if defined(EVSYS_CHANNEL2)
+      template <> inline Event &channel_object<2>() {return Event2;}
+    #endif
+    #if defined(EVSYS_CHANNEL3)
+      template <> inline Event &channel_object<3>() {return Event3;}
+    #endif
+    #if defined(EVSYS_CHANNEL4)
+      template <> inline Event &channel_object<4>() {return Event4;}
+    #endif
+    #if defined(EVSYS_CHANNEL5)
+      template <> inline Event &channel_object<5>() {return Event5;}
+    #endif
+    #if defined(EVSYS_CHANNEL6)
+      template <> inline Event &channel_object<6>() {return Event6;}
+    #endif
+    #if defined(EVSYS_CHANNEL7)
+      template <> inline Event &channel_object<7>() {return Event7;}
+    #endif
+    #if defined(EVSYS_CHANNEL8)
+      template <> inline Event &channel_object<8>() {return Event8;}
+    #endif
+    #if defined(EVSYS_CHANNEL9)
+      template <> inline Event &channel_object<9>() {return Event9;}
+    #endif
+
+    // The PORTMUX bit for the "unofficial" EVOUT users on the alternate pin (bit 7 set in the user number), as in set_user().
+    constexpr uint8_t evout_swap_bit(uint8_t user) {
+      #if defined(__AVR_DA__)
+        return 1 << ((user & 0x7F) - 0x0E);
+      #else
+        return 1 << ((user & 0x7F) - 0x0D);
+      #endif
+    }
+
+    enum error_t : uint8_t {
+      ok = 0,
+      channel_conflict,   // two different generators that can only go on the same channel
+      out_of_channels,
+      user_conflict,      // the same user in two routes
+    };
+
+    template <uint8_t N>
+    struct plan_t {
+      int8_t  channel[N];
+      error_t error;
+    };
+
+    template <uint8_t N>
+    constexpr plan_t<N> allocate(const uint8_t (&gens)[N], const int8_t (&fixed)[N], const uint8_t *const (&users)[N], const uint8_t (&nusers)[N]) {
+      plan_t<N> plan {};
+      plan.error = ok;
+      int16_t onChannel[_EVENTROUTE_CHANNELS] {};
+      for (uint8_t c = 0; c < _EVENTROUTE_CHANNELS; c++) {
+        onChannel[c] = -1;
+      }
+      for (uint8_t i = 0; i < N; i++) {         // the ones that have no choice go first
+        if (fixed[i] >= 0) {
+          if (onChannel[fixed[i]] >= 0 && onChannel[fixed[i]] != gens[i]) {
+            plan.error = channel_conflict;
+          }
+          onChannel[fixed[i]] = gens[i];
+          plan.channel[i] = fixed[i];
+        }
+      }
+      for (uint8_t i = 0; i < N; i++) {
+        if (fixed[i] < 0) {
+          int8_t c = _EVENTROUTE_CHANNELS - 1;
+          while (c >= 0 && onChannel[c] != gens[i]) {   // share a channel with the same generator
+            c--;
+          }
+          if (c < 0) {
+            c = _EVENTROUTE_CHANNELS - 1;
+            while (c >= 0 && onChannel[c] >= 0) {
+              c--;
+            }
+          }
+          if (c < 0) {
+            plan.error = out_of_channels;
+            c = 0;
+          }
+          onChannel[c] = gens[i];
+          plan.channel[i] = c;
+        }
+      }
+      for (uint8_t i = 0; i < N; i++) {
+        for (uint8_t j = i + 1; j < N; j++) {
+          for (uint8_t a = 0; a < nusers[i]; a++) {
+            for (uint8_t b = 0; b < nusers[j]; b++) {
+              if ((users[i][a] & 0x7F) == (users[j][b] & 0x7F)) {
+                plan.error = user_conflict;
+              }
+            }
+          }
+        }
+      }
+      return plan;
+    }
+  }
+}
+
+template <auto Generator, event::user::user_t... Users>
+struct EventRoute {
+  static constexpr uint8_t generator     = (uint8_t) Generator;
+  static constexpr int8_t  fixed_channel = event::route::fixed_channel<decltype(Generator)>::value;
+  static constexpr uint8_t user_count    = sizeof...(Users);
+  static constexpr uint8_t users[sizeof...(Users) + 1] = {(uint8_t) Users..., 0xFF};
+
+  template <uint8_t Channel>
+  static void _connect() {
+    ((((volatile uint8_t *) &EVSYS_USERCCLLUT0A)[Users & 0x7F] = Channel + 1), ...);
+    #if defined(PORTMUX_EVSYSROUTEA)
+      constexpr uint8_t swap = (0 | ... | ((Users & 0x80) ? event::route::evout_swap_bit(Users) : 0));
+      if (swap) {
+        PORTMUX_EVSYSROUTEA |= swap;
+      }
+    #endif
+    event::route::channel_object<Channel>().set_generator((event::gen::generator_t) generator);
+    event::route::channel_object<Channel>().start();
+  }
+
+  template <uint8_t Channel>
+  static void _disconnect() {
+    ((((volatile uint8_t *) &EVSYS_USERCCLLUT0A)[Users & 0x7F] = 0), ...);
+    event::route::channel_object<Channel>().stop();
+    event::route::channel_object<Channel>().set_generator(event::gen::disable);
+  }
+};
+
+template <typename... Routes>
+struct EventRouting {
+  static constexpr uint8_t count = sizeof...(Routes);
+  static_assert(count > 0, "EventRouting needs at least one EventRoute");
+
+  static constexpr uint8_t        _gens[count]   = {Routes::generator...};
+  static constexpr int8_t         _fixed[count]  = {Routes::fixed_channel...};
+  static constexpr const uint8_t *_users[count]  = {Routes::users...};
+  static constexpr uint8_t        _nusers[count] = {Routes::user_count...};
+  static constexpr event::route::plan_t<count> plan = event::route::allocate(_gens, _fixed, _users, _nusers);
+
+  static_assert(plan.error != event::route::channel_conflict, "Two routes have different generators that can only use the same event channel");
+  static_assert(plan.error != event::route::out_of_channels,  "Not enough event channels for all of these routes");
+  static_assert(plan.error != event::route::user_conflict,    "An event user appears in more than one route; a user can only listen to one channel");
+
+  // The channel a route was given. Route must be one of the ones in this EventRouting.
+  template <typename Route>
+  static constexpr uint8_t channel() {
+    constexpr bool match[count] = {event::route::same_type<Route, Routes>::value...};
+    uint8_t i = 0;
+    while (i < count && !match[i]) {
+      i++;
+    }
+    return plan.channel[i];
+  }
+
+  // Connect everything: one store per user and per channel, no searching.
+  static void begin() {
+    _each<0, Routes...>(true);
+  }
+
+  // Disconnect the users and turn the channels off again.
+  static void end() {
+    _each<0, Routes...>(false);
+  }
+
+  template <uint8_t I, typename Route, typename... Rest>
+  static void _each(bool connect) {
+    if (connect) {
+      Route::template _connect<plan.channel[I]>();
+    } else {
+      Route::template _disconnect<plan.channel[I]>();
+    }
+    if constexpr (sizeof...(Rest) > 0) {
+      _each<I + 1, Rest...>(connect);
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,30 @@
+/***********************************************************************|
+| AVR-Dx Configurable Custom Logic library                             |
+|                                                                       |
+| Expression.ino                                                        |
+|                                                                       |
+| In this example we let the compiler work out the logic blocks.       |
+| The same five input NOR as the Five_input_NOR example is written as   |
+| an expression, and Logic::compile() picks the inputs, splits it over  |
+| Logic0 and Logic1 (joined by the link input), and computes both truth |
+| tables - all at compile time.                                         |
+|                                                                       |
+| Output is on PA3: high when PA1, PA2 and PC0-PC2 are all low.         |
+|***********************************************************************/
+
+#include <Logic.h>
+#include <LogicExpr.h>
+
+using namespace logic::expr;
+
+constexpr program_t nor5 = Logic::compile(0, ~(pin1_pullup | pin2_pullup | next_pin0_pullup | next_pin1_pullup | next_pin2_pullup));
+
+void setup() {
+  Logic0.output = logic::out::enable;  // Only the inputs, truth tables and enable are set by the program
+  nor5.init();                         // Configures Logic0 and Logic1
+  Logic::start();
+}
+
+void loop() {
+  // When using configurable custom logic the CPU isn't doing anything!
+}
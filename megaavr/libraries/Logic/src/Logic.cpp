@@ -46,6 +46,26 @@ void Logic::stop() {
   start(false);
 }
 
+// static
+Logic &Logic::forBlock(uint8_t block_number) {
+  switch (block_number) {
+    #if defined(CCL_TRUTH5)
+      case 5:
+        return Logic5;
+      case 4:
+        return Logic4;
+    #endif
+    case 3:
+      return Logic3;
+    case 2:
+      return Logic2;
+    case 1:
+      return Logic1;
+    default:
+      return Logic0;
+  }
+}
+
 static volatile register8_t &PINCTRL(PORT_t &port, const uint8_t pin_bm) {
   if (pin_bm == PIN0_bm) {
     return port.PIN0CTRL;
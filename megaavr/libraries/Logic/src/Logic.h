@@ -8,10 +8,22 @@
  * verbose. This made this file very difficult to use.
  */
 
+// Defined in LogicExpr.h, which must be included to use compile().
+namespace logic {
+  namespace expr {
+    struct expr_t;
+    struct seq_expr_t;
+    struct program_t;
+  };
+};
+
 class Logic {
   public:
     static void start(bool state = true);
     static void stop();
+    static Logic &forBlock(uint8_t block_number);   // Logic0 .. Logic5 by number; Logic0 for one the part lacks
+    static constexpr logic::expr::program_t compile(uint8_t block, const logic::expr::expr_t &expression);
+    static constexpr logic::expr::program_t compile(uint8_t block, const logic::expr::seq_expr_t &expression);
 
     Logic(const uint8_t block_number);
     void init();
@@ -0,0 +1,528 @@
+/* LogicExpr.h - compile time boolean expressions for the Logic library.
+ *
+ * Write what a logic block should compute as an expression, and the compiler works out the inputs and the truth
+ * table - and if it needs more than 3 inputs, splits it over the block and the next one, joined by the link input:
+ *
+ *   #include <Logic.h>
+ *   #include <LogicExpr.h>
+ *   using namespace logic::expr;
+ *
+ *   constexpr logic::expr::program_t glue = Logic::compile(0, pin0 & (event_a | ~ac0));
+ *   constexpr logic::expr::program_t nor5 = Logic::compile(0, ~(pin1_pullup | pin2_pullup | next_pin0_pullup | next_pin1_pullup | next_pin2_pullup));
+ *   constexpr logic::expr::program_t latch = Logic::compile(2, rs_latch(next_event_a, event_b));
+ *
+ *   glue.init();        // sets up Logic0 (and Logic1 if it was needed), call before Logic::start()
+ *
+ * Signals that belong to a particular block - its pins, its two event inputs, and feedback - come in two flavors:
+ * pin0 is input 0 of the block given to compile(), next_pin0 is input 0 of the block after it. Peripheral signals
+ * (ac0, tcb1, usart0 and so on) can be used by either block, but each can only go on one of the three inputs (ac0
+ * on input 0, ac1 on input 1, ...), just like when setting inputN by hand.
+ *
+ * An expression with 4 or 5 signals is split as f = h(g(some of them), the rest): the next block computes g from up
+ * to 3 signals, and this block gets g through its link input, along with up to 2 more signals. Not every function
+ * of 4 or 5 signals can be split like that - if yours can't, that's a compile error, as is using a pin the part
+ * doesn't have (see the pin availability tables in the README), two signals that need the same input, or more
+ * signals than will fit.
+ *
+ * The errors show up as a call to a function with a long name that says what went wrong, like
+ * logic_expr_error_pin_not_available(). For that you need to make the result constexpr, as above; otherwise the
+ * compiler may choose to do the work at runtime and you will get a link error about that function instead.
+ *
+ * Not available on tinyAVR 0/1-series, which have a different set of inputs.
+ */
+#ifndef LOGICEXPR_H
+#define LOGICEXPR_H
+
+#include "Logic.h"
+
+#if defined(TINY_0_OR_1_SERIES)
+  #error "LogicExpr is not supported on tinyAVR 0/1-series parts"
+#endif
+
+#if defined(CCL_TRUTH5)
+  #define _LOGICEXPR_BLOCKS 6
+#else
+  #define _LOGICEXPR_BLOCKS 4
+#endif
+
+// These are never defined; calling one during constant evaluation stops the compile with its name in the message.
+void logic_expr_error_more_than_5_signals();
+void logic_expr_error_cannot_split_over_two_blocks();
+void logic_expr_error_signals_need_the_same_input();
+void logic_expr_error_pin_not_available();
+void logic_expr_error_no_such_block();
+void logic_expr_error_sequencer_needs_even_block();
+void logic_expr_error_link_broken_on_this_part();
+
+namespace logic {
+  namespace expr {
+    enum owner_t : uint8_t {
+      this_block = 0,
+      next_block = 1,
+      any_block  = 2,
+    };
+
+    struct signal_t {
+      uint8_t insel;        // logic::in:: value, including the pin mode bits
+      uint8_t inputs;       // bitmask of the inputs it can go on
+      uint8_t owner;
+    };
+
+    // A function of up to 5 signals. Bit k of table is the value when signal i is (k >> i) & 1.
+    struct expr_t {
+      signal_t signals[5];
+      uint8_t  count;
+      uint32_t table;
+    };
+
+    struct seq_expr_t {
+      expr_t  even;
+      expr_t  odd;
+      uint8_t sequencer;
+    };
+
+    struct lut_config_t {
+      uint8_t insel[3];
+      uint8_t truth;
+    };
+
+    struct program_t {
+      uint8_t      block;
+      uint8_t      luts;       // 1, or 2 if the next block is used too
+      uint8_t      sequencer;  // only touched if this is a sequencer program
+      lut_config_t lut[2];     // lut[0] is block, lut[1] the one after it.
+      void init() const;
+    };
+
+    constexpr expr_t signal(uint8_t insel, uint8_t inputs, uint8_t owner) {
+      return expr_t {{{insel, inputs, owner}}, 1, 0x02};
+    }
+
+    constexpr expr_t low  {{}, 0, 0};
+    constexpr expr_t high {{}, 0, 1};
+
+    // Pins, and the things that are per block.
+    constexpr expr_t pin0               = signal(logic::in::input,        0x01, this_block);
+    constexpr expr_t pin1               = signal(logic::in::input,        0x02, this_block);
+    constexpr expr_t pin2               = signal(logic::in::input,        0x04, this_block);
+    constexpr expr_t pin0_pullup        = signal(logic::in::input_pullup, 0x01, this_block);
+    constexpr expr_t pin1_pullup        = signal(logic::in::input_pullup, 0x02, this_block);
+    constexpr expr_t pin2_pullup        = signal(logic::in::input_pullup, 0x04, this_block);
+    constexpr expr_t event_a            = signal(logic::in::event_a,      0x07, this_block);
+    constexpr expr_t event_b            = signal(logic::in::event_b,      0x07, this_block);
+    constexpr expr_t feedback           = signal(logic::in::feedback,     0x07, this_block);
+    constexpr expr_t next_pin0          = signal(logic::in::input,        0x01, next_block);
+    constexpr expr_t next_pin1          = signal(logic::in::input,        0x02, next_block);
+    constexpr expr_t next_pin2          = signal(logic::in::input,        0x04, next_block);
+    constexpr expr_t next_pin0_pullup   = signal(logic::in::input_pullup, 0x01, next_block);
+    constexpr expr_t next_pin1_pullup   = signal(logic::in::input_pullup, 0x02, next_block);
+    constexpr expr_t next_pin2_pullup   = signal(logic::in::input_pullup, 0x04, next_block);
+    constexpr expr_t next_event_a       = signal(logic::in::event_a,      0x07, next_block);
+    constexpr expr_t next_event_b       = signal(logic::in::event_b,      0x07, next_block);
+    constexpr expr_t next_feedback      = signal(logic::in::feedback,     0x07, next_block);
+
+    // Peripherals - which instance you get depends on the input, so each can only go on one of them.
+    constexpr expr_t ac0                = signal(logic::in::ac,           0x01, any_block);
+    #if defined(AC1)
+      constexpr expr_t ac1              = signal(logic::in::ac,           0x02, any_block);
+    #endif
+    #if defined(AC2)
+      constexpr expr_t ac2              = signal(logic::in::ac,           0x04, any_block);
+    #endif
+    constexpr expr_t tcb0               = signal(logic::in::tcb,          0x01, any_block);
+    constexpr expr_t tcb1               = signal(logic::in::tcb,          0x02, any_block);
+    #if defined(TCB2)
+      constexpr expr_t tcb2             = signal(logic::in::tcb,          0x04, any_block);
+    #endif
+    constexpr expr_t usart0             = signal(logic::in::usart,        0x01, any_block);
+    constexpr expr_t usart1             = signal(logic::in::usart,        0x02, any_block);
+    #if defined(USART2)
+      constexpr expr_t usart2           = signal(logic::in::usart,        0x04, any_block);
+    #endif
+    constexpr expr_t spi_mosi           = signal(logic::in::spi,          0x03, any_block);
+    constexpr expr_t spi_sck            = signal(logic::in::spi,          0x04, any_block);
+    constexpr expr_t tca0_wo0           = signal(logic::in::tca0,         0x01, any_block);
+    constexpr expr_t tca0_wo1           = signal(logic::in::tca0,         0x02, any_block);
+    constexpr expr_t tca0_wo2           = signal(logic::in::tca0,         0x04, any_block);
+    #if defined(TCA1)
+      constexpr expr_t tca1_wo0         = signal(logic::in::tca1,         0x01, any_block);
+      constexpr expr_t tca1_wo1         = signal(logic::in::tca1,         0x02, any_block);
+      constexpr expr_t tca1_wo2         = signal(logic::in::tca1,         0x04, any_block);
+    #endif
+    #if defined(TCD0)
+      constexpr expr_t tcd0_woa         = signal(logic::in::tcd0,         0x01, any_block);
+      constexpr expr_t tcd0_wob         = signal(logic::in::tcd0,         0x02, any_block);
+      constexpr expr_t tcd0_woc         = signal(logic::in::tcd0,         0x04, any_block);
+    #endif
+
+    // Sequencer programs: the even block drives D, J or R, the odd block G, K or S - so for rs_latch() the even block
+    // gets the second argument.
+    constexpr seq_expr_t d_flip_flop(expr_t d, expr_t g)      {return {d, g, logic::sequencer::d_flip_flop};}
+    constexpr seq_expr_t jk_flip_flop(expr_t j, expr_t k)     {return {j, k, logic::sequencer::jk_flip_flop};}
+    constexpr seq_expr_t d_latch(expr_t d, expr_t g)          {return {d, g, logic::sequencer::d_latch};}
+    constexpr seq_expr_t rs_latch(expr_t set, expr_t reset)   {return {reset, set, logic::sequencer::rs_latch};}
+
+    // Which of the three inputs of each block have a pin, from the tables in the README.
+    constexpr uint8_t pin_inputs(uint8_t block) {
+      #if defined(__AVR_DD__) && _AVR_PINCOUNT == 14
+        constexpr uint8_t inputs[] = {0x03, 0x06, 0x00, 0x00};
+      #elif defined(__AVR_DD__) && _AVR_PINCOUNT == 20
+        constexpr uint8_t inputs[] = {0x07, 0x06, 0x00, 0x00};
+      #elif (defined(__AVR_DD__) || defined(__AVR_DB__)) && _AVR_PINCOUNT == 28
+        constexpr uint8_t inputs[] = {0x07, 0x07, 0x06, 0x03};
+      #elif (defined(__AVR_DD__) || defined(__AVR_DB__)) && _AVR_PINCOUNT == 32
+        constexpr uint8_t inputs[] = {0x07, 0x07, 0x06, 0x07};
+      #elif defined(_AVR_PINCOUNT) && _AVR_PINCOUNT == 28
+        constexpr uint8_t inputs[] = {0x07, 0x07, 0x07, 0x03};
+      #elif defined(_AVR_PINCOUNT) && _AVR_PINCOUNT == 48
+        constexpr uint8_t inputs[] = {0x07, 0x07, 0x07, 0x07, 0x07, 0x00};
+      #else
+        constexpr uint8_t inputs[] = {0x07, 0x07, 0x07, 0x07, 0x07, 0x07};
+      #endif
+      return block < sizeof(inputs) ? inputs[block] : 0;
+    }
+
+    constexpr bool same_signal(signal_t a, signal_t b) {
+      return a.insel == b.insel && a.inputs == b.inputs && a.owner == b.owner;
+    }
+
+    constexpr uint32_t table_mask(uint8_t count) {
+      return count >= 5 ? 0xFFFFFFFF : ((uint32_t) 1 << (1 << count)) - 1;
+    }
+
+    enum op_t : uint8_t {
+      op_and,
+      op_or,
+      op_xor,
+    };
+
+    constexpr expr_t combine(const expr_t &a, const expr_t &b, op_t op) {
+      expr_t r = a;
+      uint8_t where[5] {};
+      for (uint8_t j = 0; j < b.count; j++) {
+        uint8_t i = 0;
+        while (i < r.count && !same_signal(r.signals[i], b.signals[j])) {
+          i++;
+        }
+        if (i == r.count) {
+          if (r.count == 5) {
+            logic_expr_error_more_than_5_signals();
+            return r;
+          }
+          r.signals[r.count++] = b.signals[j];
+        }
+        where[j] = i;
+      }
+      r.table = 0;
+      for (uint8_t k = 0; k < (1 << r.count); k++) {
+        uint8_t kb = 0;
+        for (uint8_t j = 0; j < b.count; j++) {
+          kb |= ((k >> where[j]) & 1) << j;
+        }
+        uint8_t va = (a.table >> (k & ((1 << a.count) - 1))) & 1;
+        uint8_t vb = (b.table >> kb) & 1;
+        uint8_t v  = (op == op_and) ? (va & vb) : (op == op_or) ? (va | vb) : (va ^ vb);
+        r.table |= (uint32_t) v << k;
+      }
+      return r;
+    }
+
+    constexpr expr_t operator&(const expr_t &a, const expr_t &b) {return combine(a, b, op_and);}
+    constexpr expr_t operator|(const expr_t &a, const expr_t &b) {return combine(a, b, op_or);}
+    constexpr expr_t operator^(const expr_t &a, const expr_t &b) {return combine(a, b, op_xor);}
+    constexpr expr_t operator~(const expr_t &a) {
+      expr_t r = a;
+      r.table = ~a.table & table_mask(a.count);
+      return r;
+    }
+
+    // Drop the signals that the result doesn't actually depend on, like b in (a & b) | (a & ~b).
+    constexpr expr_t reduce(const expr_t &e) {
+      expr_t r = e;
+      uint8_t i = 0;
+      while (i < r.count) {
+        bool used = false;
+        for (uint8_t k = 0; k < (1 << r.count); k++) {
+          if (!(k & (1 << i)) && ((r.table >> k) & 1) != ((r.table >> (k | (1 << i))) & 1)) {
+            used = true;
+          }
+        }
+        if (used) {
+          i++;
+          continue;
+        }
+        uint32_t table = 0;
+        for (uint8_t k = 0; k < (1 << (r.count - 1)); k++) {
+          uint8_t below = k & ((1 << i) - 1);
+          uint8_t full  = below | ((k ^ below) << 1);
+          table |= ((r.table >> full) & 1) << k;
+        }
+        for (uint8_t j = i; j + 1 < r.count; j++) {
+          r.signals[j] = r.signals[j + 1];
+        }
+        r.count--;
+        r.table = table;
+      }
+      return r;
+    }
+
+    // The bits of k selected by mask, packed together.
+    constexpr uint8_t gather(uint8_t k, uint8_t mask) {
+      uint8_t r = 0, n = 0;
+      for (uint8_t i = 0; i < 5; i++) {
+        if (mask & (1 << i)) {
+          r |= ((k >> i) & 1) << n++;
+        }
+      }
+      return r;
+    }
+
+    constexpr uint8_t bit_count(uint8_t x) {
+      uint8_t n = 0;
+      while (x) {
+        n += x & 1;
+        x >>= 1;
+      }
+      return n;
+    }
+
+    struct placement_t {
+      int8_t  input[6];   // which input each signal went on; [5] is the link
+      uint8_t insel[3];
+      bool    ok;
+    };
+
+    // Put the signals in mask (and the link, if wanted) on the inputs of one block. The most constrained go first.
+    constexpr placement_t place(const expr_t &e, uint8_t mask, bool link) {
+      placement_t p {};
+      p.ok = true;
+      uint8_t used = 0;
+      for (uint8_t i = 0; i < 6; i++) {
+        p.input[i] = -1;
+      }
+      for (uint8_t choices = 1; choices <= 3; choices++) {
+        for (uint8_t i = 0; i < 6; i++) {
+          bool wanted = (i == 5) ? link : (mask & (1 << i));
+          uint8_t allowed = (i == 5) ? 0x07 : e.signals[i].inputs;
+          if (!wanted || bit_count(allowed) != choices) {
+            continue;
+          }
+          int8_t in = 0;
+          while (in < 3 && !((allowed & ~used) & (1 << in))) {
+            in++;
+          }
+          if (in == 3) {
+            p.ok = false;
+            continue;
+          }
+          used |= 1 << in;
+          p.input[i] = in;
+          p.insel[in] = (i == 5) ? (uint8_t) logic::in::link : e.signals[i].insel;
+        }
+      }
+      return p;
+    }
+
+    // Truth table for a block: the value for each input combination c is fn(k, link), where k is the expression
+    // signals' values. Inputs that aren't used read 0, and don't matter anyway.
+    template <typename Fn>
+    constexpr uint8_t truth_for(const placement_t &p, Fn fn) {
+      uint8_t truth = 0;
+      for (uint8_t c = 0; c < 8; c++) {
+        uint8_t k = 0;
+        for (uint8_t i = 0; i < 5; i++) {
+          if (p.input[i] >= 0) {
+            k |= ((c >> p.input[i]) & 1) << i;
+          }
+        }
+        uint8_t link = (p.input[5] >= 0) ? (c >> p.input[5]) & 1 : 0;
+        truth |= fn(k, link) << c;
+      }
+      return truth;
+    }
+
+    constexpr uint8_t next(uint8_t block) {
+      return (block + 1) % _LOGICEXPR_BLOCKS;
+    }
+
+    constexpr void check_pins(const expr_t &e, const placement_t &p, uint8_t block) {
+      for (uint8_t i = 0; i < e.count; i++) {
+        if (p.input[i] >= 0 && (e.signals[i].insel & 0x0F) == logic::in::pin && !(pin_inputs(block) & (1 << p.input[i]))) {
+          logic_expr_error_pin_not_available();
+        }
+      }
+    }
+
+    // Signals in mask that can't be used on the given block.
+    constexpr uint8_t misplaced(const expr_t &e, uint8_t mask, uint8_t owner) {
+      uint8_t r = 0;
+      for (uint8_t i = 0; i < e.count; i++) {
+        if ((mask & (1 << i)) && e.signals[i].owner != any_block && e.signals[i].owner != owner) {
+          r |= 1 << i;
+        }
+      }
+      return r;
+    }
+
+    constexpr lut_config_t single(const expr_t &e, uint8_t block, uint8_t owner) {
+      lut_config_t lut {};
+      uint8_t all = (1 << e.count) - 1;
+      placement_t p = place(e, all, false);
+      if (e.count > 3 || misplaced(e, all, owner)) {
+        logic_expr_error_cannot_split_over_two_blocks();
+      } else if (!p.ok) {
+        logic_expr_error_signals_need_the_same_input();
+      }
+      check_pins(e, p, block);
+      lut.truth = truth_for(p, [&e](uint8_t k, uint8_t) -> uint8_t {return (e.table >> k) & 1;});
+      for (uint8_t in = 0; in < 3; in++) {
+        lut.insel[in] = p.insel[in];
+      }
+      return lut;
+    }
+
+    // f(k) = h(g(signals in helper), signals not in it) works if, for every value of the rest, f as a function
+    // of the helper signals is 0, 1, g, or ~g for one and the same g. Found g goes in gcol, what h does with it
+    // for each value of the rest in hkind: 0, 1, 2 = g, 3 = ~g.
+    struct split_t {
+      uint8_t gcol;
+      uint8_t hkind[4];
+      bool    ok;
+    };
+
+    constexpr split_t try_split(const expr_t &e, uint8_t helper) {
+      split_t s {};
+      s.ok = true;
+      uint8_t all  = (1 << e.count) - 1;
+      uint8_t rest = all & ~helper;
+      uint8_t hn   = bit_count(helper);
+      uint8_t full = (1 << (1 << hn)) - 1;
+      bool have_g  = false;
+      for (uint8_t k = 0; k <= all; k++) {
+        if (k & helper) {
+          continue;
+        }
+        uint8_t col = 0;
+        for (uint8_t h = 0; h <= all; h++) {
+          if ((h & ~helper) == 0) {
+            col |= ((e.table >> (k | h)) & 1) << gather(h, helper);
+          }
+        }
+        uint8_t kind = 0;
+        if (col == 0) {
+          kind = 0;
+        } else if (col == full) {
+          kind = 1;
+        } else if (!have_g) {
+          have_g = true;
+          s.gcol = col;
+          kind = 2;
+        } else if (col == s.gcol) {
+          kind = 2;
+        } else if (col == (uint8_t)(~s.gcol & full)) {
+          kind = 3;
+        } else {
+          s.ok = false;
+        }
+        s.hkind[gather(k, rest)] = kind;
+      }
+      s.ok = s.ok && have_g;
+      return s;
+    }
+
+    constexpr program_t compile(uint8_t block, const expr_t &expression) {
+      program_t prog {};
+      prog.block = block;
+      prog.luts  = 1;
+      if (block >= _LOGICEXPR_BLOCKS) {
+        logic_expr_error_no_such_block();
+        return prog;
+      }
+      expr_t e = reduce(expression);
+      uint8_t all = (1 << e.count) - 1;
+      if (e.count <= 3 && !misplaced(e, all, this_block) && place(e, all, false).ok) {
+        prog.lut[0] = single(e, block, this_block);
+        return prog;
+      }
+      #if (defined(__AVR_DA__) || defined(__AVR_DB__)) && defined(_AVR_PINCOUNT) && _AVR_PINCOUNT <= 32
+        if (next(block) == 0) {
+          logic_expr_error_link_broken_on_this_part();  // see the errata warning in the README
+        }
+      #endif
+      for (uint8_t helper = 1; helper <= all; helper++) {
+        uint8_t rest = all & ~helper;
+        if (bit_count(helper) > 3 || bit_count(rest) > 2 || misplaced(e, helper, next_block) || misplaced(e, rest, this_block)) {
+          continue;
+        }
+        split_t s = try_split(e, helper);
+        placement_t ph = place(e, helper, false);
+        placement_t pm = place(e, rest, true);
+        if (!s.ok || !ph.ok || !pm.ok) {
+          continue;
+        }
+        check_pins(e, pm, block);
+        check_pins(e, ph, next(block));
+        prog.luts = 2;
+        prog.lut[1].truth = truth_for(ph, [&s, helper](uint8_t k, uint8_t) -> uint8_t {return (s.gcol >> gather(k, helper)) & 1;});
+        prog.lut[0].truth = truth_for(pm, [&s, rest](uint8_t k, uint8_t g) -> uint8_t {
+          uint8_t kind = s.hkind[gather(k, rest)];
+          return kind < 2 ? kind : (kind == 2 ? g : !g);
+        });
+        for (uint8_t in = 0; in < 3; in++) {
+          prog.lut[0].insel[in] = pm.insel[in];
+          prog.lut[1].insel[in] = ph.insel[in];
+        }
+        return prog;
+      }
+      if (e.count > 5) {
+        logic_expr_error_more_than_5_signals();
+      }
+      logic_expr_error_cannot_split_over_two_blocks();
+      return prog;
+    }
+
+    constexpr program_t compile(uint8_t block, const seq_expr_t &expression) {
+      program_t prog {};
+      prog.block     = block;
+      prog.luts      = 2;
+      prog.sequencer = expression.sequencer;
+      if (block >= _LOGICEXPR_BLOCKS) {
+        logic_expr_error_no_such_block();
+        return prog;
+      }
+      if (block & 1) {
+        logic_expr_error_sequencer_needs_even_block();
+      }
+      prog.lut[0] = single(reduce(expression.even), block, this_block);
+      prog.lut[1] = single(reduce(expression.odd), next(block), next_block);
+      return prog;
+    }
+
+    // Only the inputs, truth table and enable (and the sequencer, for sequencer programs) are set; output, filter,
+    // clock source and so on are left as the sketch set them before calling this.
+    inline void program_t::init() const {
+      for (uint8_t i = 0; i < luts; i++) {
+        Logic &lut_obj = Logic::forBlock((block + i) % _LOGICEXPR_BLOCKS);
+        lut_obj.input0 = (logic::in::input_t) lut[i].insel[0];
+        lut_obj.input1 = (logic::in::input_t) lut[i].insel[1];
+        lut_obj.input2 = (logic::in::input_t) lut[i].insel[2];
+        lut_obj.truth  = lut[i].truth;
+        lut_obj.enable = true;
+        if (i == 0 && sequencer) {
+          lut_obj.sequencer = (logic::sequencer::sequencer_t) sequencer;
+        }
+        lut_obj.init();
+      }
+    }
+  }
+}
+
+constexpr logic::expr::program_t Logic::compile(uint8_t block, const logic::expr::expr_t &expression) {
+  return logic::expr::compile(block, expression);
+}
+
+constexpr logic::expr::program_t Logic::compile(uint8_t block, const logic::expr::seq_expr_t &expression) {
+  return logic::expr::compile(block, expression);
+}
+
+#endif
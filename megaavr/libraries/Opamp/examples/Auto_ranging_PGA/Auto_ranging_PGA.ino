@@ -0,0 +1,52 @@
+/***********************************************************************|
+| AVR-DB Opamp library                                                  |
+|                                                                       |
+| Auto_ranging_PGA.ino                                                  |
+|                                                                       |
+| A library for interfacing with the built-in AVR-DB Opamps             |
+|                                                                       |
+| In this example we use opamp 0 as a programmable gain amplifier in    |
+| front of the ADC, which switches its gain between 1 and 16 by itself. |
+| The readings are scaled back to a gain of 1, so a signal on PD1 from  |
+| a few hundred microvolts to the full 1.024 V reference reads with 12  |
+| significant bits throughout.                                          |
+|                                                                       |
+|                 | Gain |    Opamp setting            |                  |
+|                 |------|-----------------------------|                  |
+|                 |  1   | voltage follower            |                  |
+|                 |  2   | wiper::wiper3, R1 = 32k     |                  |
+|                 |  4   | wiper::wiper5, R1 = 16k     |                  |
+|                 |  8   | wiper::wiper6, R1 = 8k      |                  |
+|                 |  16  | wiper::wiper7, R1 = 4k      |                  |
+|                                                                       |
+| The ADC reads the opamp output, PD2, so leave that pin unconnected.   |
+|                                                                       |
+| See Microchip's application note TB3286 for more information.         |
+|***********************************************************************/
+
+#include <OpampPGA.h>
+
+OpampPGA pga(Opamp0);
+
+void setup() {
+  Serial.begin(115200);
+  analogReference(INTERNAL1V024);
+  // Gain 1 to 16, and about 5000 readings per second
+  if (pga.begin(1, 16) != PGA_OK) {
+    Serial.println("PGA did not start");
+  }
+}
+
+void loop() {
+  static uint32_t lastPrint = 0;
+  if (pga.available() && millis() - lastPrint >= 250) {
+    lastPrint = millis();
+    uint16_t value = pga.read();              // 65520 = 1.024 V, at any gain
+    uint32_t microvolts = (uint32_t)value * 15625UL / 1000UL; // 1024000 uV / 65536 = 15.625 uV per count
+    Serial.print("Gain ");
+    Serial.print(pga.gain());
+    Serial.print(": ");
+    Serial.print(microvolts);
+    Serial.println(" uV");
+  }
+}
@@ -147,6 +147,7 @@ class Opamp {
     enable::enable_t enable        = enable::unconfigured; // set to disable to turn off this opamp (or have it run only when it's event input is on). unconfigured means neither set, nor has init been called.
 
   private:
+    friend class OpampPGA;          // switches the gain from the ADC interrupt
     const    uint8_t opamp_number;  // Holds the opamp number
     volatile uint8_t &opamp_ctrla;  // Reference to OPAMP_OPxCTRLA
     volatile uint8_t &opamp_status; // Reference to OPAMP_OPxSTATUS
@@ -0,0 +1,143 @@
+/* OpampPGA.cpp - an opamp as an auto-ranging programmable gain amplifier in front of the ADC.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ */
+#include "OpampPGA.h"
+
+#define PGA_RANGE_HIGH  0x0F00   // 15/16 of full scale or more: step the gain down
+#define PGA_RANGE_LOW   0x0700   // under 7/16: step it up, which leaves it under 14/16, clear of PGA_RANGE_HIGH
+
+OpampPGA *OpampPGA::_active = NULL;
+
+// The ladder settings for gains of 2, 4, 8 and 16 - with R1 (at the bottom) 32k, 16k, 8k and 4k, out of 64k.
+static const wiper::wiper_t pgaWiper[5] = {wiper::wiper0, wiper::wiper3, wiper::wiper5, wiper::wiper6, wiper::wiper7};
+
+static uint8_t pgaDone(analogRequest_t *req);
+
+static int8_t gainStep(uint8_t gain) {
+  for (uint8_t i = 0; i < 5; i++) {
+    if (gain == (1 << i)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+uint8_t OpampPGA::begin(uint8_t minGain, uint8_t maxGain, uint8_t sampleDuration) {
+  int8_t lo = gainStep(minGain);
+  int8_t hi = gainStep(maxGain);
+  if (lo < 0 || hi < lo) {
+    return PGA_BAD_ARGUMENT;
+  }
+  if (_active != NULL && _active != this) {
+    return PGA_BUSY;
+  }
+  end();
+  _min = lo;
+  _max = hi;
+  _opamp.output = out::enable;
+  _opamp.enable = enable::always_on;
+  _setStep(lo);
+  _discard = 0;
+  _new     = 0;
+  _opamp.init();
+  if (!(OPAMP.CTRLA & OPAMP_ENABLE_bm)) {
+    Opamp::start();
+  } else {
+    while (!_opamp.status());
+  }
+  _request.muxpos   = digitalPinToAnalogInput(_opamp.output_pin);
+  _request.muxneg   = 0x40;
+  _request.ctrla    = ADC_RESSEL_12BIT_gc;
+  _request.ctrlb    = 0;                   // no accumulation: one result per conversion
+  _request.sampctrl = sampleDuration;
+  _request.callback = pgaDone;
+  _active           = this;
+  analogQueue(&_request, false);
+  return PGA_OK;
+}
+
+void OpampPGA::end() {
+  if (_active != this) {
+    return;
+  }
+  analogDequeue(&_request);
+  _active = NULL;
+}
+
+void OpampPGA::_setStep(uint8_t step) {
+  // Gain 1 is a follower, with the ladder off; the others are non-inverting, the ladder from the output to ground.
+  _step = step;
+  if (step) {
+    _opamp.input_n       = in_n::wiper;
+    _opamp.ladder_top    = top::output;
+    _opamp.ladder_bottom = bottom::gnd;
+  } else {
+    _opamp.input_n       = in_n::output;
+    _opamp.ladder_top    = top::off;
+    _opamp.ladder_bottom = bottom::off;
+  }
+  _opamp.ladder_wiper  = pgaWiper[step];
+  _opamp.opamp_resmux  = _opamp.ladder_wiper | _opamp.ladder_top | _opamp.ladder_bottom;
+  _opamp.opamp_inmux   = _opamp.input_n | _opamp.input_p;
+  // The next conversion may start as soon as this interrupt returns, before the opamp has settled at the new gain.
+  _discard = 1;
+}
+
+bool OpampPGA::available() {
+  uint8_t oldSREG = SREG;
+  cli();
+  bool ret = _new;
+  _new = 0;
+  SREG = oldSREG;
+  return ret;
+}
+
+uint16_t OpampPGA::read() {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint16_t ret = _value;
+  SREG = oldSREG;
+  return ret;
+}
+
+uint8_t OpampPGA::gain() {
+  return 1 << _gain;
+}
+
+void OpampPGA::attachInterrupt(void (*handler)(uint16_t value, uint8_t gain)) {
+  _handler = handler;
+}
+
+void OpampPGA::detachInterrupt() {
+  _handler = NULL;
+}
+
+void OpampPGA::_service(uint16_t raw) {
+  if (_discard) {
+    _discard--;
+    return;
+  }
+  uint8_t step = _step;
+  // A clipped reading is only of any use at the lowest gain; otherwise it is dropped, and the gain stepped down.
+  if (raw < 0x0FFF || step == _min) {
+    uint16_t value = raw << (4 - step);
+    _value = value;
+    _gain  = step;
+    _new   = 1;
+    if (_handler != NULL) {
+      _handler(value, 1 << step);
+    }
+  }
+  if (raw >= PGA_RANGE_HIGH) {
+    if (step > _min) {
+      _setStep(step - 1);
+    }
+  } else if (raw < PGA_RANGE_LOW && step < _max) {
+    _setStep(step + 1);
+  }
+}
+
+static uint8_t pgaDone(analogRequest_t *req) {
+  OpampPGA::_active->_service(req->result);
+  return 1;                                // and again
+}
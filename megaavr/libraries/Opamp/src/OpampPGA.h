@@ -0,0 +1,61 @@
+/* OpampPGA.h - an opamp as an auto-ranging programmable gain amplifier in front of the ADC.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ *
+ * The ADC has no PGA on the Dx-series, so analogReadEnh() ignores its gain argument. The opamps can stand in for
+ * one: non-inverting, with the resistor ladder between the output and ground, the wiper positions that have 32k,
+ * 16k, 8k and 4k at the bottom give gains of 2, 4, 8 and 16 exactly (the gain depends only on the ratio of the
+ * on-chip resistors), and a voltage follower gives 1 - five binary steps, so rescaling a reading is a shift.
+ *
+ * The opamp output is converted over and over through the ADC queue (see analogQueue() in Ref_Analog.md), so
+ * analogRead() and other background users of the ADC can run alongside. Everything happens in the ADC result
+ * interrupt: each reading is scaled back to what it would have been at a gain of 1, with 4 more bits, and the gain
+ * for the next readings is chosen from it - down a step when the output is near the top of the range, up a step
+ * when it would still be there after doubling. The result straight after a gain change is dropped.
+ */
+#ifndef OPAMPPGA_H
+#define OPAMPPGA_H
+
+#include "Opamp.h"
+
+// begin() return values
+#define PGA_OK                      0
+#define PGA_BAD_ARGUMENT            1  // a gain that isn't 1, 2, 4, 8 or 16, or minGain > maxGain
+#define PGA_BUSY                    2  // another OpampPGA is running
+
+class OpampPGA {
+  public:
+    explicit OpampPGA(Opamp &opamp) : _opamp(opamp) {}
+    // Takes over the opamp, and queues conversions of its output over and over. The opamp's positive input stays
+    // whatever input_p is set to (its pin, by default); its negative input and ladder are taken over. The gain
+    // ranges between minGain and maxGain; make them equal for a fixed gain (1 is a plain voltage follower).
+    // sampleDuration is ADC0.SAMPCTRL for these conversions, which is what sets how often the input is read: at the
+    // default 255 and a 1.45 MHz ADC clock, up to about 5000 times a second, less when the ADC is shared.
+    uint8_t  begin(uint8_t minGain = 1, uint8_t maxGain = 16, uint8_t sampleDuration = 255);
+    // Stops queueing conversions. The opamp is left at the last gain.
+    void     end();
+    bool     available();   // true once after each new reading
+    // The latest reading, scaled to a gain of 1: the input as a fraction of the ADC reference, in 16 bits, so
+    // 65520 is full scale, and at a gain of 16 every count is significant.
+    uint16_t read();
+    uint8_t  gain();        // the gain that latest reading was taken at
+    // Called from the ADC interrupt with each new reading, scaled as read() returns it, and its gain.
+    void     attachInterrupt(void (*handler)(uint16_t value, uint8_t gain));
+    void     detachInterrupt();
+
+    void     _service(uint16_t raw);    // called by the ADC result interrupt
+    static OpampPGA *_active;
+  private:
+    void              _setStep(uint8_t step);
+    analogRequest_t   _request = {};
+    Opamp            &_opamp;
+    void            (*_handler)(uint16_t, uint8_t) = NULL;
+    volatile uint16_t _value   = 0;
+    volatile uint8_t  _gain    = 0;    // log2 of the gain _value was taken at
+    volatile uint8_t  _new     = 0;
+    uint8_t           _step    = 0;    // log2 of the gain now set
+    uint8_t           _min     = 0;
+    uint8_t           _max     = 0;
+    uint8_t           _discard = 0;    // readings still to drop after a gain change
+};
+
+#endif
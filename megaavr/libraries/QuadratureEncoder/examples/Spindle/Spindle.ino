@@ -0,0 +1,29 @@
+/* Spindle.ino - read a quadrature encoder entirely in hardware.
+ *
+ * Encoder A on PIN_PA0 and B on PIN_PA1 (any pins that can be event generators will do), counted X4 by TCA1 with
+ * the help of Logic0-2, and the speed measured with TCB1. Position and speed are printed 10 times a second; the
+ * CPU does nothing at all per edge.
+ *
+ * On parts without TCA1, use QuadEncoder0 - but then TCA0 must not be the millis timer (Tools -> millis()/micros()).
+ */
+#include <QuadratureEncoder.h>
+
+void setup() {
+  Serial.begin(115200);
+  pinMode(PIN_PA0, INPUT_PULLUP);  // most encoders are open collector
+  pinMode(PIN_PA1, INPUT_PULLUP);
+  uint8_t err = QuadEncoder1.begin(PIN_PA0, PIN_PA1, QUADRATURE_X4, 0);
+  if (err) {
+    Serial.print("begin() failed: ");
+    Serial.println(err);
+  }
+  QuadEncoder1.beginVelocity(TCB1);
+}
+
+void loop() {
+  Serial.print("Position: ");
+  Serial.print(QuadEncoder1.position());
+  Serial.print("  counts/s: ");
+  Serial.println(QuadEncoder1.velocity());
+  delay(100);
+}
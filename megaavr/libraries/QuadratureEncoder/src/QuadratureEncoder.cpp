@@ -0,0 +1,237 @@
+/* QuadratureEncoder.cpp - hardware quadrature decoding with CCL, EVSYS and a TCA.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ * QuadEncoder0 and QuadEncoder1 each sit in a file with their TCA's three vectors (QuadratureEncoder0.cpp and
+ * QuadratureEncoder1.cpp), so a sketch decoding on TCA1 can still have TCA0 interrupts of its own.
+ */
+#include "QuadratureEncoder.h"
+
+#if defined(CCL_TRUTH5)
+  #define _QUADENC_LOGIC_BLOCKS 6
+#else
+  #define _QUADENC_LOGIC_BLOCKS 4
+#endif
+
+// LUT n event input a or b
+static event::user::user_t lutUser(uint8_t n, uint8_t b) {
+  return Event::user_from_peripheral(CCL, n * 2 + b);
+}
+
+static void takeOverTCA(TCA_t &timer) {
+  #if defined(TCA1)
+    if (&timer == &TCA1) {
+      takeOverTCA1();
+      return;
+    }
+  #endif
+  (void) timer;
+  takeOverTCA0();
+}
+
+uint8_t QuadratureEncoder::begin(uint8_t pinA, uint8_t pinB, uint8_t resolution, uint8_t firstLogic) {
+  uint8_t luts = (resolution == QUADRATURE_X4) ? 3 : ((resolution == QUADRATURE_X2) ? 1 : 0);
+  if ((resolution != QUADRATURE_X1 && resolution != QUADRATURE_X2 && resolution != QUADRATURE_X4) || firstLogic + luts > _QUADENC_LOGIC_BLOCKS) {
+    return QUADRATURE_BAD_ARGUMENT;
+  }
+  end();
+  _resolution = resolution;
+  _firstLogic = firstLogic;
+  Event &chA = Event::assign_generator_pin(pinA);
+  _channel[_channels++] = chA.get_channel_number();
+  Event &chB = Event::assign_generator_pin(pinB);
+  _channel[_channels++] = chB.get_channel_number();
+  Event *count = &chA;
+  Event *dir   = &chB;
+  if (resolution != QUADRATURE_X1) {
+    // The direction LUT: A ^ B through the filter for X2, link ^ B for X4.
+    dir = &Event::assign_generator(Event::gen_from_peripheral(CCL, firstLogic));
+    _channel[_channels++] = dir->get_channel_number();
+  }
+  if (resolution == QUADRATURE_X4) {
+    count = &Event::assign_generator(Event::gen_from_peripheral(CCL, firstLogic + 2));
+    _channel[_channels++] = count->get_channel_number();
+  }
+  for (uint8_t i = 0; i < _channels; i++) {
+    if (_channel[i] == 255) {
+      _release();
+      return QUADRATURE_NO_CHANNEL;
+    }
+  }
+
+  takeOverTCA(_timer);
+  if (luts) {
+    Logic::stop();
+    Logic &d = Logic::forBlock(firstLogic);
+    d.enable = true;
+    d.clocksource = logic::clocksource::clk_per;
+    d.edgedetect  = logic::edgedetect::disable;
+    if (resolution == QUADRATURE_X2) {
+      chA.set_user(lutUser(firstLogic, 0));
+      chB.set_user(lutUser(firstLogic, 1));
+      d.input0 = logic::in::event_a;
+      d.input1 = logic::in::event_b;
+      d.input2 = logic::in::masked;
+      d.truth  = 0x66;                            // in0 ^ in1
+      d.filter = logic::filter::filter;           // holds the old value for the edge that's being counted
+    } else {
+      Logic &old = Logic::forBlock(firstLogic + 1);
+      Logic &cnt = Logic::forBlock(firstLogic + 2);
+      chA.set_user(lutUser(firstLogic + 1, 0));
+      chA.set_user(lutUser(firstLogic + 2, 0));
+      chB.set_user(lutUser(firstLogic, 1));
+      chB.set_user(lutUser(firstLogic + 2, 1));
+      d.input0 = logic::in::link;                 // the old A, from firstLogic + 1
+      d.input1 = logic::in::event_b;
+      d.input2 = logic::in::masked;
+      d.truth  = 0x66;
+      d.filter = logic::filter::disable;
+      old.enable = true;
+      old.input0 = logic::in::event_a;
+      old.input1 = logic::in::masked;
+      old.input2 = logic::in::masked;
+      old.truth  = 0xAA;                          // in0, 4 clocks late
+      old.filter = logic::filter::filter;
+      old.clocksource = logic::clocksource::clk_per;
+      old.init();
+      cnt.enable = true;
+      cnt.input0 = logic::in::event_a;
+      cnt.input1 = logic::in::event_b;
+      cnt.input2 = logic::in::masked;
+      cnt.truth  = 0x66;                          // A ^ B toggles on every edge
+      cnt.filter = logic::filter::synchronizer;   // 2 clocks late, so the direction is settled
+      cnt.clocksource = logic::clocksource::clk_per;
+      cnt.init();
+    }
+    d.init();
+    Logic::start();
+  }
+  count->set_user(Event::user_from_peripheral(_timer, 0));
+  dir->set_user(Event::user_from_peripheral(_timer, 1));
+
+  _timer.SINGLE.CTRLD   = 0;                      // not split mode
+  _timer.SINGLE.PER     = 0xFFFF;
+  _timer.SINGLE.CNT     = 0;
+  // Interrupts at 0, 1/3 and 2/3 of the way round, so that no more than 21846 counts pass between two of them,
+  // and the difference since the last one is never ambiguous, whichever way we're going.
+  _timer.SINGLE.CMP0    = 0x5555;
+  _timer.SINGLE.CMP1    = 0xAAAA;
+  _timer.SINGLE.EVCTRL  = TCA_SINGLE_CNTAEI_bm | TCA_SINGLE_CNTBEI_bm | TCA_SINGLE_EVACTB_UPDOWN_gc |
+                          (resolution == QUADRATURE_X1 ? TCA_SINGLE_EVACTA_CNT_POSEDGE_gc : TCA_SINGLE_EVACTA_CNT_ANYEDGE_gc);
+  _timer.SINGLE.INTFLAGS = TCA_SINGLE_OVF_bm | TCA_SINGLE_CMP0_bm | TCA_SINGLE_CMP1_bm;
+  _timer.SINGLE.INTCTRL = TCA_SINGLE_OVF_bm | TCA_SINGLE_CMP0_bm | TCA_SINGLE_CMP1_bm;
+  _base      = 0;
+  _lastCount = 0;
+  _lastPosition = 0;
+  for (uint8_t i = 0; i < _channels; i++) {
+    Event::get_channel(_channel[i]).start();
+  }
+  _timer.SINGLE.CTRLA   = TCA_SINGLE_ENABLE_bm;
+  return QUADRATURE_OK;
+}
+
+void QuadratureEncoder::end() {
+  if (!_resolution) {
+    return;
+  }
+  _timer.SINGLE.CTRLA   = 0;
+  _timer.SINGLE.INTCTRL = 0;
+  _timer.SINGLE.EVCTRL  = 0;
+  Event::clear_user(Event::user_from_peripheral(_timer, 0));
+  Event::clear_user(Event::user_from_peripheral(_timer, 1));
+  if (_tcb != NULL) {
+    _tcb->CTRLA  = 0;
+    _tcb->EVCTRL = 0;
+    Event::clear_user(Event::user_from_peripheral(*_tcb, 0));
+    _tcb = NULL;
+  }
+  if (_resolution != QUADRATURE_X1) {
+    uint8_t luts = (_resolution == QUADRATURE_X4) ? 3 : 1;
+    Logic::stop();
+    for (uint8_t i = 0; i < luts; i++) {
+      Event::clear_user(lutUser(_firstLogic + i, 0));
+      Event::clear_user(lutUser(_firstLogic + i, 1));
+      Logic::forBlock(_firstLogic + i).enable = false;
+      Logic::forBlock(_firstLogic + i).init();
+    }
+    Logic::start();
+  }
+  _release();
+}
+
+void QuadratureEncoder::_release() {
+  for (uint8_t i = 0; i < _channels; i++) {
+    if (_channel[i] != 255) {
+      Event &ch = Event::get_channel(_channel[i]);
+      ch.stop();
+      ch.set_generator(event::gen::disable);
+    }
+  }
+  _channels   = 0;
+  _resolution = 0;
+}
+
+int32_t QuadratureEncoder::position() {
+  uint8_t oldSREG = SREG;
+  cli();
+  int32_t pos = _base + (int16_t)(_timer.SINGLE.CNT - _lastCount);
+  SREG = oldSREG;
+  return pos;
+}
+
+void QuadratureEncoder::write(int32_t position) {
+  uint8_t oldSREG = SREG;
+  cli();
+  _lastCount = _timer.SINGLE.CNT;
+  _base = position;
+  SREG = oldSREG;
+}
+
+void QuadratureEncoder::_update() {
+  uint16_t count = _timer.SINGLE.CNT;
+  _timer.SINGLE.INTFLAGS = TCA_SINGLE_OVF_bm | TCA_SINGLE_CMP0_bm | TCA_SINGLE_CMP1_bm;
+  _base += (int16_t)(count - _lastCount);
+  _lastCount = count;
+}
+
+uint8_t QuadratureEncoder::beginVelocity(TCB_t &timer) {
+  if (_isMillisTCB(&timer)) {
+    return QUADRATURE_TIMER_IN_USE;
+  }
+  if (!_resolution) {
+    return QUADRATURE_BAD_ARGUMENT;
+  }
+  _tcb = &timer;
+  timer.CTRLA    = 0;
+  timer.CTRLB    = TCB_CNTMODE_FRQ_gc;            // capture the time since the last rising edge of A, and restart
+  timer.EVCTRL   = TCB_CAPTEI_bm;
+  timer.INTCTRL  = 0;
+  timer.CNT      = 0;
+  timer.INTFLAGS = TCB_CAPT_bm | TCB_OVF_bm;
+  Event::get_channel(_channel[0]).set_user(Event::user_from_peripheral(timer, 0));
+  timer.CTRLA    = TCB_CLKSEL_DIV2_gc | TCB_ENABLE_bm;
+  return QUADRATURE_OK;
+}
+
+int32_t QuadratureEncoder::velocity() {
+  if (_tcb == NULL) {
+    return 0;
+  }
+  int32_t pos = position();
+  if (pos != _lastPosition) {
+    _direction = (pos > _lastPosition) ? 1 : -1;
+    _lastPosition = pos;
+  }
+  uint8_t flags = _tcb->INTFLAGS;
+  // An overflow means that at least one cycle since we last looked was too long to measure (the counter wrapped
+  // before the capture), and we can't tell which, so call it stopped until the next clean capture.
+  if (flags & TCB_OVF_bm) {
+    _tcb->INTFLAGS = TCB_OVF_bm | TCB_CAPT_bm;
+    return 0;
+  }
+  uint16_t period = _tcb->CCMP;                  // also clears CAPT
+  if (period == 0) {
+    return 0;
+  }
+  // Each cycle of A is _resolution counts.
+  int32_t v = (uint32_t)(getCPUFrequency() / 2) * _resolution / period;
+  return _direction > 0 ? v : -v;
+}
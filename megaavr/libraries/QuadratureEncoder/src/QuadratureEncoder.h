@@ -0,0 +1,77 @@
+/* QuadratureEncoder.h - hardware quadrature decoding with CCL, EVSYS and a TCA.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ *
+ * The two encoder signals come in through the event system, the logic blocks turn them into a count pulse and a
+ * direction signal, and a TCA counts the pulses up or down (event A counts, event B sets the direction). Nothing
+ * runs in software per edge; the only interrupts are three per 65536 counts, to extend the count to 32 bits.
+ * Optionally, a TCB measures the time between edges of A for the velocity.
+ *
+ *  X1 - counts rising edges of A; direction is the level of B. No logic blocks, 2 event channels.
+ *  X2 - counts both edges of A; direction is A XOR B from just before the edge, delayed by a logic block's filter.
+ *       1 logic block, 3 event channels.
+ *  X4 - counts every edge of A or B. Direction is (A from just before the edge) XOR B, where the old A comes from
+ *       a second block's filter and reaches the first through the link input, and the count pulse (A XOR B) from a
+ *       third is delayed by its synchronizer so that it arrives after the direction has settled.
+ *       3 logic blocks (firstLogic, firstLogic + 1, firstLogic + 2), 4 event channels.
+ *
+ * The filter delays are a few system clocks, so edges must be at least ~4 system clocks apart - at 24 MHz, that's
+ * over 5 MHz. See the README for details.
+ */
+#ifndef QUADRATUREENCODER_H
+#define QUADRATUREENCODER_H
+
+#include <Arduino.h>
+#include <Event.h>
+#include <Logic.h>
+
+#if defined(TINY_0_OR_1_SERIES)
+  #error "QuadratureEncoder is not supported on tinyAVR 0/1-series parts"
+#endif
+
+#define QUADRATURE_X1               1
+#define QUADRATURE_X2               2
+#define QUADRATURE_X4               4
+
+// begin() and beginVelocity() return values
+#define QUADRATURE_OK               0
+#define QUADRATURE_BAD_ARGUMENT     1  // resolution is not 1, 2 or 4, or there aren't enough logic blocks from firstLogic on
+#define QUADRATURE_NO_CHANNEL       2  // out of event channels, or no free channel can take one of the pins
+#define QUADRATURE_TIMER_IN_USE     3  // that TCB is used for millis
+
+class QuadratureEncoder {
+  public:
+    explicit QuadratureEncoder(TCA_t &timer) : _timer(timer) {}
+    // Takes over the TCA and sets everything up, starting from position 0. Pins are left in whatever mode they are
+    // in; set INPUT_PULLUP first for open-collector encoders. The CCL is briefly stopped (see the Logic README).
+    uint8_t begin(uint8_t pinA, uint8_t pinB, uint8_t resolution = QUADRATURE_X4, uint8_t firstLogic = 0);
+    void    end();
+    int32_t position();
+    void    write(int32_t position);
+    // Measure the period of A with a TCB, for velocity(). Call after begin().
+    uint8_t beginVelocity(TCB_t &timer);
+    // Counts per second, signed. 0 if stopped, or slower than one A cycle per 65536 TCB clocks (CLK_PER/2).
+    int32_t velocity();
+
+    void    _update();    // called by the TCA interrupts
+  private:
+    void    _release();
+    TCA_t           &_timer;
+    TCB_t           *_tcb        = NULL;
+    volatile int32_t _base       = 0;    // position at _lastCount
+    volatile uint16_t _lastCount = 0;
+    int32_t          _lastPosition = 0;
+    int8_t           _direction  = 1;
+    uint8_t          _resolution = 0;    // 0 = not started
+    uint8_t          _firstLogic = 0;
+    uint8_t          _channels   = 0;    // how many of _channel[] are in use
+    uint8_t          _channel[4];
+};
+
+#if defined(TCA0) && !defined(MILLIS_USE_TIMERA0)
+  extern QuadratureEncoder QuadEncoder0;
+#endif
+#if defined(TCA1) && !defined(MILLIS_USE_TIMERA1)
+  extern QuadratureEncoder QuadEncoder1;
+#endif
+
+#endif
@@ -0,0 +1,16 @@
+/* QuadratureEncoder0.cpp - QuadEncoder0, on TCA0, and TCA0's overflow and compare interrupts. */
+#include "QuadratureEncoder.h"
+
+#if defined(TCA0) && !defined(MILLIS_USE_TIMERA0)
+  QuadratureEncoder QuadEncoder0(TCA0);
+
+  ISR(TCA0_OVF_vect) {
+    QuadEncoder0._update();
+  }
+  ISR(TCA0_CMP0_vect) {
+    QuadEncoder0._update();
+  }
+  ISR(TCA0_CMP1_vect) {
+    QuadEncoder0._update();
+  }
+#endif
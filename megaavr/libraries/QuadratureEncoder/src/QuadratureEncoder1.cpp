@@ -0,0 +1,16 @@
+/* QuadratureEncoder1.cpp - QuadEncoder1, on TCA1, and TCA1's overflow and compare interrupts. */
+#include "QuadratureEncoder.h"
+
+#if defined(TCA1) && !defined(MILLIS_USE_TIMERA1)
+  QuadratureEncoder QuadEncoder1(TCA1);
+
+  ISR(TCA1_OVF_vect) {
+    QuadEncoder1._update();
+  }
+  ISR(TCA1_CMP0_vect) {
+    QuadEncoder1._update();
+  }
+  ISR(TCA1_CMP1_vect) {
+    QuadEncoder1._update();
+  }
+#endif
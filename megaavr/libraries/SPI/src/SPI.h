@@ -271,6 +271,7 @@ class SPISettings {
     uint8_t ctrla;
     uint8_t ctrlb;
     friend class SPIClass;
+    friend class USARTSPI;
 };
 
 class SPIClass {
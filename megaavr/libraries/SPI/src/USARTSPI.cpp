@@ -0,0 +1,214 @@
+/*
+ * USARTSPI - the SPI library API on a USART in Master SPI (MSPI) mode.
+ * Copyright (c) 2022 Spence Konde
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "USARTSPI.h"
+
+/* In MSPI mode, f_SCK = f_CLK_PER / (2 * BAUD[15:6]); the fractional part of BAUD is not used. */
+static uint16_t _mspiBaud(uint32_t clock) {
+  uint32_t fcpu = getCPUFrequency();
+  uint16_t div = 1;
+  if (clock && clock < (fcpu >> 1)) {
+    uint32_t d = (fcpu + (2 * clock) - 1) / (2 * clock); // round up so we never exceed the requested clock.
+    div = (d > 1023) ? 1023 : d;
+  }
+  return div << 6;
+}
+
+/* Turn the SPI peripheral prescaler bits that SPISettings and the SPI_CLOCK_DIVn constants use into the number of
+ * system clocks per SCK, and from that the MSPI BAUD setting that gives the same clock. */
+static uint16_t _mspiBaudFromCtrla(uint8_t ctrla) {
+  uint8_t presc = ctrla & SPI_PRESC_gm;
+  uint8_t div = (presc == SPI_PRESC_DIV128_gc) ? 128 : (4 << presc);
+  if (ctrla & SPI_CLK2X_bm) {
+    div >>= 1;
+  }
+  return ((uint16_t)(div >> 1)) << 6;
+}
+
+static uint8_t _mspiCtrlc(uint8_t bitOrder, uint8_t dataMode) {
+  return USART_CMODE_MSPI_gc | (bitOrder == LSBFIRST ? USART_UDORD_bm : 0) | ((dataMode & 0x01) ? USART_UCPHA_bm : 0);
+}
+
+void USARTSPI::begin() {
+  _port.end();
+  volatile USART_t *usart = _port._hwserial_module;
+  uint8_t oldSREG = SREG;
+  cli();
+  usart->CTRLB = 0;
+  usart->CTRLA = 0;  // no interrupts - HardwareSerial's RXC ISR would eat the data.
+  HardwareSerial::_set_pins(_port._usart_pins, _port._mux_count, _port._pin_set, 0); // enmask of 0: only sets PORTMUX.
+  SREG = oldSREG;
+  _pinSCK = _port.getPin(2);
+  pinMode(_port.getPin(0), OUTPUT); // MOSI
+  pinMode(_port.getPin(1), INPUT);  // MISO
+  pinMode(_pinSCK, OUTPUT);
+  config(_mspiBaud(4000000), _mspiCtrlc(MSBFIRST, SPI_MODE0), false);
+  _interruptMode = 0;
+  _in_transaction = 0;
+  _old_sreg = 0x80;
+}
+
+void USARTSPI::end() {
+  volatile USART_t *usart = _port._hwserial_module;
+  usart->CTRLB = 0;
+  usart->CTRLC = USART_CMODE_ASYNCHRONOUS_gc | USART_CHSIZE_8BIT_gc; // back to async so a later Serialn.begin() doesn't have to know we were here.
+  if (_pinSCK != NOT_A_PIN) {
+    volatile uint8_t *pinctrl = getPINnCTRLregister(digitalPinToPortStruct(_pinSCK), digitalPinToBitPosition(_pinSCK));
+    *pinctrl &= ~PORT_INVEN_bm;
+  }
+  pinMode(_pinSCK, INPUT);
+  pinMode(_port.getPin(0), INPUT);
+}
+
+void USARTSPI::config(uint16_t baud, uint8_t ctrlc, bool invert) {
+  volatile USART_t *usart = _port._hwserial_module;
+  _invert = invert;
+  usart->BAUD = baud;
+  if (usart->CTRLC != ctrlc) {
+    usart->CTRLB = 0;          // Data order and phase are only changed with the USART disabled.
+    usart->CTRLC = ctrlc;
+  }
+  if (_pinSCK != NOT_A_PIN) {
+    // Modes 2 and 3 idle HIGH, which MSPI gets by inverting XCK.
+    volatile uint8_t *pinctrl = getPINnCTRLregister(digitalPinToPortStruct(_pinSCK), digitalPinToBitPosition(_pinSCK));
+    if (invert) {
+      *pinctrl |= PORT_INVEN_bm;
+    } else {
+      *pinctrl &= ~PORT_INVEN_bm;
+    }
+  }
+  usart->CTRLB = USART_RXEN_bm | USART_TXEN_bm;
+}
+
+byte USARTSPI::transfer(uint8_t data) {
+  volatile USART_t *usart = _port._hwserial_module;
+  usart->TXDATAL = data;
+  while (!(usart->STATUS & USART_RXCIF_bm));
+  return usart->RXDATAL;
+}
+
+uint16_t USARTSPI::transfer16(uint16_t data) {
+  union {
+    uint16_t val;
+    struct {
+      uint8_t lsb;
+      uint8_t msb;
+    };
+  } t;
+
+  t.val = data;
+
+  if ((_port._hwserial_module->CTRLC & USART_UDORD_bm) == 0) {
+    t.msb = transfer(t.msb);
+    t.lsb = transfer(t.lsb);
+  } else {
+    t.lsb = transfer(t.lsb);
+    t.msb = transfer(t.msb);
+  }
+
+  return t.val;
+}
+
+void USARTSPI::transfer(void *buf, size_t count) {
+  transfer(buf, buf, count);
+}
+
+void USARTSPI::transfer(const void *txbuf, void *rxbuf, size_t count) {
+  if (!count) {
+    return;
+  }
+  volatile USART_t *usart = _port._hwserial_module;
+  const uint8_t *tx = reinterpret_cast<const uint8_t *>(txbuf);
+  uint8_t *rx = reinterpret_cast<uint8_t *>(rxbuf);
+  while (usart->STATUS & USART_RXCIF_bm) {
+    (void) usart->RXDATAL;   // throw away anything stale.
+  }
+  usart->TXDATAL = tx ? *tx++ : 0xFF;
+  // One byte is always in flight ahead of the one we're reading back, so the shifter never waits for us.
+  // The RX side is double buffered too, so we can't overrun it. rx trails tx by one byte, so in-place is fine.
+  while (--count) {
+    uint8_t out = tx ? *tx++ : 0xFF;
+    while (!(usart->STATUS & USART_DREIF_bm));
+    usart->TXDATAL = out;
+    while (!(usart->STATUS & USART_RXCIF_bm));
+    uint8_t in = usart->RXDATAL;
+    if (rx) {
+      *rx++ = in;
+    }
+  }
+  while (!(usart->STATUS & USART_RXCIF_bm));
+  uint8_t in = usart->RXDATAL;
+  if (rx) {
+    *rx = in;
+  }
+}
+
+void USARTSPI::usingInterrupt(__attribute__((unused)) uint8_t interruptNumber) {
+  _interruptMode = 1;
+}
+
+void USARTSPI::notUsingInterrupt(__attribute__((unused)) uint8_t interruptNumber) {
+  _interruptMode = 0;
+}
+
+void USARTSPI::beginTransaction(SPISettings settings) {
+  if (_interruptMode) {
+    _old_sreg = SREG;
+    cli();
+  }
+  _in_transaction = 1;
+  config(_mspiBaudFromCtrla(settings.ctrla), _mspiCtrlc((settings.ctrla & SPI_DORD_bm) ? LSBFIRST : MSBFIRST, settings.ctrlb), settings.ctrlb & 0x02);
+}
+
+void USARTSPI::beginTransaction(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) {
+  if (_interruptMode) {
+    _old_sreg = SREG;
+    cli();
+  }
+  _in_transaction = 1;
+  config(_mspiBaud(clock), _mspiCtrlc(bitOrder, dataMode), dataMode & 0x02);
+}
+
+void USARTSPI::endTransaction(void) {
+  if (_in_transaction) {
+    _in_transaction = 0;
+    if (_interruptMode) {
+      SREG = _old_sreg;
+    }
+  }
+}
+
+void USARTSPI::setBitOrder(uint8_t order) {
+  volatile USART_t *usart = _port._hwserial_module;
+  uint8_t ctrlc = usart->CTRLC;
+  config(usart->BAUD, (order == LSBFIRST) ? (ctrlc | USART_UDORD_bm) : (ctrlc & ~USART_UDORD_bm), _invert);
+}
+
+void USARTSPI::setDataMode(uint8_t mode) {
+  volatile USART_t *usart = _port._hwserial_module;
+  config(usart->BAUD, _mspiCtrlc((usart->CTRLC & USART_UDORD_bm) ? LSBFIRST : MSBFIRST, mode), mode & 0x02);
+}
+
+void USARTSPI::setClockDivider(uint8_t div) {
+  _port._hwserial_module->BAUD = _mspiBaudFromCtrla(div);
+}
+
+void USARTSPI::setClock(uint32_t clock) {
+  _port._hwserial_module->BAUD = _mspiBaud(clock);
+}
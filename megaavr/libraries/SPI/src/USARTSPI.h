@@ -0,0 +1,69 @@
+/*
+ * USARTSPI - the SPI library API on a USART in Master SPI (MSPI) mode.
+ * Copyright (c) 2022 Spence Konde
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _USARTSPI_H_INCLUDED
+#define _USARTSPI_H_INCLUDED
+
+#include <Arduino.h>
+#include "SPI.h"
+
+/* Pin mapping comes from the HardwareSerial object: TX is MOSI, RX is MISO and XCK is SCK, using whatever
+ * pinset was selected with Serialn.swap() or Serialn.pins(). Only master mode exists. The serial port
+ * can't be used as a serial port while USARTSPI has it, obviously - call end() to give it back.
+ * This is not an SPIClass (nor derived from one): it has the same methods, but a device driver that takes an
+ * SPIClass & can't be handed a USARTSPI.
+ */
+class USARTSPI {
+  public:
+    USARTSPI(HardwareSerial &port) : _port(port) {}
+
+    void begin();
+    void end();
+
+    byte transfer(uint8_t data);
+    uint16_t transfer16(uint16_t data);
+    void transfer(void *buf, size_t count);
+    // Send count bytes from txbuf while storing what comes back in rxbuf (if rxbuf is NULL, it's discarded).
+    // Keeps both levels of the USART TX buffer full, so there's no gap between bytes.
+    void transfer(const void *txbuf, void *rxbuf, size_t count);
+
+    // Transaction Functions
+    void usingInterrupt(uint8_t interruptNumber);
+    void notUsingInterrupt(uint8_t interruptNumber);
+    void beginTransaction(SPISettings settings);
+    // The USART baud generator isn't limited to powers of two, so this form gets you the fastest clock <= clock.
+    void beginTransaction(uint32_t clock, uint8_t bitOrder, uint8_t dataMode);
+    void endTransaction(void);
+
+    void setBitOrder(uint8_t order);
+    void setDataMode(uint8_t mode);
+    void setClockDivider(uint8_t div);
+    void setClock(uint32_t clock);
+
+  private:
+    void config(uint16_t baud, uint8_t ctrlc, bool invert);
+    HardwareSerial &_port;
+    uint8_t _pinSCK = NOT_A_PIN;
+    bool _invert = false;
+    uint8_t _interruptMode = 0;
+    uint8_t _old_sreg = 0x80;
+    uint8_t _in_transaction = 0;
+};
+
+#endif
@@ -48,9 +48,14 @@
 // Static methods
 //
 SoftwareSerial *SoftwareSerial::active_object = 0;
+#if defined(SOFTSERIAL_TIMER_RX)
+SoftwareSerial * volatile SoftwareSerial::_timed[_SS_MAX_TIMED];
+volatile uint16_t SoftwareSerial::_timer_base = 0;
+#else
 uint8_t SoftwareSerial::_receive_buffer[_SS_MAX_RX_BUFF];
 volatile uint8_t SoftwareSerial::_receive_buffer_tail = 0;
 volatile uint8_t SoftwareSerial::_receive_buffer_head = 0;
+#endif
 
 //
 // Debugging
@@ -80,6 +85,55 @@ inline void SoftwareSerial::tunedDelay(uint16_t delay) {
   _delay_loop_2(delay);
 }
 
+#if defined(SOFTSERIAL_TIMER_RX)
+// With timer-sampled receive, any number of instances up to _SS_MAX_TIMED can listen at once.
+// Returns true if this one wasn't listening already and now is.
+bool SoftwareSerial::listen() {
+  if (!_rx_bit_ticks || isListening()) {
+    return false;
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  for (uint8_t i = 0; i < _SS_MAX_TIMED; i++) {
+    if (!_timed[i]) {
+      _buffer_overflow = false;
+      _receive_buffer_head = _receive_buffer_tail = 0;
+      _rx_state = 0;
+      _timed[i] = this;
+      setRxIntMsk(true);
+      SREG = oldSREG;
+      return true;
+    }
+  }
+  SREG = oldSREG;
+  return false;
+}
+
+bool SoftwareSerial::isListening() {
+  for (uint8_t i = 0; i < _SS_MAX_TIMED; i++) {
+    if (_timed[i] == this) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SoftwareSerial::stopListening() {
+  uint8_t oldSREG = SREG;
+  cli();
+  for (uint8_t i = 0; i < _SS_MAX_TIMED; i++) {
+    if (_timed[i] == this) {
+      setRxIntMsk(false);
+      _rx_state = 0;  // the timer ISR stops itself once nobody is receiving
+      _timed[i] = NULL;
+      SREG = oldSREG;
+      return true;
+    }
+  }
+  SREG = oldSREG;
+  return false;
+}
+#else
 // This function sets the current object as the "listening"
 // one and returns true if it replaces another
 bool SoftwareSerial::listen() {
@@ -112,7 +166,111 @@ bool SoftwareSerial::stopListening() {
   }
   return false;
 }
+#endif
+
+#if defined(SOFTSERIAL_TIMER_RX)
+//
+// The receive routine called by the pin interrupt handler: if this is a start bit, stop
+// listening for edges, and schedule the first sample 1.5 bits from now.
+//
+void SoftwareSerial::recv() {
+  if (_rx_state || (_inverse_logic ? !rx_pin_read() : rx_pin_read())) {
+    return; // Already receiving, or the line is idle so the interrupt was for another pin.
+  }
+  setRxIntMsk(false);
+  _rx_state = 1;
+  _rx_byte = 0;
+  uint16_t delay = _rx_bit_ticks + (_rx_bit_ticks >> 1) - (_SS_RX_LATENCY / 2);
+  if (!(_SS_TCB.CTRLA & TCB_ENABLE_bm)) {
+    // Nobody else is receiving; start the timer with this start bit as time 0.
+    _timer_base = 0;
+    _rx_due = delay;
+    _SS_TCB.CTRLB = TCB_CNTMODE_INT_gc;
+    _SS_TCB.CNT = 0;
+    _SS_TCB.CCMP = delay - 1;
+    _SS_TCB.INTFLAGS = TCB_CAPT_bm;
+    _SS_TCB.INTCTRL = TCB_CAPT_bm;
+    _SS_TCB.CTRLA = TCB_CLKSEL_DIV2_gc | TCB_ENABLE_bm;
+  } else if (_SS_TCB.INTFLAGS & TCB_CAPT_bm) {
+    // A compare match is pending, so the counter has already wrapped. The timer ISR will run as soon
+    // as we return and will schedule us along with everyone else.
+    _rx_due = _timer_base + _SS_TCB.CCMP + 1 + _SS_TCB.CNT + delay;
+  } else {
+    uint16_t now = _SS_TCB.CNT;
+    _rx_due = _timer_base + now + delay;
+    if (now + delay < _SS_TCB.CCMP) {
+      _SS_TCB.CCMP = now + delay - 1; // we need to sample before whatever was next.
+    }
+  }
+}
+
+// Called from the timer ISR when a sample is due.
+void SoftwareSerial::sampleBit() {
+  uint8_t state = _rx_state;
+  if (state <= 8) {
+    uint8_t d = _rx_byte >> 1;
+    if (rx_pin_read()) {
+      d |= 0x80;
+    }
+    _rx_byte = d;
+    _rx_due += _rx_bit_ticks;
+    _rx_state = state + 1;
+  } else {
+    // Middle of the stop bit: store the byte and start looking for the next start bit.
+    uint8_t d = _rx_byte;
+    if (_inverse_logic) {
+      d = ~d;
+    }
+    uint8_t next = (_receive_buffer_tail + 1) % _SS_MAX_RX_BUFF;
+    if (next != _receive_buffer_head) {
+      _receive_buffer[_receive_buffer_tail] = d;
+      _receive_buffer_tail = next;
+    } else {
+      _buffer_overflow = true;
+    }
+    _rx_state = 0;
+    setRxIntMsk(true);
+  }
+}
+
+/* static */
+inline void SoftwareSerial::handle_timer() {
+  uint16_t now = _timer_base + _SS_TCB.CCMP + 1;
+  _timer_base = now;
+  uint16_t next = 0xFFFF;
+  for (uint8_t i = 0; i < _SS_MAX_TIMED; i++) {
+    SoftwareSerial *p = _timed[i];
+    if (p && p->_rx_state) {
+      // Anything due within 16 ticks is close enough; sampling it now saves a trip through the ISR.
+      if ((int16_t)(p->_rx_due - now) <= 16) {
+        p->sampleBit();
+      }
+      if (p->_rx_state) {
+        uint16_t wait = p->_rx_due - now;
+        if (wait < next) {
+          next = wait;
+        }
+      }
+    }
+  }
+  if (next == 0xFFFF) {
+    _SS_TCB.CTRLA = 0;    // nobody is receiving - stop until the next start bit.
+    _SS_TCB.INTCTRL = 0;
+    return;
+  }
+  // Make sure the compare value is still ahead of the counter, or we'd wait for it to wrap.
+  uint16_t cnt = _SS_TCB.CNT + 8;
+  if (next < cnt) {
+    next = cnt;
+  }
+  _SS_TCB.CCMP = next - 1;
+}
 
+ISR(_SS_TCB_vect) {
+  _SS_TCB.INTFLAGS = TCB_CAPT_bm;
+  SoftwareSerial::handle_timer();
+}
+#else
 //
 // The receive routine called by the interrupt handler
 //
@@ -197,6 +355,7 @@ void SoftwareSerial::recv() {
     ::);
   #endif
 }
+#endif
 
 uint8_t SoftwareSerial::rx_pin_read() {
   return *_receivePortRegister & _receiveBitMask;
@@ -208,9 +367,19 @@ uint8_t SoftwareSerial::rx_pin_read() {
 
 /* static */
 inline void SoftwareSerial::handle_interrupt() {
+  #if defined(SOFTSERIAL_TIMER_RX)
+  // attachInterrupt can't tell us which pin it was, so give everyone who's listening a look.
+  for (uint8_t i = 0; i < _SS_MAX_TIMED; i++) {
+    SoftwareSerial *p = _timed[i];
+    if (p) {
+      p->recv();
+    }
+  }
+  #else
   if (active_object) {
     active_object->recv();
   }
+  #endif
 }
 
 //
@@ -222,7 +391,14 @@ SoftwareSerial::SoftwareSerial(uint8_t receivePin, uint8_t transmitPin, bool inv
   _rx_delay_stopbit(0),
   _tx_delay(0),
   _buffer_overflow(false),
-  _inverse_logic(inverse_logic) {
+  _inverse_logic(inverse_logic)
+  #if defined(SOFTSERIAL_TIMER_RX)
+  , _receive_buffer_tail(0),
+  _receive_buffer_head(0),
+  _rx_bit_ticks(0),
+  _rx_state(0)
+  #endif
+  {
   setTX(transmitPin);
   setRX(receivePin);
 }
@@ -255,6 +431,14 @@ void SoftwareSerial::setRX(uint8_t rx) {
   _receiveBitMask = digitalPinToBitMask(rx);
   uint8_t port = digitalPinToPort(rx);
   _receivePortRegister = portInputRegister(port);
+  // Enabling and disabling the pin interrupt is done through the ISC bits of PINnCTRL; the
+  // value is what attachInterrupt() puts there for the mode we attach with in begin().
+  _pcint_maskreg = getPINnCTRLregister(portToPortStruct(port), digitalPinToBitPosition(rx));
+  #if defined(SOFTSERIAL_TIMER_RX)
+  _pcint_maskvalue = _inverse_logic ? PORT_ISC_RISING_gc : PORT_ISC_FALLING_gc;
+  #else
+  _pcint_maskvalue = PORT_ISC_BOTHEDGES_gc;
+  #endif
 }
 
 uint16_t SoftwareSerial::subtract_cap(uint16_t num, uint16_t sub) {
@@ -272,8 +456,9 @@ uint16_t SoftwareSerial::subtract_cap(uint16_t num, uint16_t sub) {
 void SoftwareSerial::begin(long speed) {
   _rx_delay_centering = _rx_delay_intrabit = _rx_delay_stopbit = _tx_delay = 0;
 
-  // Precalculate the various delays, in number of 4-cycle delays
-  uint16_t bit_delay = (F_CPU / speed) / 4;
+  // Precalculate the various delays, in number of 4-cycle delays, at the clock we're running at now
+  uint32_t fcpu = getCPUFrequency();           // F_CPU unless setCPUFrequency() has been used.
+  uint16_t bit_delay = (fcpu / speed) / 4;
 
   // 12 (gcc 4.8.2) or 13 (gcc 4.3.2) cycles from start bit to first bit,
   // 15 (gcc 4.8.2) or 16 (gcc 4.3.2) cycles between bits,
@@ -282,6 +467,18 @@ void SoftwareSerial::begin(long speed) {
   // timings are the most critical (deviations stack 8 times)
   _tx_delay = subtract_cap(bit_delay, 15 / 4);
 
+  #if defined(SOFTSERIAL_TIMER_RX)
+  _rx_bit_ticks = 0;
+  uint32_t ticks = ((fcpu / 2) + (speed / 2)) / speed;
+  // The first sample is 1.5 bits after the edge and must fit in the 16-bit timer, and there must be time to get into the
+  // pin interrupt and back out of the timer one within a bit.
+  if (ticks * 3 / 2 < 0xFF00 && ticks > (_SS_RX_LATENCY / 2) + 16) {
+    _rx_bit_ticks = ticks;
+    attachInterrupt(_receivePin, SoftwareSerial::handle_interrupt, _inverse_logic ? RISING : FALLING);
+    setRxIntMsk(false); // listen() turns it on.
+    tunedDelay(_tx_delay);
+  }
+  #else
   // Only setup rx when we have a valid PCINT for this pin
   if (1) {
     #if GCC_VERSION > 40800
@@ -325,6 +522,7 @@ void SoftwareSerial::begin(long speed) {
 
     tunedDelay(_tx_delay); // if we were low this establishes the end
   }
+  #endif
 
   #if _DEBUG
   pinMode(_DEBUG_PIN1, OUTPUT);
@@ -335,11 +533,16 @@ void SoftwareSerial::begin(long speed) {
 }
 
 void SoftwareSerial::setRxIntMsk(bool enable) {
+  uint8_t oldSREG = SREG;
+  cli();
   if (enable) {
-    *_pcint_maskreg |= _pcint_maskvalue;
+    // clear any flag left over from edges while it was off, then turn it back on.
+    *(_receivePortRegister + 1) = _receiveBitMask; // PORTx.INTFLAGS is right after PORTx.IN
+    *_pcint_maskreg = (*_pcint_maskreg & ~PORT_ISC_gm) | _pcint_maskvalue;
   } else {
-    *_pcint_maskreg &= ~_pcint_maskvalue;
+    *_pcint_maskreg &= ~PORT_ISC_gm;
   }
+  SREG = oldSREG;
 }
 
 void SoftwareSerial::end() {
@@ -47,6 +47,73 @@
   #define GCC_VERSION (__GNUC__ * 10000 + __GNUC_MINOR__ * 100 + __GNUC_PATCHLEVEL__)
 #endif
 
+/* Timer-sampled receive: if SOFTSERIAL_TIMER_RX or SOFTSERIAL_USE_TIMERBn is defined, the start bit edge only arms
+ * a TCB, and each bit is sampled from a short TCB interrupt, instead of the pin interrupt busy-waiting through the whole
+ * character. Every instance that is listening can receive at the same time, each with it's own buffer.
+ * SOFTSERIAL_USE_TIMERBn picks the timer; otherwise we take the highest numbered TCB not used for millis, avoiding TCB0
+ * and TCB1 (used by tone and Servo) when possible. */
+#if defined(SOFTSERIAL_USE_TIMERB0) || defined(SOFTSERIAL_USE_TIMERB1) || defined(SOFTSERIAL_USE_TIMERB2) || defined(SOFTSERIAL_USE_TIMERB3) || defined(SOFTSERIAL_USE_TIMERB4)
+  #define SOFTSERIAL_TIMER_RX
+#elif defined(SOFTSERIAL_TIMER_RX)
+  #if defined(TCB2) && !defined(MILLIS_USE_TIMERB2)
+    #define SOFTSERIAL_USE_TIMERB2
+  #elif defined(TCB3) && !defined(MILLIS_USE_TIMERB3)
+    #define SOFTSERIAL_USE_TIMERB3
+  #elif defined(TCB4) && !defined(MILLIS_USE_TIMERB4)
+    #define SOFTSERIAL_USE_TIMERB4
+  #elif !defined(MILLIS_USE_TIMERB1)
+    #define SOFTSERIAL_USE_TIMERB1
+  #else
+    #define SOFTSERIAL_USE_TIMERB0
+  #endif
+#endif
+
+#if defined(SOFTSERIAL_TIMER_RX)
+  #if defined(SOFTSERIAL_USE_TIMERB0)
+    #if defined(MILLIS_USE_TIMERB0)
+      #error "SOFTSERIAL_USE_TIMERB0 is defined, but so is MILLIS_USE_TIMERB0 - TCB0 can only be used for one of these."
+    #endif
+    #define _SS_TCB       TCB0
+    #define _SS_TCB_vect  TCB0_INT_vect
+  #elif defined(SOFTSERIAL_USE_TIMERB1)
+    #if defined(MILLIS_USE_TIMERB1)
+      #error "SOFTSERIAL_USE_TIMERB1 is defined, but so is MILLIS_USE_TIMERB1 - TCB1 can only be used for one of these."
+    #endif
+    #define _SS_TCB       TCB1
+    #define _SS_TCB_vect  TCB1_INT_vect
+  #elif defined(SOFTSERIAL_USE_TIMERB2)
+    #if !defined(TCB2)
+      #error "SOFTSERIAL_USE_TIMERB2 is defined, but there is no TCB2 on selected part."
+    #elif defined(MILLIS_USE_TIMERB2)
+      #error "SOFTSERIAL_USE_TIMERB2 is defined, but so is MILLIS_USE_TIMERB2 - TCB2 can only be used for one of these."
+    #endif
+    #define _SS_TCB       TCB2
+    #define _SS_TCB_vect  TCB2_INT_vect
+  #elif defined(SOFTSERIAL_USE_TIMERB3)
+    #if !defined(TCB3)
+      #error "SOFTSERIAL_USE_TIMERB3 is defined, but there is no TCB3 on selected part."
+    #elif defined(MILLIS_USE_TIMERB3)
+      #error "SOFTSERIAL_USE_TIMERB3 is defined, but so is MILLIS_USE_TIMERB3 - TCB3 can only be used for one of these."
+    #endif
+    #define _SS_TCB       TCB3
+    #define _SS_TCB_vect  TCB3_INT_vect
+  #else
+    #if !defined(TCB4)
+      #error "SOFTSERIAL_USE_TIMERB4 is defined, but there is no TCB4 on selected part."
+    #elif defined(MILLIS_USE_TIMERB4)
+      #error "SOFTSERIAL_USE_TIMERB4 is defined, but so is MILLIS_USE_TIMERB4 - TCB4 can only be used for one of these."
+    #endif
+    #define _SS_TCB       TCB4
+    #define _SS_TCB_vect  TCB4_INT_vect
+  #endif
+  #ifndef _SS_MAX_TIMED
+    #define _SS_MAX_TIMED 4   // Maximum number of instances listening at once
+  #endif
+  #ifndef _SS_RX_LATENCY
+    #define _SS_RX_LATENCY 120 // system clocks from the start bit edge to reading TCB.CNT in the pin interrupt (attachInterrupt is slow)
+  #endif
+#endif
+
 class SoftwareSerial : public Stream {
   private:
     // per object data
@@ -67,10 +134,26 @@ class SoftwareSerial : public Stream {
     uint16_t _buffer_overflow: 1;
     uint16_t _inverse_logic: 1;
 
+    #if defined(SOFTSERIAL_TIMER_RX)
+    // Each instance receives on it's own, so each gets it's own buffer.
+    uint8_t _receive_buffer[_SS_MAX_RX_BUFF];
+    volatile uint8_t _receive_buffer_tail;
+    volatile uint8_t _receive_buffer_head;
+    uint16_t _rx_bit_ticks;         // one bit in TCB ticks (CLK_PER/2)
+    volatile uint16_t _rx_due;      // when the next sample is due, in the same timeline as _timer_base
+    volatile uint8_t _rx_state;     // 0 = idle, 1-8 = waiting for data bit, 9 = waiting for stop bit
+    volatile uint8_t _rx_byte;
+
+    static SoftwareSerial * volatile _timed[_SS_MAX_TIMED];
+    static volatile uint16_t _timer_base; // time of the last TCB compare match
+
+    inline void sampleBit() __attribute__((__always_inline__));
+    #else
     // static data
     static uint8_t _receive_buffer[_SS_MAX_RX_BUFF];
     static volatile uint8_t _receive_buffer_tail;
     static volatile uint8_t _receive_buffer_head;
+    #endif
     static SoftwareSerial *active_object;
 
     // private methods
@@ -93,9 +176,13 @@ class SoftwareSerial : public Stream {
     void begin(long speed);
     bool listen();
     void end();
+    #if defined(SOFTSERIAL_TIMER_RX)
+    bool isListening();
+    #else
     bool isListening() {
       return this == active_object;
     }
+    #endif
     bool stopListening();
     bool overflow() {
       bool ret = _buffer_overflow;
@@ -117,6 +204,9 @@ class SoftwareSerial : public Stream {
 
     // public only for easy access by interrupt handlers
     static inline void handle_interrupt() __attribute__((__always_inline__));
+    #if defined(SOFTSERIAL_TIMER_RX)
+    static inline void handle_timer() __attribute__((__always_inline__));
+    #endif
 };
 
 // Arduino 0012 workaround
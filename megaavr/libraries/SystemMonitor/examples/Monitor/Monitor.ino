@@ -0,0 +1,38 @@
+/* Monitor.ino - the chip temperature and supply voltages, without waiting for the ADC.
+ *
+ * SystemMonitor samples them every 500 ms in the background. Meanwhile loop() reads a pot on PIN_PD4 against VDD
+ * as fast as it likes - the monitor's conversions, with their own 2.048V reference, are slotted in between, and
+ * neither sees the other's reference. Each time a new round of readings is in, they're printed along with the pot.
+ * The supply voltages are only there on parts with MVIO (DB and DD-series).
+ */
+#include <SystemMonitor.h>
+
+uint16_t potMax = 0;
+
+void setup() {
+  Serial.begin(115200);
+  analogReference(VDD);
+  SystemMonitor.begin(500);
+}
+
+void loop() {
+  uint16_t pot = analogRead(PIN_PD4);
+  if (pot > potMax) {
+    potMax = pot;
+  }
+  if (SystemMonitor.available()) {
+    Serial.print("Temperature: ");
+    Serial.print(SystemMonitor.temperature());
+    Serial.print(" C");
+    #if defined(MVIO)
+      Serial.print("  VDD: ");
+      Serial.print(SystemMonitor.vdd());
+      Serial.print(" mV  VDDIO2: ");
+      Serial.print(SystemMonitor.vddio2());
+      Serial.print(" mV");
+    #endif
+    Serial.print("  pot peak: ");
+    Serial.println(potMax);
+    potMax = 0;
+  }
+}
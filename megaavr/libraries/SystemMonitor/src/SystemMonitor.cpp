@@ -0,0 +1,131 @@
+/* SystemMonitor.cpp - the chip temperature and supply voltages, sampled in the background.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ */
+#include "SystemMonitor.h"
+
+#define SYSMON_SAMPLE_DURATION  128     // as the core uses for the temperature sensor; the supply channels want long ones too
+
+SystemMonitorClass SystemMonitor;
+
+static uint8_t monitorDone(analogRequest_t *req);
+
+void SystemMonitorClass::_setup(analogRequest_t &req, uint8_t channel) {
+  req.muxpos   = channel & 0x7F;
+  req.muxneg   = 0x40;
+  req.ctrla    = ADC_RESSEL_12BIT_gc;
+  req.ctrlb    = 0;
+  req.sampctrl = SYSMON_SAMPLE_DURATION;
+  req.ref      = ADC_REQUEST_REF(INTERNAL2V048);   // 0.5 mV per count: the temperature calibration is for this one
+  req.callback = monitorDone;
+}
+
+void SystemMonitorClass::begin(uint16_t interval) {
+  end();
+  _setup(_request[0], ADC_TEMPERATURE);
+  #if defined(MVIO)
+    _setup(_request[1], ADC_VDDDIV10);
+    _setup(_request[2], ADC_VDDIO2DIV10);
+  #endif
+  _interval = interval;
+  _running  = true;
+  sample();
+}
+
+void SystemMonitorClass::end() {
+  if (!_running) {
+    return;
+  }
+  _running = false;
+  for (uint8_t i = 0; i < sizeof(_request) / sizeof(_request[0]); i++) {
+    analogDequeue(&_request[i]);
+  }
+  _pending = 0;
+}
+
+void SystemMonitorClass::update() {
+  #if !defined(MILLIS_USE_TIMERNONE)
+    if (_interval != 0 && _pending == 0 && (uint16_t) ((uint16_t) millis() - _last) >= _interval) {
+      sample();
+    }
+  #endif
+}
+
+void SystemMonitorClass::sample() {
+  uint8_t oldSREG = SREG;
+  cli();
+  if (_running && _pending == 0) {
+    // Interrupts are off, so no callback can count _pending down before it's counted up. Only what the queue took
+    // counts - it refuses the lot while a capture that started before the queue was ever used has the ADC.
+    for (uint8_t i = 0; i < sizeof(_request) / sizeof(_request[0]); i++) {
+      if (analogQueue(&_request[i], false)) {
+        _pending++;
+      }
+    }
+    #if !defined(MILLIS_USE_TIMERNONE)
+      if (_pending != 0) {
+        _last = millis();                   // if nothing was taken, update() tries again next time
+      }
+    #endif
+  }
+  SREG = oldSREG;
+}
+
+bool SystemMonitorClass::available() {
+  update();
+  uint8_t oldSREG = SREG;
+  cli();
+  bool ret = _new;
+  _new = 0;
+  SREG = oldSREG;
+  return ret;
+}
+
+int16_t SystemMonitorClass::temperature() {
+  update();
+  uint8_t oldSREG = SREG;
+  cli();
+  int16_t ret = _value[0];
+  SREG = oldSREG;
+  return ret;
+}
+
+#if defined(MVIO)
+  int16_t SystemMonitorClass::vdd() {
+    update();
+    uint8_t oldSREG = SREG;
+    cli();
+    int16_t ret = _value[1];
+    SREG = oldSREG;
+    return ret;
+  }
+
+  int16_t SystemMonitorClass::vddio2() {
+    update();
+    uint8_t oldSREG = SREG;
+    cli();
+    int16_t ret = _value[2];
+    SREG = oldSREG;
+    return ret;
+  }
+#endif
+
+void SystemMonitorClass::_done(analogRequest_t *req) {
+  uint16_t raw = req->result;
+  if (req == &_request[0]) {
+    _value[0] = _analogTempToCelsius(raw);
+  }
+  #if defined(MVIO)
+    else {
+      // a tenth of the supply, at 0.5 mV per count
+      _value[(req == &_request[1]) ? 1 : 2] = raw * 5;
+    }
+  #endif
+  if (--_pending == 0) {
+    _new = 1;
+  }
+}
+
+static uint8_t monitorDone(analogRequest_t *req) {
+  SystemMonitor._done(req);
+  return 0;                                // the next round is queued by update() or sample()
+}
@@ -0,0 +1,58 @@
+/* SystemMonitor.h - the chip temperature and supply voltages, sampled in the background.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ *
+ * Reading the temperature sensor or VDD/10 on demand means switching the ADC reference, letting it settle, and
+ * waiting out a long conversion - a few hundred microseconds every time. SystemMonitor instead puts the conversions
+ * on the ADC queue (see analogQueue() in Ref_Analog.md) every so often, with the 2.048V reference as their own, so
+ * the reference analogRead() uses isn't touched. The ADC interrupt applies the factory calibration and stores the
+ * results, and the read functions just return them.
+ *
+ * One round - the temperature, then VDD/10 and VDDIO2/10 where the part has them - is queued when one of the read
+ * functions or update() is called and the interval has passed since the last, or when sample() is called. A read
+ * returns the latest result straight away; a round it starts shows up in later reads.
+ */
+#ifndef SYSTEMMONITOR_H
+#define SYSTEMMONITOR_H
+
+#include <Arduino.h>
+
+#define SYSMON_NO_READING           (-32768)    // returned until the first round is done
+
+class SystemMonitorClass {
+  public:
+    // Starts sampling: a round now, then at most one every interval milliseconds. With an interval of 0, rounds
+    // are only done when sample() is called.
+    void     begin(uint16_t interval = 1000);
+    void     end();
+    // Queues a round if the interval is up. Cheap enough to call from loop() every time round, to keep the readings
+    // fresh even when nothing reads them for a while; the read functions call it themselves.
+    void     update();
+    // Queues a round now, unless one is under way. May be called from an interrupt - like a timer you already have.
+    void     sample();
+    bool     available();      // true once after each round
+    int16_t  temperature();    // degrees C, with the factory calibration from the signature row
+    #if defined(MVIO)
+      int16_t  vdd();          // millivolts
+      int16_t  vddio2();       // millivolts; only meaningful when MVIO is enabled and VDDIO2 is powered
+    #endif
+
+    void     _done(analogRequest_t *req);  // called by the ADC result interrupt
+  private:
+    void              _setup(analogRequest_t &req, uint8_t channel);
+    #if defined(MVIO)
+      analogRequest_t   _request[3]  = {};
+      volatile int16_t  _value[3]    = {SYSMON_NO_READING, SYSMON_NO_READING, SYSMON_NO_READING};
+    #else
+      analogRequest_t   _request[1]  = {};
+      volatile int16_t  _value[1]    = {SYSMON_NO_READING};
+    #endif
+    uint16_t          _interval    = 0;
+    uint16_t          _last        = 0;     // millis() when the last round was queued, low 16 bits
+    volatile uint8_t  _pending     = 0;     // conversions of this round still to do
+    volatile uint8_t  _new         = 0;
+    bool              _running     = false;
+};
+
+extern SystemMonitorClass SystemMonitor;
+
+#endif
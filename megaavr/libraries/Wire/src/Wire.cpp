@@ -457,6 +457,53 @@ twi_buffer_index_t TwoWire::requestFrom(uint8_t  address,  twi_buffer_index_t qu
 }
 
 
+/**
+ *@brief      writeFrom performs a complete host WRITE of a block of memory
+ *
+ *            Equivalent to beginTransmission(), write() and endTransmission(), except that the
+ *              data is sent straight from the buffer instead of being copied into the Wire buffer
+ *              first, so it isn't limited to BUFFER_LENGTH and costs no time to copy.
+ *
+ *@param      uint8_t address - the address of the client
+ *@param      const uint8_t *buffer - the data to send
+ *@param      size_t length - the number of bytes to send
+ *@param      bool sendStop - if the transaction should be terminated with a STOP condition
+ *
+ *@return     uint8_t - same as endTransmission()
+ */
+uint8_t TwoWire::writeFrom(uint8_t address, const uint8_t *buffer, size_t length, bool sendStop) {
+  if (__builtin_constant_p(address) && address > 0x7F) {     // Compile-time check if address is actually 7 bit long
+    badArg("Supplied address seems to be 8 bit. Only 7-bit-addresses are supported");
+  }
+  vars._clientAddress = address << 1;
+  return TWI_MasterWriteFrom(&vars, buffer, length, sendStop);
+}
+
+
+/**
+ *@brief      readInto performs a host READ straight into a block of memory
+ *
+ *            Like requestFrom(), but the received bytes are stored directly in buffer rather
+ *              than in the Wire buffer, so read() is not used, and the length isn't limited to
+ *              BUFFER_LENGTH.
+ *
+ *@param      uint8_t address - the address of the client
+ *@param      uint8_t *buffer - where to store the data, must have room for length bytes
+ *@param      size_t length - the amount of bytes to read
+ *@param      bool sendStop - if the transaction should be terminated with a STOP condition
+ *
+ *@return     size_t
+ *@retval     amount of bytes that were actually read. If 0, no read took place due to a bus error.
+ */
+size_t TwoWire::readInto(uint8_t address, uint8_t *buffer, size_t length, bool sendStop) {
+  if (__builtin_constant_p(address) && address > 0x7F) {     // Compile-time check if address is actually 7 bit long
+    badArg("Supplied address seems to be 8 bit. Only 7-bit-addresses are supported");
+  }
+  vars._clientAddress = address << 1;
+  return TWI_MasterReadInto(&vars, buffer, length, sendStop);
+}
+
+
 /**
  *@brief      beginTransmission prepares the Wire object for a host WRITE.
  *
@@ -964,6 +1011,117 @@ void TwoWire::onRequest(void (*function)(void)) {
 }
 
 
+/**
+ *@brief      exposeRegisters makes the client act like a typical I2C peripheral with a register map
+ *
+ *            The first byte of a host write selects the register, following bytes are written
+ *              to it and the registers after it. A host read returns the registers starting at the
+ *              register pointer. The pointer auto-increments and wraps at the end of the block.
+ *              All of this happens in the TWI interrupt without copying through the Wire buffers
+ *              or calling onReceive/onRequest. Only the bits set in writableMask[n] can be changed
+ *              by the host in regs[n]. begin(address) must still be called to enable the client.
+ *
+ *@param      volatile uint8_t *regs - the register block, or NULL to go back to the normal buffered mode
+ *@param      uint16_t length - number of registers, 1 to 256
+ *@param      const uint8_t *writableMask - array of length bytes, or NULL to make all registers read only
+ *
+ *@return     uint8_t
+ *@retval     0 on success, 1 if the length is invalid
+ */
+uint8_t TwoWire::exposeRegisters(volatile uint8_t *regs, uint16_t length, const uint8_t *writableMask) {
+  if (regs != NULL && (length == 0 || length > 256)) {
+    return 1;
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  vars._regMap                = regs;
+  vars._regLength             = length;
+  vars._regWritable           = writableMask;
+  vars._regPointer            = 0;
+  vars._regWriteCount         = 0;
+  vars._bools._regAddrNext    = 0;
+  vars._bools._regChanged     = 0;
+  vars._bools._regMode        = (regs != NULL);
+  SREG = oldSREG;
+  return 0;
+}
+
+
+/**
+ *@brief      registersChanged tells if the host has written to the registers
+ *
+ *            Polling this from loop() is an alternative to onRegisterWrite(). Calling it
+ *              clears the flag.
+ *
+ *@return     bool
+ *@retval     true if a host write to the registers has completed since the last call
+ */
+bool TwoWire::registersChanged(void) {
+  uint8_t oldSREG = SREG;
+  cli();
+  bool ret = vars._bools._regChanged;
+  vars._bools._regChanged = 0;
+  SREG = oldSREG;
+  return ret;
+}
+
+
+/**
+ *@brief      onRegisterWrite saves the pointer to the function to call when a host write to the registers ends
+ *
+ *            Called once per write, at the STOP or repeated START, with the first register written and
+ *              the number of bytes written (not counting the register pointer byte). Called in an ISR.
+ *
+ *@param      void (*function)(uint8_t, uint8_t) - a void returning function that accepts the first register and the count
+ *
+ *@return     void
+ */
+void TwoWire::onRegisterWrite(void (*function)(uint8_t, uint8_t)) {
+  vars.user_onRegisterWrite = function;
+}
+
+
+/**
+ *@brief      pecValue returns the SMBus PEC (CRC8, polynomial 0x07) of the bytes that have gone over the bus
+ *
+ *            Requires TWI_PEC_ENABLE to be defined when the library is compiled. The PEC is accumulated as
+ *              bytes are sent and received, including the address bytes, so it doesn't need a second pass.
+ *              As host, it covers everything since pecReset(). As client, it covers the current
+ *              transaction and is reset at the STOP, so use it from within onReceive/onRequest.
+ *              Like write(), inside the handlers or after selectSlaveBuffer() it returns the client PEC.
+ *              When the received PEC byte is included, a correct message gives 0.
+ *
+ *@return     uint8_t - the PEC
+ */
+uint8_t TwoWire::pecValue(void) {
+  #if defined(TWI_PEC_ENABLE)
+    #if defined(TWI_MANDS)
+      if (vars._bools._toggleStreamFn == 0x01) {
+        return vars._pecS;
+      }
+    #endif
+    return vars._pec;
+  #else
+    badCall("pecValue() requires TWI_PEC_ENABLE to be defined");
+    return 0;
+  #endif
+}
+
+
+/**
+ *@brief      pecReset starts a new host PEC, normally just before beginTransmission()
+ *
+ *@return     void
+ */
+void TwoWire::pecReset(void) {
+  #if defined(TWI_PEC_ENABLE)
+    vars._pec = 0;
+  #else
+    badCall("pecReset() requires TWI_PEC_ENABLE to be defined");
+  #endif
+}
+
+
 #if defined(TWI_READ_ERROR_ENABLED) && defined(TWI_ERROR_ENABLED)
 uint8_t TwoWire::returnError() {
   return vars._errors;
@@ -70,6 +70,7 @@ extern "C" {
 #define WIRE_SMBUS_LEVELS  1
 
 class TwoWire: public Stream {
+  friend class WireScheduler;
   private:
     twiData vars;   // We're using a struct to reduce the amount of parameters that have to be passed.
   public:
@@ -97,6 +98,9 @@ class TwoWire: public Stream {
     }
 
     twi_buffer_index_t requestFrom(uint8_t address, twi_buffer_index_t quantity, uint8_t sendStop = 1);
+    // Unbuffered host transfers straight to/from your memory, not limited to BUFFER_LENGTH
+    uint8_t writeFrom(uint8_t address, const uint8_t *buffer, size_t length, bool sendStop = true);
+    size_t  readInto(uint8_t address, uint8_t *buffer, size_t length, bool sendStop = true);
 
     virtual size_t write(uint8_t);
     virtual size_t write(const uint8_t *, size_t);
@@ -117,6 +121,15 @@ class TwoWire: public Stream {
     void onReceive(void (*)(int));
     void onRequest(void (*)(void));
 
+    // Register model client: serves host reads and writes directly from regs, see README
+    uint8_t exposeRegisters(volatile uint8_t *regs, uint16_t length, const uint8_t *writableMask = NULL);
+    bool registersChanged(void);
+    void onRegisterWrite(void (*)(uint8_t, uint8_t));
+
+    // SMBus PEC, only with TWI_PEC_ENABLE defined
+    uint8_t pecValue(void);
+    void    pecReset(void);
+
     inline size_t write(unsigned long n) {
       return      write((uint8_t)     n);
     }
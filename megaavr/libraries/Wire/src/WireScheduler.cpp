@@ -0,0 +1,237 @@
+/*
+  WireScheduler.cpp - interrupt driven, prioritized I2C master transactions on top of TwoWire.
+  Part of DxCore - this is free software, LGPL 2.1, see the Wire library header for details.
+*/
+
+#include "WireScheduler.h"
+
+extern "C" {
+  #include "twi.h"
+}
+
+#if !defined(MILLIS_USE_TIMERNONE)
+  #define _wsNow() ((uint16_t) millis())
+#endif
+
+// If no interrupt has come in this long while a job is on the bus, poll() gives up on it.
+#ifndef WIRESCHEDULER_TIMEOUT_MS
+  #define WIRESCHEDULER_TIMEOUT_MS 10
+#endif
+
+#if defined(TWI1)
+  static WireScheduler *_wireSched[2];
+#else
+  static WireScheduler *_wireSched[1];
+#endif
+
+uint8_t WireScheduler::begin() {
+  if (!_wire.vars._bools._hostEnabled) {
+    return 1;                         // Wire.begin() wasn't called
+  }
+  _module = _wire.vars._module;
+  #if defined(TWI1)
+    _wireSched[(_module == &TWI1) ? 1 : 0] = this;
+  #else
+    _wireSched[0] = this;
+  #endif
+  _module->MCTRLA |= TWI_RIEN_bm | TWI_WIEN_bm;
+  return 0;
+}
+
+void WireScheduler::end() {
+  while (_current != NULL) {          // let the job on the bus finish (or time out)
+    poll();
+  }
+  _module->MCTRLA &= ~(TWI_RIEN_bm | TWI_WIEN_bm);
+  #if defined(TWI1)
+    _wireSched[(_module == &TWI1) ? 1 : 0] = NULL;
+  #else
+    _wireSched[0] = NULL;
+  #endif
+}
+
+void WireScheduler::add(WireJob &job) {
+  uint8_t oldSREG = SREG;
+  cli();
+  WireJob **p = &_jobs;
+  while (*p != NULL && *p != &job) {
+    p = &((*p)->_next);
+  }
+  if (*p == NULL) {                   // appended, so that among equal priorities, the first added goes first
+    *p = &job;
+    job._next = NULL;
+    job.status = WIREJOB_IDLE;
+    #if !defined(MILLIS_USE_TIMERNONE)
+      job._lastRun = _wsNow() - job.period;  // periodic jobs are due right away
+    #endif
+  }
+  SREG = oldSREG;
+}
+
+bool WireScheduler::remove(WireJob &job) {
+  uint8_t oldSREG = SREG;
+  cli();
+  if (_current == &job) {
+    SREG = oldSREG;
+    return false;
+  }
+  WireJob **p = &_jobs;
+  while (*p != NULL) {
+    if (*p == &job) {
+      *p = job._next;
+      break;
+    }
+    p = &((*p)->_next);
+  }
+  job.status = WIREJOB_IDLE;
+  job._notify = 0;
+  SREG = oldSREG;
+  return true;
+}
+
+bool WireScheduler::trigger(WireJob &job) {
+  uint8_t oldSREG = SREG;
+  cli();
+  bool ok = (job.status != WIREJOB_QUEUED && job.status != WIREJOB_BUSY);
+  if (ok) {
+    job.status = WIREJOB_QUEUED;
+    if (_current == NULL && _module != NULL) {
+      _start();
+    }
+  }
+  SREG = oldSREG;
+  return ok;
+}
+
+void WireScheduler::poll() {
+  #if !defined(MILLIS_USE_TIMERNONE)
+    uint16_t now = _wsNow();
+  #endif
+  for (WireJob *job = _jobs; job != NULL; job = job->_next) {
+    #if !defined(MILLIS_USE_TIMERNONE)
+      if (job->period) {
+        uint16_t elapsed = now - job->_lastRun;
+        if (elapsed >= job->period && trigger(*job)) {
+          // Keep to the schedule, unless we've fallen more than a whole period behind.
+          job->_lastRun = (elapsed >= 2 * job->period) ? now : job->_lastRun + job->period;
+        }
+      }
+    #endif
+    if (job->_notify) {
+      job->_notify = 0;
+      if (job->onComplete != NULL) {
+        job->onComplete(*job);
+      }
+    }
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  #if !defined(MILLIS_USE_TIMERNONE)
+    if (_current != NULL && (uint16_t)(_wsNow() - _activity) > WIRESCHEDULER_TIMEOUT_MS) {
+      TWI_Flush(&_wire.vars);         // Something is holding the bus; reset the host and move on.
+      _module->MSTATUS = TWI_BUSSTATE_IDLE_gc;
+      _finish(TWI_ERR_TIMEOUT);
+    }
+  #endif
+  if (_current == NULL && _module != NULL) {
+    _start();                         // anything _finish() couldn't start because the last STOP was slow to go out
+  }
+  SREG = oldSREG;
+}
+
+// Called with interrupts disabled, when no job is on the bus. Picks the highest priority queued job and sends its
+// address; everything after that happens in _isr(). While we still own the bus, that would be a repeated start
+// instead, so then it leaves the job queued for poll().
+void WireScheduler::_start() {
+  if ((_module->MSTATUS & TWI_BUSSTATE_gm) == TWI_BUSSTATE_OWNER_gc) {
+    return;
+  }
+  WireJob *next = NULL;
+  for (WireJob *job = _jobs; job != NULL; job = job->_next) {
+    if (job->status == WIREJOB_QUEUED && (next == NULL || job->priority < next->priority)) {
+      next = job;
+    }
+  }
+  _current = next;
+  if (next == NULL) {
+    return;
+  }
+  next->status = WIREJOB_BUSY;
+  _index = 0;
+  #if !defined(MILLIS_USE_TIMERNONE)
+    _activity = _wsNow();
+  #endif
+  // A job with nothing to write starts with the read; the usual case is writing a register address first. One with
+  // nothing to read or write is a probe: the address is written, and the ACK or NACK is all there is to it.
+  _reading = (next->txLength == 0 && next->rxLength != 0);
+  _module->MADDR = (next->address << 1) | _reading;
+}
+
+void WireScheduler::_finish(uint8_t error) {
+  WireJob *job = _current;
+  job->error     = error;
+  job->status    = error ? WIREJOB_ERROR : WIREJOB_DONE;
+  job->_complete = 1;
+  job->_notify   = 1;
+  _current = NULL;
+  // The STOP we just issued goes out within one SCL period, 10 + 2 * MBAUD system clocks, and MADDR can't be
+  // written until it has. Each pass of this loop takes at least 5 clocks, so this waits for it in the interrupt
+  // for at most a few times as long as it can take; if the bus is somehow still ours after that, _start() leaves
+  // the next job to poll().
+  uint16_t timeout = _module->MBAUD + 10;
+  while ((_module->MSTATUS & TWI_BUSSTATE_gm) == TWI_BUSSTATE_OWNER_gc && --timeout);
+  _start();
+}
+
+void WireScheduler::_isr() {
+  TWI_t *module = _module;
+  WireJob *job = _current;
+  uint8_t status = module->MSTATUS;
+  if (job == NULL) {                  // shouldn't happen, but don't leave the flags set.
+    module->MSTATUS = TWI_RIF_bm | TWI_WIF_bm;
+    return;
+  }
+  #if !defined(MILLIS_USE_TIMERNONE)
+    _activity = _wsNow();
+  #endif
+  if (status & (TWI_ARBLOST_bm | TWI_BUSERR_bm)) {
+    module->MSTATUS = TWI_ARBLOST_bm | TWI_BUSERR_bm | TWI_WIF_bm | TWI_RIF_bm;
+    _finish(TWI_ERR_BUS_ARB);         // we no longer own the bus, so no STOP
+  } else if (status & TWI_RIF_bm) {   // got a byte
+    job->rxData[_index++] = module->MDATA;
+    if (_index < job->rxLength) {
+      module->MCTRLB = TWI_MCMD_RECVTRANS_gc;            // ACK it and get the next one
+    } else {
+      module->MCTRLB = TWI_ACKACT_bm | TWI_MCMD_STOP_gc; // NACK the last byte and STOP
+      _finish(TWI_ERR_SUCCESS);
+    }
+  } else if (status & TWI_WIF_bm) {   // address or data byte sent
+    if (status & TWI_RXACK_bm) {      // NACKed
+      module->MCTRLB = TWI_MCMD_STOP_gc;
+      _finish((_reading || _index == 0) ? TWI_ERR_ACK_ADR : TWI_ERR_ACK_DAT);
+    } else if (!_reading && _index < job->txLength) {
+      module->MDATA = job->txData[_index++];
+    } else if (!_reading && job->rxLength) {
+      _reading = 1;                   // written the register address, now repeated start and read
+      _index = 0;
+      module->MADDR = (job->address << 1) | 1;
+    } else {
+      module->MCTRLB = TWI_MCMD_STOP_gc;
+      _finish(TWI_ERR_SUCCESS);
+    }
+  }
+}
+
+ISR(TWI0_TWIM_vect) {
+  if (_wireSched[0] != NULL) {
+    _wireSched[0]->_isr();
+  }
+}
+
+#if defined(TWI1)
+  ISR(TWI1_TWIM_vect) {
+    if (_wireSched[1] != NULL) {
+      _wireSched[1]->_isr();
+    }
+  }
+#endif
@@ -0,0 +1,80 @@
+/*
+  WireScheduler.h - interrupt driven, prioritized I2C master transactions on top of TwoWire.
+  Part of DxCore - this is free software, LGPL 2.1, see the Wire library header for details.
+
+  Each transaction is a WireJob, allocated by the sketch: an optional write (typically a register
+  address) followed by an optional read, with a repeated start between the two. Jobs are added to
+  the scheduler for a given Wire object, and run one after another from the TWI master interrupt,
+  with the highest priority pending job going next. Periodic jobs are queued by poll(), which also
+  calls the completion handlers, so that they do not run in interrupt context.
+  See the Wire README for details.
+*/
+
+#ifndef WIRESCHEDULER_H_
+#define WIRESCHEDULER_H_
+
+#include <Arduino.h>
+#include "Wire.h"
+
+// WireJob::status
+#define WIREJOB_IDLE      0  // never run, or removed
+#define WIREJOB_QUEUED    1  // waiting for the bus
+#define WIREJOB_BUSY      2  // on the bus right now
+#define WIREJOB_DONE      3  // completed successfully; data is in rxData
+#define WIREJOB_ERROR     4  // failed, see WireJob::error (same codes as endTransmission())
+
+class WireJob {
+  public:
+    WireJob(uint8_t address, const uint8_t *txData, uint16_t txLength, uint8_t *rxData, uint16_t rxLength) :
+      address(address), txData(txData), rxData(rxData), txLength(txLength), rxLength(rxLength) {}
+    uint8_t           address;
+    uint8_t           priority = 0;       // 0 is the highest. Jobs of equal priority go in the order they were added.
+    const uint8_t    *txData;
+    uint8_t          *rxData;
+    uint16_t          txLength;
+    uint16_t          rxLength;
+    uint16_t          period = 0;         // in ms. 0 = only runs when trigger()'ed
+    void            (*onComplete)(WireJob &) = NULL;
+    volatile uint8_t  status = WIREJOB_IDLE;
+    volatile uint8_t  error  = 0;
+    // true once each time the job has finished (successfully or not); clears the flag.
+    bool ready() {
+      bool r = _complete;
+      _complete = 0;
+      return r;
+    }
+  private:
+    friend class WireScheduler;
+    volatile bool     _complete = 0;
+    bool              _notify   = 0;       // onComplete is due to be called by poll()
+    uint16_t          _lastRun  = 0;
+    WireJob          *_next     = NULL;
+};
+
+class WireScheduler {
+  public:
+    explicit WireScheduler(TwoWire &wire) : _wire(wire) {}
+    // Wire.begin() must have been called. From then on, all master traffic on this bus must go through the
+    // scheduler (or end() it first); a blocking endTransmission() or requestFrom() would race with it.
+    uint8_t begin();
+    void    end();
+    void    add(WireJob &job);
+    bool    remove(WireJob &job);     // false if the job is on the bus right now; try again later
+    bool    trigger(WireJob &job);    // queue it now, regardless of period. false if it is already queued or busy.
+    void    poll();                   // call from loop(): queues periodic jobs, calls onComplete handlers, catches hung transfers
+    bool    busy()    {return _current != NULL;}
+
+    void    _isr();                   // called by the TWI master interrupt
+  private:
+    void    _start();
+    void    _finish(uint8_t error);
+    TwoWire  &_wire;
+    TWI_t    *_module   = NULL;
+    WireJob  *_jobs     = NULL;
+    WireJob  *volatile _current = NULL;
+    uint16_t  _index    = 0;
+    bool      _reading  = 0;
+    uint16_t  _activity = 0;          // millis() at the last interrupt, to detect a hung bus
+};
+
+#endif
@@ -24,6 +24,12 @@ SOFTWARE.
 #include "Arduino.h"
 #include "twi.h"
 #include "twi_pins.h"
+#if defined(TWI_PEC_ENABLE)
+  #include "crc_fast.h"
+  #define TWI_PEC_UPDATE(pec, data) (pec) = crc8_smbus_update((pec), (data))
+#else
+  #define TWI_PEC_UPDATE(pec, data)
+#endif
 
 
 static uint8_t sleepStack = 0;
@@ -238,9 +244,10 @@ uint8_t TWI_MasterSetBaud(struct twiData *_data, uint32_t frequency) {
  *@return             uint8_t value for the MBAUD register
  *@retval             the desired baud value
  */
-#define TWI_BAUD(freq, t_rise) ((F_CPU / freq) / 2) - (5 + (((F_CPU / 1000000) * t_rise) / 2000))
+#define TWI_BAUD(freq, t_rise) ((fcpu / freq) / 2) - (5 + (((fcpu / 1000000) * t_rise) / 2000))
 uint8_t TWI_MasterCalcBaud(uint32_t frequency) {
   int16_t baud;
+  uint32_t fcpu = getCPUFrequency();    // F_CPU unless setCPUFrequency() has been used.
 
   #if (F_CPU == 20000000) || (F_CPU == 10000000)
     if (frequency >= 600000) {          // assuming 1.5kOhm
@@ -277,6 +284,57 @@ uint8_t TWI_MasterCalcBaud(uint32_t frequency) {
   return (uint8_t)baud;
 }
 
+/**
+ *@brief      TWI_ClockChanged rescales MBAUD of every enabled host when the system clock is changed
+ *
+ *            Called by setCPUFrequency() in the core. Every term in TWI_BAUD except the 5 is proportional
+ *              to the clock, so (MBAUD + 5) scales directly with it, and we don't need to know what SCL
+ *              frequency was asked for. To keep rounding errors from piling up over repeated changes, the
+ *              first MBAUD we see and the clock it was for are kept and scaled from, until setClock() or
+ *              begin() write something different. The host is disabled while MBAUD is written, as in
+ *              TWI_MasterSetBaud
+ *
+ *@param      uint16_t oldkhz - the clock speed MBAUD was calculated for, in kHz
+ *@param      uint16_t newkhz - the clock speed it is now running at, in kHz
+ *
+ *@return     void
+ */
+struct twiBaudRef {
+  uint8_t  written;
+  uint8_t  ref;
+  uint16_t refkhz;
+};
+
+static void TWI_RescaleBaud(TWI_t *module, struct twiBaudRef *ref, uint16_t oldkhz, uint16_t newkhz) {
+  uint8_t restore = module->MCTRLA;
+  if (!(restore & TWI_ENABLE_bm)) {
+    return;
+  }
+  if (module->MBAUD != ref->written || ref->refkhz == 0) {
+    ref->ref    = module->MBAUD;
+    ref->refkhz = oldkhz;
+  }
+  int32_t baud = (((((int32_t) ref->ref + 5) * newkhz) + (ref->refkhz >> 1)) / ref->refkhz) - 5;
+  if (baud < 0) {
+    baud = 0;
+  } else if (baud > 255) {
+    baud = 255;
+  }
+  module->MCTRLA  = 0;
+  module->MBAUD   = (uint8_t) baud;
+  module->MCTRLA  = restore;
+  module->MSTATUS = TWI_BUSSTATE_IDLE_gc;   // Force the state machine into IDLE according to the data sheet
+  ref->written    = (uint8_t) baud;
+}
+
+void TWI_ClockChanged(uint16_t oldkhz, uint16_t newkhz) {
+  static struct twiBaudRef refs[2];
+  TWI_RescaleBaud(&TWI0, &refs[0], oldkhz, newkhz);
+  #if defined(TWI1)
+    TWI_RescaleBaud(&TWI1, &refs[1], oldkhz, newkhz);
+  #endif
+}
+
 /**
  *@brief      TWI_MasterWrite performs a host write operation on the TWI bus
  *
@@ -293,22 +351,35 @@ uint8_t TWI_MasterCalcBaud(uint32_t frequency) {
  *            to an error or because of an empty txBuffer
  */
 uint8_t TWI_MasterWrite(struct twiData *_data, bool send_stop) {
-  uint8_t* txBuffer;
-  twi_buffer_index_t *txHead;
   #if defined(TWI_MERGE_BUFFERS)                          // Same Buffers for tx/rx
-    txHead   = &(_data->_bytesToReadWrite);
-    txBuffer =   _data->_trBuffer;
+    return TWI_MasterWriteFrom(_data, _data->_trBuffer, _data->_bytesToReadWrite, send_stop);
   #else                                                   // Separate tx/rx Buffers
-    txHead   = &(_data->_bytesToWrite);
-    txBuffer =   _data->_txBuffer;
+    return TWI_MasterWriteFrom(_data, _data->_txBuffer, _data->_bytesToWrite, send_stop);
   #endif
+}
+
 
+/**
+ *@brief      TWI_MasterWriteFrom performs a host write operation from any block of memory
+ *
+ *            This is TWI_MasterWrite without the buffer: the bytes go straight from txBuffer to
+ *              MDATA, so there is no copy and no limit to the length besides size_t.
+ *              The client address is taken from _data->_clientAddress as usual.
+ *
+ *@param      struct twiData *_data is a pointer to the structure that holds the Wire variables
+ *@param      const uint8_t *txBuffer - the data to send
+ *@param      size_t length - the number of bytes to send
+ *@param      bool send_stop enables the STOP condition at the end of a write
+ *
+ *@return     uint8_t - error code, see TwoWire::endTransmission
+ */
+uint8_t TWI_MasterWriteFrom(struct twiData *_data, const uint8_t *txBuffer, size_t length, bool send_stop) {
   TWI_t *module = _data->_module;     // Compiler treats the pointer to the TWI module as volatile and
                                       // creates bloat-y code, this fixes it
   TWI_INIT_ERROR;
   uint8_t currentSM;
   uint8_t currentStatus;
-  twi_buffer_index_t dataWritten = 0;
+  size_t dataWritten = 0;
   #if defined (TWI_TIMEOUT_ENABLE)
     uint16_t timeout = 0;
   #endif
@@ -344,6 +415,7 @@ uint8_t TWI_MasterWrite(struct twiData *_data, bool send_stop) {
 
     if (currentSM == TWI_BUSSTATE_IDLE_gc) {                      // Bus has not sent START yet and is not BUSY
         module->MADDR = ADD_WRITE_BIT(_data->_clientAddress);
+        TWI_PEC_UPDATE(_data->_pec, ADD_WRITE_BIT(_data->_clientAddress));
         #if defined (TWI_TIMEOUT_ENABLE)
           timeout = 0;                           // reset timeout
         #endif
@@ -354,8 +426,9 @@ uint8_t TWI_MasterWrite(struct twiData *_data, bool send_stop) {
           else                  TWI_SET_ERROR(TWI_ERR_ACK_DAT);   // else payload was NACKed
           break;                                                  // leave loop
         } else {                                                  // otherwise WRITE was ACKed
-          if (dataWritten < (*txHead)) {                          // check if there is data to be written
+          if (dataWritten < length) {                             // check if there is data to be written
             module->MDATA = txBuffer[dataWritten];                // Writing to the register to send data
+            TWI_PEC_UPDATE(_data->_pec, txBuffer[dataWritten]);
             dataWritten++;                                        // data was Written
             #if defined (TWI_TIMEOUT_ENABLE)
               timeout = 0;                                        // reset timeout
@@ -393,25 +466,38 @@ uint8_t TWI_MasterWrite(struct twiData *_data, bool send_stop) {
  *@retval     amount of bytes that were actually read. If 0, no read took place due to a bus error
  */
 twi_buffer_index_t TWI_MasterRead(struct twiData *_data, twi_buffer_index_t bytesToRead, bool send_stop) {
-  uint8_t* rxBuffer;
-  twi_buffer_index_t *rxHead, *rxTail;
   #if defined(TWI_MERGE_BUFFERS)                            // Same Buffers for tx/rx
-    rxHead   = &(_data->_bytesToReadWrite);
-    rxTail   = &(_data->_bytesReadWritten);
-    rxBuffer =   _data->_trBuffer;
+    _data->_bytesReadWritten = 0;                           // Reset counter
+    _data->_bytesToReadWrite = TWI_MasterReadInto(_data, _data->_trBuffer, bytesToRead, send_stop);
+    return _data->_bytesToReadWrite;
   #else                                                     // Separate tx/rx Buffers
-    rxHead   = &(_data->_bytesToRead);
-    rxTail   = &(_data->_bytesRead);
-    rxBuffer =   _data->_rxBuffer;
+    _data->_bytesRead = 0;                                  // Reset counter
+    _data->_bytesToRead = TWI_MasterReadInto(_data, _data->_rxBuffer, bytesToRead, send_stop);
+    return _data->_bytesToRead;
   #endif
+}
 
-  (*rxTail) = 0;                      // Reset counter
 
+/**
+ *@brief      TWI_MasterReadInto performs a host read operation into any block of memory
+ *
+ *            This is TWI_MasterRead without the buffer: each byte goes straight from MDATA to
+ *              rxBuffer, so there is no copy and no limit to the length besides size_t.
+ *              The client address is taken from _data->_clientAddress as usual.
+ *
+ *@param      struct twiData *_data is a pointer to the structure that holds the Wire variables
+ *@param      uint8_t *rxBuffer - where to put the data, must have room for bytesToRead bytes
+ *@param      size_t bytesToRead is the desired amount of bytes to read. When finished, a NACK is issued.
+ *@param      bool send_stop enables the STOP condition at the end of a write
+ *
+ *@return     size_t - amount of actually read bytes
+ */
+size_t TWI_MasterReadInto(struct twiData *_data, uint8_t *rxBuffer, size_t bytesToRead, bool send_stop) {
   TWI_t *module = _data->_module;     // Compiler treats the pointer to the TWI module as volatile and
                                       // creates bloat-y code, using a local variable fixes that
 
   TWIR_INIT_ERROR;             // local variable for errors
-  twi_buffer_index_t dataRead = 0;
+  size_t dataRead = 0;
 
   if ((module->MSTATUS & TWI_BUSSTATE_gm) != TWI_BUSSTATE_UNKNOWN_gc) {
     uint8_t currentSM;
@@ -422,6 +508,7 @@ twi_buffer_index_t TWI_MasterRead(struct twiData *_data, twi_buffer_index_t byte
     #endif
 
     module->MADDR = ADD_READ_BIT(_data->_clientAddress);  // Send Address with read bit
+    TWI_PEC_UPDATE(_data->_pec, ADD_READ_BIT(_data->_clientAddress));
 
     while (true) {
       currentStatus = module->MSTATUS;
@@ -456,8 +543,9 @@ twi_buffer_index_t TWI_MasterRead(struct twiData *_data, twi_buffer_index_t byte
 
       if (currentSM == TWI_BUSSTATE_OWNER_gc) {  // Address sent, check for WIF/RIF
         if (currentStatus & TWI_RIF_bm) {         // data received
-          if (dataRead < BUFFER_LENGTH) {          // Buffer still free
+          if (dataRead < bytesToRead) {            // Buffer still free
             rxBuffer[dataRead] = module->MDATA;      // save byte in the Buffer.
+            TWI_PEC_UPDATE(_data->_pec, rxBuffer[dataRead]);
             dataRead++;                              // increment read counter
             #if defined (TWI_TIMEOUT_ENABLE)
               timeout = 0;                           // reset timeout
@@ -483,7 +571,6 @@ twi_buffer_index_t TWI_MasterRead(struct twiData *_data, twi_buffer_index_t byte
         }
       }
     }
-    (*rxHead) = dataRead;
   } else {
     TWIR_SET_ERROR(TWI_ERR_UNINIT);
   }
@@ -494,6 +581,118 @@ twi_buffer_index_t TWI_MasterRead(struct twiData *_data, twi_buffer_index_t byte
 }
 
 
+/**
+ *@brief      TWI_RegisterWriteDone finishes a host write in register mode
+ *
+ *            Called at the STOP, or at a REPSTART, since a register write followed by a read with a
+ *              repeated start never produces a STOP between the two. Sets the changed flag and calls
+ *              the onRegisterWrite() handler, if any, once per write rather than once per byte.
+ *
+ *@param      struct twiData *_data is a pointer to the structure that holds the Wire variables
+ *
+ *@return     void
+ */
+static inline void TWI_RegisterWriteDone(struct twiData *_data) {
+  if (_data->_regWriteCount > 0) {
+    _data->_bools._regChanged = 1;
+    if (_data->user_onRegisterWrite != NULL) {
+      _data->user_onRegisterWrite(_data->_regWriteStart, _data->_regWriteCount);
+    }
+    _data->_regWriteCount = 0;
+  }
+}
+
+
+/**
+ *@brief      TWI_HandleRegisterIRQ is the client handler used after exposeRegisters()
+ *
+ *            The first byte of every host write sets the register pointer, any further bytes are
+ *              written to the registers through the writable mask. Host reads are served from the
+ *              register pointer. The pointer auto-increments after every byte in both directions
+ *              and wraps to 0 at the end of the block. Nothing is copied to or from the Wire buffers
+ *              and no handler is called per transaction, so each data interrupt is just a few loads
+ *              and stores and the host doesn't have to wait on us.
+ *
+ *@param      struct twiData *_data is a pointer to the structure that holds the Wire variables
+ *
+ *@return     void
+ */
+static inline void TWI_HandleRegisterIRQ(struct twiData *_data) {
+  uint8_t action;
+  uint8_t clientStatus = _data->_module->SSTATUS;
+  volatile uint8_t *regs = _data->_regMap;
+  uint8_t ptr = _data->_regPointer;
+
+  if (clientStatus & TWI_APIF_bm) {         // Address/Stop Bit set
+    if (clientStatus & TWI_AP_bm) {           // Address bit set
+      uint8_t payload = _data->_module->SDATA;
+      TWI_RegisterWriteDone(_data);           // in case this is a REPSTART after a write
+      #if defined(TWI_MANDS)
+        _data->_incomingAddress = payload;
+      #else
+        _data->_clientAddress   = payload;
+      #endif
+      if (!(clientStatus & TWI_DIR_bm)) {     // Master is writing, so the register pointer comes first
+        _data->_bools._regAddrNext = 1;
+      }
+      action = TWI_SCMD_RESPONSE_gc;          // ACK, we always have data to send
+      if (!_data->_bools._regOpen) {          // A REPSTART is still the same transaction, with one STOP at the end,
+        _data->_bools._regOpen = 1;           // so only the first address match pushes
+        pushSleep();
+      }
+    } else {                                  // Stop bit set
+      _data->_bools._regOpen = 0;
+      popSleep();
+      TWI_RegisterWriteDone(_data);
+      action = TWI_SCMD_COMPTRANS_gc;
+    }
+  } else if (clientStatus & TWI_DIF_bm) {   // Data bit set
+    if (clientStatus & TWI_DIR_bm) {          // Master is reading
+      if ((clientStatus & (TWI_COLL_bm | TWI_RXACK_bm)) && (true == _data->_bools._ackMatters)) {
+        _data->_bools._ackMatters = false;      // master NACKed the last byte, it's done.
+        action = TWI_SCMD_COMPTRANS_gc;
+      } else {
+        _data->_bytesTransmittedS++;
+        _data->_bools._ackMatters = true;
+        _data->_module->SDATA = regs[ptr];
+        if (++ptr >= _data->_regLength) {
+          ptr = 0;
+        }
+        action = TWI_SCMD_RESPONSE_gc;
+      }
+    } else {                                  // Master is writing
+      uint8_t payload = _data->_module->SDATA;
+      action = TWI_SCMD_RESPONSE_gc;
+      if (_data->_bools._regAddrNext) {
+        _data->_bools._regAddrNext = 0;
+        if (payload < _data->_regLength) {
+          ptr = payload;
+          _data->_regWriteStart = payload;
+        } else {
+          action = TWI_ACKACT_bm | TWI_SCMD_COMPTRANS_gc;  // no such register, NACK
+        }
+      } else {
+        const uint8_t *writable = _data->_regWritable;
+        uint8_t mask = (writable == NULL) ? 0 : writable[ptr];
+        if (mask) {
+          regs[ptr] = (regs[ptr] & ~mask) | (payload & mask);
+        }
+        if (_data->_regWriteCount < 255) {
+          _data->_regWriteCount++;
+        }
+        if (++ptr >= _data->_regLength) {
+          ptr = 0;
+        }
+      }
+    }
+  } else {
+    return;
+  }
+  _data->_regPointer = ptr;
+  _data->_module->SCTRLB = action;
+}
+
+
 /**
  *@brief      TWI_HandleSlaveIRQ checks the status register and decides the next action based on that
  *
@@ -517,6 +716,11 @@ void TWI_HandleSlaveIRQ(struct twiData *_data) {
 
   __asm__ __volatile__("\n\t": "=&y" (_data) : "0" (_data));  // force _data into Y and instruct to not change Y
 
+  if (_data->_bools._regMode) {
+    TWI_HandleRegisterIRQ(_data);
+    return;
+  }
+
   uint8_t *address,  *txBuffer, *rxBuffer;
   twi_buffer_index_t *txHead, *txTail,  *rxHead, *rxTail;
   #if defined(TWI_MANDS)
@@ -552,6 +756,14 @@ void TWI_HandleSlaveIRQ(struct twiData *_data) {
     #endif
   #endif
 
+  #if defined(TWI_PEC_ENABLE)
+    #if defined(TWI_MANDS)
+      uint8_t *pec = &(_data->_pecS);
+    #else
+      uint8_t *pec = &(_data->_pec);
+    #endif
+  #endif
+
   #if defined(TWI_MANDS)
     _data->_bools._toggleStreamFn = 0x01;
   #endif
@@ -562,6 +774,7 @@ void TWI_HandleSlaveIRQ(struct twiData *_data) {
   if (clientStatus & TWI_APIF_bm) {  // Address/Stop Bit set
     if (clientStatus & TWI_AP_bm) {    // Address bit set
       uint8_t payload = _data->_module->SDATA;  // read address from data register
+      TWI_PEC_UPDATE(*pec, payload);
       if (clientStatus & TWI_DIR_bm) {  // Master is reading
         if ((*rxHead) > 0) {                    // There is no way to identify a REPSTART,
           popSleep();                           // (have to treat REPSTART as another pop for sleep)
@@ -595,6 +808,9 @@ void TWI_HandleSlaveIRQ(struct twiData *_data) {
           _data->user_onReceive((*rxHead));
         }
       }
+      #if defined(TWI_PEC_ENABLE)
+        (*pec) = 0;                    // The next transaction starts a new PEC
+      #endif
       action = TWI_SCMD_COMPTRANS_gc;  // "Wait for any Start (S/Sr) condition"
       (*rxHead) = 0;
       (*txHead) = 0;
@@ -613,6 +829,7 @@ void TWI_HandleSlaveIRQ(struct twiData *_data) {
         _data->_bools._ackMatters = true;       // start checking for NACK
         if ((*txTail) < (*txHead)) {            // Data is available
           _data->_module->SDATA = txBuffer[(*txTail)];  // Writing to the register to send data
+          TWI_PEC_UPDATE(*pec, txBuffer[(*txTail)]);
           (*txTail)++;                            // Increment counter for sent bytes
           action = TWI_SCMD_RESPONSE_gc;          // "Execute a byte read operation followed by Acknowledge Action"
         } else {                                // No more data available
@@ -621,6 +838,7 @@ void TWI_HandleSlaveIRQ(struct twiData *_data) {
       }
     } else {                                  // Master is writing
       uint8_t payload = _data->_module->SDATA;      // reading SDATA will clear the DATA IRQ flag
+      TWI_PEC_UPDATE(*pec, payload);
       if ((*rxHead) < BUFFER_LENGTH) {              // make sure that we don't have a buffer overflow in case Master ignores NACK
         rxBuffer[(*rxHead)] = payload;              // save data
         (*rxHead)++;                                  // Advance Head
@@ -118,6 +118,7 @@ SOFTWARE.
 #define  TWI_ERROR_ENABLED        // Enabled by default, TWI Master Write error functionality
 //#define TWI_READ_ERROR_ENABLED  // Enabled on Master Read too
 //#define DISABLE_NEW_ERRORS      // Disables the new error codes and returns TWI_ERR_UNDEFINED instead.
+//#define TWI_PEC_ENABLE          // Keep a running SMBus PEC (crc8_smbus) of every byte on the bus, see pecValue(). Must be a build flag.
 
 // Errors from Arduino documentation:
 #define  TWI_ERR_SUCCESS         0x00  // Default
@@ -181,7 +182,10 @@ struct twiDataBools {       // using a struct so the compiler can use skip if bi
   bool _hostEnabled:      1;
   bool _clientEnabled:    1;
   bool _ackMatters:       1;
-  uint8_t _reserved:      4;
+  bool _regMode:          1;  // client serves reads/writes straight from the exposeRegisters() block
+  bool _regAddrNext:      1;  // next byte written by the host is the register pointer
+  bool _regChanged:       1;  // set at the end of a host write to the registers, cleared by registersChanged()
+  bool _regOpen:          1;  // register mode: an address match has pushed sleep, and no STOP has popped it yet
 };
 
 
@@ -209,6 +213,19 @@ struct twiData {
   #endif
   void (*user_onRequest)(void);
   void (*user_onReceive)(int);
+  #if defined(TWI_PEC_ENABLE)
+    uint8_t _pec;                    // SMBus PEC of the bytes since pecReset() (host), or since the last STOP (client)
+    #if defined(TWI_MANDS)
+      uint8_t _pecS;                 // client PEC when host and client are separate
+    #endif
+  #endif
+  volatile uint8_t *_regMap;         // Register model, see exposeRegisters()
+  const uint8_t *_regWritable;       // per-register mask of bits the host may write, NULL if read only
+  void (*user_onRegisterWrite)(uint8_t, uint8_t);
+  uint16_t _regLength;
+  uint8_t _regPointer;
+  uint8_t _regWriteStart;            // register the current host write started at
+  uint8_t _regWriteCount;            // and how many were written
   #if defined(TWI_MERGE_BUFFERS)
     uint8_t _trBuffer[BUFFER_LENGTH];
   #else
@@ -228,10 +245,13 @@ void     TWI_DisableMaster(struct   twiData *_data);
 void     TWI_DisableSlave(struct    twiData *_data);
 void     TWI_HandleSlaveIRQ(struct  twiData *_data);
 uint8_t  TWI_MasterWrite(struct     twiData *_data, bool send_stop);
+uint8_t  TWI_MasterWriteFrom(struct twiData *_data, const uint8_t *txBuffer, size_t length, bool send_stop);
 uint8_t  TWI_MasterSetBaud(struct   twiData *_data, uint32_t frequency);
 void     TWI_SlaveInit(struct       twiData *_data, uint8_t address, uint8_t receive_broadcast, uint8_t second_address);
 uint8_t  TWI_MasterCalcBaud(uint32_t frequency);
+void     TWI_ClockChanged(uint16_t oldkhz, uint16_t newkhz);
 
 twi_buffer_index_t  TWI_MasterRead(struct twiData *_data, twi_buffer_index_t bytesToRead, bool send_stop);
+size_t              TWI_MasterReadInto(struct twiData *_data, uint8_t *rxBuffer, size_t bytesToRead, bool send_stop);
 
 #endif
@@ -0,0 +1,38 @@
+/***********************************************************************|
+| AVR DA/DB Zero-cross detect library                                   |
+|                                                                       |
+| Dimmer.ino                                                            |
+|                                                                       |
+| Phase angle control of a triac (through an opto-triac driver) with    |
+| the firing angle timed entirely in hardware: ZCD0 starts TCB1 on each |
+| zero crossing through the event system, and TCB1's output, on PA3,    |
+| turns the gate on when the delay is up. A potentiometer on PD3 sets   |
+| the level. The CPU only gets an interrupt when the level changes.     |
+|                                                                       |
+| See the datasheet's ZCD chapter for the (mains voltage!) input        |
+| network. TCB1 must not be the millis timer.                           |
+|***********************************************************************/
+
+#include <PhaseControl.h>
+
+void setup() {
+  Serial.begin(115200);
+  zcd.init();
+  zcd.start();
+  // Gate on PA3, TCB1's output pin; 50 Hz mains; latched gate, so no second timer.
+  uint8_t err = PhaseControl1.begin(zcd, PIN_PA3, 50);
+  if (err) {
+    Serial.print("PhaseControl1.begin() failed: ");
+    Serial.println(err);
+  }
+}
+
+void loop() {
+  static uint8_t lastLevel = 0;
+  uint8_t level = analogRead(PIN_PD3) >> 2;
+  if (level != lastLevel) {
+    lastLevel = level;
+    PhaseControl1.setLevel(level);    // takes effect from the next half-cycle
+  }
+  delay(20);
+}
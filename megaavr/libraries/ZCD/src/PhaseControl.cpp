@@ -0,0 +1,191 @@
+/* PhaseControl.cpp - hardware-timed phase angle control (triac dimmers, SSRs) from a zero-cross detector.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ * PhaseControlN lives in PhaseControlN.cpp next to TCBn's ISR, so including PhaseControl.h for one channel doesn't
+ * claim the interrupt of every TCB on the part.
+ */
+#include "PhaseControl.h"
+
+static event::gen::generator_t zcdGenerator(ZeroCross &zcd) {
+  #if defined(ZCD3)
+    (void) zcd;
+    return event::gen::zcd3_out;
+  #else
+    #if defined(ZCD2_ZCD_vect)
+      if (&zcd == &zcd2) {
+        return event::gen::zcd2_out;
+      }
+    #endif
+    #if defined(ZCD1_ZCD_vect)
+      if (&zcd == &zcd1) {
+        return event::gen::zcd1_out;
+      }
+    #endif
+    (void) zcd;
+    return event::gen::zcd0_out;
+  #endif
+}
+
+uint8_t PhaseControl::begin(ZeroCross &zcd, uint8_t gatePin, uint8_t mainsFrequency, TCB_t *pulseTimer, uint16_t pulseWidth) {
+  if (digitalPinToPort(gatePin) == NOT_A_PIN || mainsFrequency < 8 || _isMillisTCB(&_timer) ||
+      (pulseTimer != NULL && (pulseTimer == &_timer || _isMillisTCB(pulseTimer)))) {
+    return PHASE_BAD_ARGUMENT;
+  }
+  uint16_t halfCycle = 500000UL / mainsFrequency;
+  // A whole half-cycle has to fit in the 16-bit counter: CLK_PER/2 if it can, otherwise TCA0's prescaled clock.
+  uint8_t  clksel    = TCB_CLKSEL_DIV2_gc;
+  uint32_t perMs     = getCPUFrequency() / 2000UL;
+  if (perMs * halfCycle / 1000 > 0xFFFF) {
+    uint8_t tca = TCA0.SINGLE.CTRLA;
+    perMs  = (getCPUFrequency() / 1000UL) >> _tcaPrescaleShift(tca);
+    clksel = TCB_CLKSEL_TCA0_gc;
+    if (!(tca & TCA_SINGLE_ENABLE_bm) || perMs * halfCycle / 1000 > 0xFFFF) {
+      return PHASE_BAD_ARGUMENT;
+    }
+  }
+  end();
+  Event &zc = Event::assign_generator(zcdGenerator(zcd));
+  _channel[0] = zc.get_channel_number();
+  Event *fire = NULL;
+  if (pulseTimer != NULL) {
+    fire = &Event::assign_generator(Event::gen_from_peripheral(_timer, 0));
+    _channel[1] = fire->get_channel_number();
+  }
+  if (_channel[0] == 255 || (pulseTimer != NULL && _channel[1] == 255)) {
+    _release();
+    return PHASE_NO_CHANNEL;
+  }
+  _gatePin    = gatePin;
+  _pulseTimer = pulseTimer;
+  _ticksPerMs = perMs;
+  _maxDelay   = halfCycle - halfCycle / 16;     // leave the gate time to act before the next zero crossing
+  _update     = 0;
+
+  _timer.CTRLA    = 0;
+  _timer.EVCTRL   = 0;                          // off until setDelay()
+  _timer.CCMP     = 0xFFFF;
+  _timer.INTFLAGS = TCB_CAPT_bm | TCB_OVF_bm;
+  _timer.INTCTRL  = TCB_CAPT_bm;
+  if (pulseTimer == NULL) {
+    // The TCB's output is high from the zero crossing until the firing delay is up, then low. Inverted, that's the
+    // gate, on from the firing angle to the next crossing; CCMPINIT keeps it off until the first one.
+    _timer.CTRLB  = TCB_CNTMODE_SINGLE_gc | TCB_CCMPEN_bm | TCB_CCMPINIT_bm;
+    *getPINnCTRLregister(digitalPinToPortStruct(gatePin), digitalPinToBitPosition(gatePin)) |= PORT_INVEN_bm;
+  } else {
+    _timer.CTRLB  = TCB_CNTMODE_SINGLE_gc;
+    uint32_t width = (getCPUFrequency() / 2000UL) * pulseWidth / 1000;
+    pulseTimer->CTRLA    = 0;
+    pulseTimer->CTRLB    = TCB_CNTMODE_SINGLE_gc | TCB_CCMPEN_bm;
+    pulseTimer->EVCTRL   = TCB_CAPTEI_bm;       // started by the rising edge of the delay timer's CAPT event
+    pulseTimer->CCMP     = (width > 0xFFFF) ? 0xFFFF : (width ? width : 1);
+    pulseTimer->INTCTRL  = 0;
+    fire->set_user(Event::user_from_peripheral(*pulseTimer, 0));
+    fire->start();
+    pulseTimer->CTRLA    = TCB_CLKSEL_DIV2_gc | TCB_ENABLE_bm;
+  }
+  pinMode(gatePin, OUTPUT);
+  zc.set_user(Event::user_from_peripheral(_timer, 0));
+  zc.start();
+  _timer.CTRLA    = clksel | TCB_ENABLE_bm;
+  return PHASE_OK;
+}
+
+void PhaseControl::end() {
+  if (_gatePin == NOT_A_PIN) {
+    return;
+  }
+  _timer.CTRLA   = 0;
+  _timer.INTCTRL = 0;
+  _timer.EVCTRL  = 0;
+  _timer.CTRLB   = 0;
+  Event::clear_user(Event::user_from_peripheral(_timer, 0));
+  if (_pulseTimer != NULL) {
+    _pulseTimer->CTRLA  = 0;
+    _pulseTimer->EVCTRL = 0;
+    _pulseTimer->CTRLB  = 0;
+    Event::clear_user(Event::user_from_peripheral(*_pulseTimer, 0));
+    _pulseTimer = NULL;
+  } else {
+    *getPINnCTRLregister(digitalPinToPortStruct(_gatePin), digitalPinToBitPosition(_gatePin)) &= ~PORT_INVEN_bm;
+  }
+  digitalWrite(_gatePin, LOW);
+  _release();
+  _gatePin = NOT_A_PIN;
+}
+
+void PhaseControl::_release() {
+  for (uint8_t i = 0; i < 2; i++) {
+    if (_channel[i] != 255) {
+      Event &ch = Event::get_channel(_channel[i]);
+      ch.stop();
+      ch.set_generator(event::gen::disable);
+      _channel[i] = 255;
+    }
+  }
+}
+
+void PhaseControl::setDelay(uint16_t microseconds) {
+  if (_gatePin == NOT_A_PIN) {
+    return;
+  }
+  if (microseconds > _maxDelay) {
+    off();
+    return;
+  }
+  uint16_t ticks = (uint32_t) _ticksPerMs * microseconds / 1000;
+  if (ticks < 16) {
+    ticks = 16;     // so that a zero crossing that starts the timer while we write CCMP can't leave it behind CNT
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  if ((_timer.EVCTRL & TCB_CAPTEI_bm) && (_timer.STATUS & TCB_RUN_bm)) {
+    // Part way through a delay - CCMP is not buffered, so moving it now could fire twice or not at all in this
+    // half-cycle. The interrupt at the end of this delay will put it in.
+    _pending = ticks;
+    _update  = 1;
+  } else {
+    // Stopped, between firing and the next zero crossing, or off: this takes effect from the next crossing.
+    _timer.CCMP   = ticks;
+    _update       = 0;
+    _timer.EVCTRL = TCB_CAPTEI_bm | TCB_EDGE_bm;   // either edge: both zero crossings of each cycle
+  }
+  SREG = oldSREG;
+}
+
+void PhaseControl::setLevel(uint8_t level) {
+  if (level == 0) {
+    off();
+  } else {
+    setDelay((uint32_t) (255 - level) * _maxDelay / 255);
+  }
+}
+
+void PhaseControl::off() {
+  if (_gatePin == NOT_A_PIN) {
+    return;
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  _timer.EVCTRL = 0;
+  _update       = 0;
+  if (_pulseTimer == NULL) {
+    // Once fired, the output stays low (gate on) until the timer is restarted; re-enabling it puts CCMPINIT back.
+    uint8_t ctrla = _timer.CTRLA;
+    _timer.CTRLA  = 0;
+    _timer.CNT    = 0;
+    _timer.CTRLA  = ctrla;
+  }
+  SREG = oldSREG;
+}
+
+uint16_t PhaseControl::maxDelay() {
+  return _maxDelay;
+}
+
+void PhaseControl::_service() {
+  _timer.INTFLAGS = TCB_CAPT_bm;
+  // Just fired, and stopped until the next zero crossing: the one moment CCMP can safely be changed.
+  if (_update) {
+    _timer.CCMP = _pending;
+    _update     = 0;
+  }
+}
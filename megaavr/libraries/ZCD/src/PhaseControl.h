@@ -0,0 +1,77 @@
+/* PhaseControl.h - hardware-timed phase angle control (triac dimmers, SSRs) from a zero-cross detector.
+ * Part of DxCore - this is free software, LGPL 2.1, see LICENSE.md
+ *
+ * Each zero crossing (either direction) is an event that starts a TCB in single-shot mode; when it reaches CCMP,
+ * which is the firing delay, the gate is switched on. Nothing is done in software per half-cycle except, when
+ * the delay has been changed, copying the new value into CCMP in the TCB interrupt at the moment of firing - CCMP
+ * is not buffered in hardware, and this way a change always takes effect at the start of a half-cycle, never in
+ * the middle of one.
+ *
+ * The gate is either:
+ *   latched - the TCB's own output pin, inverted, so it goes high at the firing angle and stays high until the next
+ *             zero crossing. One TCB per channel. Fine for SSRs and opto-triac drivers with a gate resistor.
+ *   pulse   - a second TCB, started by the first one's CAPT event, outputs a pulse of a fixed width on its pin.
+ *
+ * PhaseControlN times the delay with TCBn, which has its interrupt; the pulse timer is any other TCB, given to
+ * begin(), and runs without one. Neither can be the millis timer.
+ */
+#ifndef PHASECONTROL_H
+#define PHASECONTROL_H
+
+#include <Arduino.h>
+#include <Event.h>
+#include "ZCD.h"
+
+// begin() return values
+#define PHASE_OK                    0
+#define PHASE_BAD_ARGUMENT          1  // not a pin, a timer that is used for millis, or TCA0 is needed but not running
+#define PHASE_NO_CHANNEL            2  // out of event channels
+
+class PhaseControl {
+  public:
+    explicit PhaseControl(TCB_t &timer) : _timer(timer) {}
+    // Starts with the gate off. The ZCD must be set up and started separately. gatePin must be the output pin of
+    // the TCB that drives the gate (this one, or pulseTimer), as selected by PORTMUX.TCBROUTEA; it's made an output.
+    // With a pulseTimer, each firing is a pulse of pulseWidth microseconds on its pin; without, the gate is latched.
+    // mainsFrequency (50 or 60) sets the longest delay, and whether the TCB is clocked from CLK_PER/2 or, at
+    // higher clock speeds where that can't time a whole half-cycle, from TCA0's prescaled clock.
+    uint8_t  begin(ZeroCross &zcd, uint8_t gatePin, uint8_t mainsFrequency = 50, TCB_t *pulseTimer = NULL, uint16_t pulseWidth = 100);
+    void     end();
+    // The time from each zero crossing to firing, in microseconds, from the next half-cycle on. 0 fires as soon as
+    // possible, and anything over maxDelay() is off.
+    void     setDelay(uint16_t microseconds);
+    // 0 = off, 255 = fully on, linear in the delay (not in power).
+    void     setLevel(uint8_t level);
+    void     off();
+    uint16_t maxDelay();    // the longest delay that still fires in time, a little less than half a mains cycle
+
+    void     _service();    // called by the TCB interrupt
+  private:
+    void              _release();
+    TCB_t            &_timer;
+    TCB_t            *_pulseTimer = NULL;
+    uint8_t           _gatePin    = NOT_A_PIN;   // NOT_A_PIN = not started
+    uint8_t           _channel[2] = {255, 255};
+    uint16_t          _maxDelay   = 0;           // in microseconds
+    uint16_t          _ticksPerMs = 0;           // timer clocks per millisecond
+    volatile uint16_t _pending    = 0;           // CCMP for the next half-cycle
+    volatile uint8_t  _update     = 0;           // _pending needs to go into CCMP
+};
+
+#if defined(TCB0) && !defined(MILLIS_USE_TIMERB0)
+  extern PhaseControl PhaseControl0;
+#endif
+#if defined(TCB1) && !defined(MILLIS_USE_TIMERB1)
+  extern PhaseControl PhaseControl1;
+#endif
+#if defined(TCB2) && !defined(MILLIS_USE_TIMERB2)
+  extern PhaseControl PhaseControl2;
+#endif
+#if defined(TCB3) && !defined(MILLIS_USE_TIMERB3)
+  extern PhaseControl PhaseControl3;
+#endif
+#if defined(TCB4) && !defined(MILLIS_USE_TIMERB4)
+  extern PhaseControl PhaseControl4;
+#endif
+
+#endif
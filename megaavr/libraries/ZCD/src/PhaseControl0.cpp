@@ -0,0 +1,10 @@
+/* PhaseControl0.cpp - PhaseControl0, timed by TCB0, and TCB0's interrupt. */
+#include "PhaseControl.h"
+
+#if defined(TCB0) && !defined(MILLIS_USE_TIMERB0)
+  PhaseControl PhaseControl0(TCB0);
+
+  ISR(TCB0_INT_vect) {
+    PhaseControl0._service();
+  }
+#endif
@@ -0,0 +1,10 @@
+/* PhaseControl1.cpp - PhaseControl1, timed by TCB1, and TCB1's interrupt. */
+#include "PhaseControl.h"
+
+#if defined(TCB1) && !defined(MILLIS_USE_TIMERB1)
+  PhaseControl PhaseControl1(TCB1);
+
+  ISR(TCB1_INT_vect) {
+    PhaseControl1._service();
+  }
+#endif
@@ -0,0 +1,10 @@
+/* PhaseControl2.cpp - PhaseControl2, timed by TCB2, and TCB2's interrupt. */
+#include "PhaseControl.h"
+
+#if defined(TCB2) && !defined(MILLIS_USE_TIMERB2)
+  PhaseControl PhaseControl2(TCB2);
+
+  ISR(TCB2_INT_vect) {
+    PhaseControl2._service();
+  }
+#endif
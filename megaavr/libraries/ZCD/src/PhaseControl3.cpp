@@ -0,0 +1,10 @@
+/* PhaseControl3.cpp - PhaseControl3, timed by TCB3, and TCB3's interrupt. */
+#include "PhaseControl.h"
+
+#if defined(TCB3) && !defined(MILLIS_USE_TIMERB3)
+  PhaseControl PhaseControl3(TCB3);
+
+  ISR(TCB3_INT_vect) {
+    PhaseControl3._service();
+  }
+#endif
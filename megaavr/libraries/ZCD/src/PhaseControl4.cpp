@@ -0,0 +1,10 @@
+/* PhaseControl4.cpp - PhaseControl4, timed by TCB4, and TCB4's interrupt. */
+#include "PhaseControl.h"
+
+#if defined(TCB4) && !defined(MILLIS_USE_TIMERB4)
+  PhaseControl PhaseControl4(TCB4);
+
+  ISR(TCB4_INT_vect) {
+    PhaseControl4._service();
+  }
+#endif